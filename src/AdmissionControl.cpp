@@ -0,0 +1,111 @@
+#include <AdmissionControl.h>
+#include <atomic>
+
+/********************************************************************************
+*                             Admission control
+* ******************************************************************************/
+
+static const char BUSY_TEXT[] PROGMEM = "Busy, retry later";
+
+static std::atomic<uint32_t> admittedCount(0);
+static std::atomic<uint32_t> rejectedBusy(0);
+static std::atomic<uint32_t> rejectedLowHeap(0);
+static std::atomic<uint8_t>  inFlight(0);
+static std::atomic<uint8_t>  peakInFlight(0);
+
+// Requests admitted by their body handler, their final handler must not count them again
+static AsyncWebServerRequest* bodyAdmitted[MAX_INFLIGHT_REQUESTS];
+static portMUX_TYPE bodyAdmittedMux = portMUX_INITIALIZER_UNLOCKED;
+
+RTKBaseManager::admission_t RTKBaseManager::checkAdmission() {
+  if (inFlight.load() >= MAX_INFLIGHT_REQUESTS) return ADMIT_BUSY;
+  if (ESP.getFreeHeap() < MIN_FREE_HEAP || ESP.getMaxAllocHeap() < MIN_FREE_HEAP_BLOCK) return ADMIT_LOW_HEAP;
+  return ADMIT_OK;
+}
+
+static bool admittedByBody(AsyncWebServerRequest *request) {
+  for (uint8_t i = 0; i < MAX_INFLIGHT_REQUESTS; i++) {
+    if (bodyAdmitted[i] == request) return true;
+  }
+  return false;
+}
+
+// Count the request as in flight until its client disconnects, the check and
+// the increment are one step so concurrent requests cannot pass the limit together
+static RTKBaseManager::admission_t reserveSlot(AsyncWebServerRequest *request) {
+  RTKBaseManager::admission_t admission = RTKBaseManager::checkAdmission();
+  if (admission == RTKBaseManager::ADMIT_LOW_HEAP) {
+    rejectedLowHeap++;
+    return admission;
+  }
+  uint8_t running = inFlight.load();
+  do {
+    if (running >= MAX_INFLIGHT_REQUESTS) {
+      rejectedBusy++;
+      return RTKBaseManager::ADMIT_BUSY;
+    }
+  } while (!inFlight.compare_exchange_weak(running, running + 1));
+  running++;
+
+  uint8_t peak = peakInFlight.load();
+  while (running > peak && !peakInFlight.compare_exchange_weak(peak, running)) {}
+  admittedCount++;
+  // The server closes every connection after the response, so this is the end of the request
+  request->onDisconnect([request]() {
+    portENTER_CRITICAL(&bodyAdmittedMux);
+    for (uint8_t i = 0; i < MAX_INFLIGHT_REQUESTS; i++) {
+      if (bodyAdmitted[i] == request) bodyAdmitted[i] = nullptr;
+    }
+    portEXIT_CRITICAL(&bodyAdmittedMux);
+    inFlight--;
+  });
+  return RTKBaseManager::ADMIT_OK;
+}
+
+bool RTKBaseManager::admitBody(AsyncWebServerRequest *request) {
+  if (reserveSlot(request) != ADMIT_OK) return false;
+  // A free entry exists, the table has one per slot and this request holds one
+  portENTER_CRITICAL(&bodyAdmittedMux);
+  for (uint8_t i = 0; i < MAX_INFLIGHT_REQUESTS; i++) {
+    if (bodyAdmitted[i] == nullptr) {
+      bodyAdmitted[i] = request;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&bodyAdmittedMux);
+  return true;
+}
+
+bool RTKBaseManager::admitRequest(AsyncWebServerRequest *request) {
+  portENTER_CRITICAL(&bodyAdmittedMux);
+  bool admitted = admittedByBody(request);
+  portEXIT_CRITICAL(&bodyAdmittedMux);
+  if (admitted) return true;
+
+  if (reserveSlot(request) != ADMIT_OK) {
+    sendBusy(request);
+    return false;
+  }
+  return true;
+}
+
+void RTKBaseManager::sendBusy(AsyncWebServerRequest *request) {
+  // PROGMEM body, no String copy of the content
+  AsyncWebServerResponse* response = request->beginResponse_P(503, "text/plain", (const uint8_t*)BUSY_TEXT, strlen(BUSY_TEXT));
+  response->addHeader("Retry-After", RETRY_AFTER_S);
+  request->send(response);
+}
+
+ArRequestHandlerFunction RTKBaseManager::admitted(ArRequestHandlerFunction handler) {
+  return [handler](AsyncWebServerRequest *request) {
+    if (admitRequest(request)) handler(request);
+  };
+}
+
+void RTKBaseManager::getAdmissionStats(admission_stats_t* stats) {
+  stats->admitted = admittedCount.load();
+  stats->rejectedBusy = rejectedBusy.load();
+  stats->rejectedLowHeap = rejectedLowHeap.load();
+  stats->inFlight = inFlight.load();
+  stats->peakInFlight = peakInFlight.load();
+}
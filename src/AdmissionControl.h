@@ -0,0 +1,86 @@
+/**
+ * @file    AdmissionControl.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Admission control of the web server. A request is only handled if
+ *          fewer than MAX_INFLIGHT_REQUESTS are running and the heap has room
+ *          (MIN_FREE_HEAP, MIN_FREE_HEAP_BLOCK), otherwise it is answered with an
+ *          early 503 and Retry-After, before any response or String is built.
+ */
+
+#ifndef ADMISSION_CONTROL_H
+#define ADMISSION_CONTROL_H
+
+#include <Arduino.h>
+#include <ManagerConfig.h>
+#include <ESPAsyncWebServer.h>
+
+namespace RTKBaseManager {
+
+typedef enum {
+  ADMIT_OK,
+  ADMIT_BUSY,       // too many requests in flight
+  ADMIT_LOW_HEAP    // free heap or largest free block below threshold
+} admission_t;
+
+typedef struct {
+  uint32_t admitted;
+  uint32_t rejectedBusy;
+  uint32_t rejectedLowHeap;
+  uint8_t  inFlight;
+  uint8_t  peakInFlight;
+} admission_stats_t;
+
+  /**
+   * @brief Check the limits without admitting, e.g. before allocating
+   *        in a body handler
+   *
+   * @return admission_t ADMIT_OK if a request would be admitted
+   */
+  admission_t checkAdmission(void);
+
+  /**
+   * @brief Admit a request or answer it with 503 and Retry-After. An admitted
+   *        request counts as in flight until its client disconnects.
+   *
+   * @param request Request
+   * @return true   If the request was admitted and must be handled
+   * @return false  If the request was already answered with 503
+   */
+  bool admitRequest(AsyncWebServerRequest *request);
+
+  /**
+   * @brief Admit a request from its body handler, before allocating for the
+   *        body. The slot is held until the client disconnects, admitRequest()
+   *        of the final handler then admits it without counting it again.
+   * @param request Request
+   * @return true   If the request was admitted
+   * @return false  If not, the final handler answers it with 503
+   */
+  bool admitBody(AsyncWebServerRequest *request);
+
+  /**
+   * @brief Answer a request with 503 and Retry-After
+   *
+   * @param request Request
+   */
+  void sendBusy(AsyncWebServerRequest *request);
+
+  /**
+   * @brief Wrap a handler with admitRequest()
+   *
+   * @param handler Handler of admitted requests
+   * @return ArRequestHandlerFunction Handler to register at the server
+   */
+  ArRequestHandlerFunction admitted(ArRequestHandlerFunction handler);
+
+  /**
+   * @brief Get the admission counters
+   *
+   * @param stats Address of the struct to write to
+   */
+  void getAdmissionStats(admission_stats_t* stats);
+}
+
+#endif /*** ADMISSION_CONTROL_H ***/
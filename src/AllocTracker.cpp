@@ -0,0 +1,158 @@
+#include <AllocTracker.h>
+#include <atomic>
+#include <esp_timer.h>
+
+/********************************************************************************
+*                             Allocation tracking
+* ******************************************************************************/
+
+static std::atomic<uint32_t> allocCount(0);
+static std::atomic<uint32_t> freeCount(0);
+static std::atomic<uint32_t> allocBytes(0);
+static std::atomic<uint32_t> allocFailed(0);
+
+// Per request counters, only the task set in accountingTask adds to them
+static TaskHandle_t volatile accountingTask = nullptr;
+static volatile uint32_t requestAllocs = 0;
+static volatile uint32_t requestFrees = 0;
+static volatile uint32_t requestBytes = 0;
+
+static inline bool accountingActive() {
+  return accountingTask != nullptr && accountingTask == xTaskGetCurrentTaskHandle();
+}
+
+#ifdef RTK_ALLOC_TRACKING
+extern "C" {
+  void* __real_malloc(size_t size);
+  void* __real_calloc(size_t n, size_t size);
+  void* __real_realloc(void* ptr, size_t size);
+  void  __real_free(void* ptr);
+
+  static void* countAlloc(void* ptr, size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    if (ptr == nullptr && size > 0) allocFailed.fetch_add(1, std::memory_order_relaxed);
+    if (accountingActive()) {
+      requestAllocs++;
+      requestBytes += size;
+    }
+    return ptr;
+  }
+
+  void* __wrap_malloc(size_t size) {
+    return countAlloc(__real_malloc(size), size);
+  }
+
+  void* __wrap_calloc(size_t n, size_t size) {
+    return countAlloc(__real_calloc(n, size), n * size);
+  }
+
+  void* __wrap_realloc(void* ptr, size_t size) {
+    return countAlloc(__real_realloc(ptr, size), size);
+  }
+
+  void __wrap_free(void* ptr) {
+    if (ptr != nullptr) {
+      freeCount.fetch_add(1, std::memory_order_relaxed);
+      if (accountingActive()) requestFrees++;
+    }
+    __real_free(ptr);
+  }
+}
+#endif
+
+bool RTKBaseManager::allocTrackingEnabled() {
+#ifdef RTK_ALLOC_TRACKING
+  return true;
+#else
+  return false;
+#endif
+}
+
+void RTKBaseManager::getAllocStats(alloc_stats_t* stats) {
+  stats->allocs = allocCount.load();
+  stats->frees = freeCount.load();
+  stats->bytes = allocBytes.load();
+  stats->failed = allocFailed.load();
+}
+
+/********************************************************************************
+*                             Request accounting
+* ******************************************************************************/
+
+// Written and read on the async_tcp task only, like all handlers
+static RTKBaseManager::request_alloc_t requestRing[RTKBaseManager::REQUEST_HISTORY_LEN];
+static uint8_t requestHead = 0;     // next record to use
+static uint8_t requestCount = 0;
+static RTKBaseManager::request_alloc_t* currentRecord = nullptr;
+static uint32_t accountingStartUs = 0;
+
+static RTKBaseManager::request_alloc_t* openRecord(AsyncWebServerRequest *request) {
+  for (uint8_t i = 0; i < requestCount; i++) {
+    if (requestRing[i].request == request) return &requestRing[i];
+  }
+  return nullptr;
+}
+
+void RTKBaseManager::beginRequestAccounting(AsyncWebServerRequest *request, bool first) {
+  request_alloc_t* record = first ? nullptr : openRecord(request);
+  if (record == nullptr) {
+    // A body without request handler call leaves its record open, close it here
+    request_alloc_t* stale = openRecord(request);
+    if (stale != nullptr) stale->request = nullptr;
+
+    record = &requestRing[requestHead];
+    requestHead = (requestHead + 1) % REQUEST_HISTORY_LEN;
+    if (requestCount < REQUEST_HISTORY_LEN) requestCount++;
+    memset(record, 0, sizeof(request_alloc_t));
+    record->request = request;
+    // The url ends up in JSON strings
+    const char* url = request->url().c_str();
+    for (uint8_t i = 0; i < REQUEST_URL_MAX_LEN && url[i] != '\0'; i++) {
+      record->url[i] = (url[i] < 0x20 || url[i] == '"' || url[i] == '\\') ? '_' : url[i];
+    }
+  }
+
+  currentRecord = record;
+  requestAllocs = 0;
+  requestFrees = 0;
+  requestBytes = 0;
+  accountingStartUs = (uint32_t)esp_timer_get_time();
+  accountingTask = xTaskGetCurrentTaskHandle();
+}
+
+void RTKBaseManager::endRequestAccounting(bool last) {
+  accountingTask = nullptr;
+  if (currentRecord == nullptr) return;
+
+  currentRecord->allocs += requestAllocs;
+  currentRecord->frees += requestFrees;
+  currentRecord->bytes += requestBytes;
+  currentRecord->handlerUs += (uint32_t)esp_timer_get_time() - accountingStartUs;
+  if (last) currentRecord->request = nullptr;
+  currentRecord = nullptr;
+}
+
+ArRequestHandlerFunction RTKBaseManager::accounted(ArRequestHandlerFunction handler) {
+  return [handler](AsyncWebServerRequest *request) {
+    beginRequestAccounting(request, false);
+    handler(request);
+    endRequestAccounting(true);
+  };
+}
+
+ArBodyHandlerFunction RTKBaseManager::accountedBody(ArBodyHandlerFunction handler) {
+  return [handler](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    beginRequestAccounting(request, index == 0);
+    handler(request, data, len, index, total);
+    endRequestAccounting(false);
+  };
+}
+
+uint8_t RTKBaseManager::getRequestAllocs(request_alloc_t* records) {
+  for (uint8_t i = 0; i < requestCount; i++) {
+    uint8_t idx = (requestHead + REQUEST_HISTORY_LEN - 1 - i) % REQUEST_HISTORY_LEN;
+    memcpy(&records[i], &requestRing[idx], sizeof(request_alloc_t));
+  }
+  return requestCount;
+}
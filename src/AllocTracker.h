@@ -0,0 +1,97 @@
+/**
+ * @file    AllocTracker.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Counts heap allocations of the whole firmware by wrapping malloc and
+ *          friends at link time. Only active if built with RTK_ALLOC_TRACKING and
+ *          the matching -Wl,--wrap flags, see the profiling env in platformio.ini.
+ *          Allocations of the web server handlers are also attributed to the
+ *          request they run for, the last requests are kept in a small ring.
+ */
+
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+namespace RTKBaseManager {
+
+typedef struct {
+  uint32_t allocs;    // malloc, calloc and realloc calls
+  uint32_t frees;     // free calls with a non null pointer
+  uint32_t bytes;     // requested bytes of all allocations
+  uint32_t failed;    // allocations which returned null
+} alloc_stats_t;
+
+  const uint8_t REQUEST_HISTORY_LEN = 8;
+  const uint8_t REQUEST_URL_MAX_LEN = 23;
+
+typedef struct {
+  const void* request;                      // identity while the request is open, never dereferenced
+  char        url[REQUEST_URL_MAX_LEN + 1];
+  uint32_t    allocs;                       // allocations of the handlers of this request
+  uint32_t    frees;
+  uint32_t    bytes;
+  uint32_t    handlerUs;                    // time spent in the handlers
+} request_alloc_t;
+
+  /**
+   * @brief Check if the allocation counters are compiled in
+   *
+   * @return true If built with RTK_ALLOC_TRACKING
+   */
+  bool allocTrackingEnabled(void);
+
+  /**
+   * @brief Get the allocation counters since boot
+   *
+   * @param stats Address of the struct to write to
+   */
+  void getAllocStats(alloc_stats_t* stats);
+
+  /**
+   * @brief Attribute the allocations of the calling task to a request until
+   *        endRequestAccounting(). Calls for the same open request add up.
+   *
+   * @param request Request
+   * @param first   true to always start a new record, e.g. for the first body chunk
+   */
+  void beginRequestAccounting(AsyncWebServerRequest *request, bool first);
+
+  /**
+   * @brief Stop attributing allocations to the current request
+   *
+   * @param last true if no handler runs for this request anymore
+   */
+  void endRequestAccounting(bool last);
+
+  /**
+   * @brief Wrap a request handler with allocation accounting, the response
+   *        sent from the handler is included, later chunks are not
+   *
+   * @param handler                   Handler
+   * @return ArRequestHandlerFunction Accounted handler
+   */
+  ArRequestHandlerFunction accounted(ArRequestHandlerFunction handler);
+
+  /**
+   * @brief Wrap a body handler with allocation accounting, the chunks add up
+   *        in the record of the request handler
+   *
+   * @param handler                 Body handler
+   * @return ArBodyHandlerFunction  Accounted body handler
+   */
+  ArBodyHandlerFunction accountedBody(ArBodyHandlerFunction handler);
+
+  /**
+   * @brief Copy the records of the last requests, newest first
+   *
+   * @param records Array of at least REQUEST_HISTORY_LEN records
+   * @return uint8_t Number of records copied
+   */
+  uint8_t getRequestAllocs(request_alloc_t* records);
+}
+
+#endif /*** ALLOC_TRACKER_H ***/
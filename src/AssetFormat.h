@@ -0,0 +1,54 @@
+/**
+ * @file    AssetFormat.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Layout of the asset bundle in the assets partition, shared by the
+ *          firmware and the host bundler in tools/assets. Plain C types only.
+ *          All numbers are little endian, like the ESP32.
+ *
+ *          header | entries[count] | data of all assets
+ *
+ *          Every asset is followed by a zero byte which is not part of its
+ *          length, so HTML templates can be used as C strings in place.
+ */
+
+#ifndef ASSET_FORMAT_H
+#define ASSET_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ASSET_BUNDLE_MAGIC      0x414B5452u   // "RTKA"
+#define ASSET_BUNDLE_VERSION    1
+#define ASSET_NAME_MAX_LEN      23
+#define ASSET_MAX_COUNT         32
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t count;           // number of entries
+  uint32_t size;            // of the whole bundle in bytes
+} asset_bundle_header_t;
+
+typedef struct {
+  char     name[ASSET_NAME_MAX_LEN + 1];   // zero terminated, e.g. "index.html"
+  uint32_t offset;                          // from the start of the bundle
+  uint32_t length;                          // without the trailing zero byte
+  uint32_t hash;                            // assetHash() of the data
+} asset_entry_t;
+
+/**
+ * @brief FNV-1a of the asset data
+ *
+ * @param data      Data
+ * @param len       Length
+ * @return uint32_t Hash
+ */
+inline uint32_t assetHash(const uint8_t* data, size_t len) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++) hash = (hash ^ data[i]) * 16777619u;
+  return hash;
+}
+
+#endif /*** ASSET_FORMAT_H ***/
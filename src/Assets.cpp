@@ -0,0 +1,129 @@
+#include <Assets.h>
+#include <esp_partition.h>
+
+/********************************************************************************
+*                             Asset bundle
+* ******************************************************************************/
+
+static const uint8_t* bundle = nullptr;
+static uint16_t assetCount = 0;
+static spi_flash_mmap_handle_t bundleHandle;
+
+static const asset_entry_t* bundleEntries() {
+  return (const asset_entry_t*)(bundle + sizeof(asset_bundle_header_t));
+}
+
+static bool checkBundle(const uint8_t* base, const asset_bundle_header_t* header) {
+  const asset_entry_t* entries = (const asset_entry_t*)(base + sizeof(asset_bundle_header_t));
+  size_t dataStart = sizeof(asset_bundle_header_t) + header->count * sizeof(asset_entry_t);
+
+  for (uint16_t i = 0; i < header->count; i++) {
+    const asset_entry_t& entry = entries[i];
+    if (memchr(entry.name, '\0', sizeof(entry.name)) == nullptr) return false;
+    if (entry.offset < dataStart || entry.length >= header->size || entry.offset > header->size - entry.length - 1) return false;
+    if (base[entry.offset + entry.length] != '\0') return false;
+    // Once at boot, a half written bundle must not end up in a page
+    if (assetHash(base + entry.offset, entry.length) != entry.hash) return false;
+  }
+  return true;
+}
+
+bool RTKBaseManager::mountAssets() {
+  if (bundle != nullptr) return true;
+
+  const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, ASSETS_PARTITION_LABEL);
+  if (partition == nullptr) {
+    DEBUG_SERIAL.println(F("No assets partition, using the built in pages"));
+    return false;
+  }
+
+  asset_bundle_header_t header;
+  if (esp_partition_read(partition, 0, &header, sizeof(header)) != ESP_OK ||
+      header.magic != ASSET_BUNDLE_MAGIC || header.version != ASSET_BUNDLE_VERSION ||
+      header.count > ASSET_MAX_COUNT || header.size > partition->size ||
+      header.size < sizeof(header) + header.count * sizeof(asset_entry_t)) {
+    DEBUG_SERIAL.println(F("No valid asset bundle, using the built in pages"));
+    return false;
+  }
+
+  // Read only mapping through the flash cache, the data is never copied to RAM
+  const void* mapped = nullptr;
+  if (esp_partition_mmap(partition, 0, header.size, SPI_FLASH_MMAP_DATA, &mapped, &bundleHandle) != ESP_OK) {
+    DEBUG_SERIAL.println(F("Mapping the assets partition failed, using the built in pages"));
+    return false;
+  }
+  if (!checkBundle((const uint8_t*)mapped, &header)) {
+    spi_flash_munmap(bundleHandle);
+    DEBUG_SERIAL.println(F("Asset bundle damaged, using the built in pages"));
+    return false;
+  }
+
+  bundle = (const uint8_t*)mapped;
+  assetCount = header.count;
+  DEBUG_SERIAL.printf("Asset bundle mapped, %u assets, %u bytes\r\n", assetCount, header.size);
+  return true;
+}
+
+bool RTKBaseManager::assetsMounted() {
+  return bundle != nullptr;
+}
+
+static const asset_entry_t* findEntry(const char* name) {
+  if (bundle == nullptr) return nullptr;
+  const asset_entry_t* entries = bundleEntries();
+  for (uint16_t i = 0; i < assetCount; i++) {
+    if (strcmp(entries[i].name, name) == 0) return &entries[i];
+  }
+  return nullptr;
+}
+
+bool RTKBaseManager::findAsset(const char* name, asset_t* asset) {
+  const asset_entry_t* entry = findEntry(name);
+  if (entry == nullptr) return false;
+  asset->data = bundle + entry->offset;
+  asset->len = entry->length;
+  return true;
+}
+
+const char* RTKBaseManager::assetPage(const char* name, const char* fallback) {
+  asset_t asset;
+  return findAsset(name, &asset) ? (const char*)asset.data : fallback;
+}
+
+static const char* contentTypeOf(const char* name) {
+  const char* ext = strrchr(name, '.');
+  if (ext == nullptr) return "application/octet-stream";
+  if (strcmp(ext, ".html") == 0) return "text/html";
+  if (strcmp(ext, ".css") == 0)  return "text/css";
+  if (strcmp(ext, ".js") == 0)   return "application/javascript";
+  if (strcmp(ext, ".json") == 0) return "application/json";
+  if (strcmp(ext, ".svg") == 0)  return "image/svg+xml";
+  if (strcmp(ext, ".png") == 0)  return "image/png";
+  if (strcmp(ext, ".ico") == 0)  return "image/x-icon";
+  return "application/octet-stream";
+}
+
+void RTKBaseManager::actionAsset(AsyncWebServerRequest *request) {
+  const char* name = request->url().c_str() + strlen("/assets/");
+  const asset_entry_t* entry = (request->url().length() > strlen("/assets/")) ? findEntry(name) : nullptr;
+  if (entry == nullptr) {
+    request->send(404, "text/plain", "Not found");
+    return;
+  }
+
+  // The bundle hash is a strong validator, unchanged assets are not sent again
+  char etag[11];
+  snprintf(etag, sizeof(etag), "\"%08x\"", (unsigned int)entry->hash);
+  AsyncWebHeader* match = request->getHeader("If-None-Match");
+  if (match != nullptr && match->value().equals(etag)) {
+    AsyncWebServerResponse* response = request->beginResponse(304);
+    response->addHeader("ETag", etag);
+    request->send(response);
+    return;
+  }
+
+  // Streamed from the mapped flash into the TCP buffers, no heap copy
+  AsyncWebServerResponse* response = request->beginResponse_P(200, contentTypeOf(entry->name), bundle + entry->offset, entry->length);
+  response->addHeader("ETag", etag);
+  request->send(response);
+}
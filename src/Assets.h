@@ -0,0 +1,74 @@
+/**
+ * @file    Assets.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Web assets from the "assets" data partition, mapped read only into
+ *          the address space and served from flash without a heap copy. The
+ *          pages can be flashed without a new firmware, see tools/assets.
+ *          Without a valid bundle the pages compiled into the firmware are used.
+ */
+
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <AssetFormat.h>
+#include <ManagerConfig.h>
+
+namespace RTKBaseManager {
+  constexpr char ASSETS_PARTITION_LABEL[] PROGMEM = "assets";
+  constexpr char ASSET_INDEX[] PROGMEM = "index.html";
+  constexpr char ASSET_REBOOT[] PROGMEM = "reboot.html";
+  constexpr char ASSET_ERROR[] PROGMEM = "error.html";
+
+typedef struct {
+  const uint8_t* data;      // mapped flash, zero terminated
+  size_t         len;
+} asset_t;
+
+  /**
+   * @brief Map the assets partition and check the index and the hashes of
+   *        the bundle, call once before the web server starts
+   *
+   * @return true   If a valid bundle is mapped
+   * @return false  If the partition is missing or the bundle is invalid
+   */
+  bool mountAssets(void);
+
+  /**
+   * @brief Check if a bundle is mapped
+   *
+   * @return true If assets come from the partition
+   */
+  bool assetsMounted(void);
+
+  /**
+   * @brief Find an asset of the bundle
+   *
+   * @param name    Asset name, e.g. ASSET_INDEX
+   * @param asset   Address to write the mapped data to
+   * @return true   If found
+   * @return false  If no bundle is mapped or it has no such asset
+   */
+  bool findAsset(const char* name, asset_t* asset);
+
+  /**
+   * @brief Get a page as C string, from the bundle or the firmware
+   *
+   * @param name          Asset name
+   * @param fallback      Page compiled into the firmware
+   * @return const char*  Mapped asset or the fallback
+   */
+  const char* assetPage(const char* name, const char* fallback);
+
+  /**
+   * @brief Handler of /assets/<name>, sends the asset straight from flash
+   *
+   * @param request Request
+   */
+  void actionAsset(AsyncWebServerRequest *request);
+}
+
+#endif /*** ASSETS_H ***/
@@ -0,0 +1,40 @@
+/**
+ * @file    BenchmarkBaseline.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Checked in baseline of the benchmarks in BenchmarksRTKBaseManager.h,
+ *          for a Feather ESP32 at 240 MHz, NVS storage backend, DEBUGGING false.
+ *          A benchmark fails if it is slower than BENCH_TIME_TOLERANCE times its
+ *          baseline or needs more allocations per operation than its baseline.
+ * <br>
+ * @note    The numbers are estimates until a run on the board replaces them
+ *          with its "BENCH" lines, a miss prints the measured value next to
+ *          the baseline. Update them whenever a change makes an operation
+ *          faster on purpose.
+ */
+
+#ifndef BENCHMARK_BASELINE_H
+#define BENCHMARK_BASELINE_H
+
+#include <Arduino.h>
+
+typedef struct {
+  uint32_t usPerOp;       // mean time per operation in us
+  float    allocsPerOp;   // mean heap allocations per operation
+} bench_baseline_t;
+
+const float BENCH_TIME_TOLERANCE = 1.25;
+
+const bench_baseline_t BASELINE_GET_DECONSTRUCTED_VAL_AS_CSV  = {   60,  14.0 };
+const bench_baseline_t BASELINE_GET_DOUBLE_STRING_FROM_CSV    = {   40,   6.0 };
+const bench_baseline_t BASELINE_GET_VALUE_AS_STRING_FROM_CSV  = {    8,   2.0 };
+const bench_baseline_t BASELINE_GET_INT_LOCATION_FROM_STORAGE = {  300,   0.0 };
+const bench_baseline_t BASELINE_PROCESSOR_INDEX_RENDER        = { 2500,  60.0 };
+
+// Storage backends, indexed by STORAGE_SPIFFS, STORAGE_LITTLEFS and STORAGE_NVS
+const bench_baseline_t BASELINE_STORAGE_WRITE[]  = { { 9000,   6.0 }, { 6000,   6.0 }, { 1500,   0.0 } };
+const bench_baseline_t BASELINE_STORAGE_READ[]   = { { 1500,   4.0 }, {  800,   4.0 }, {  100,   0.0 } };
+const bench_baseline_t BASELINE_STORAGE_LOOKUP[] = { { 1000,   2.0 }, {  400,   2.0 }, {   50,   0.0 } };
+
+#endif /*** BENCHMARK_BASELINE_H ***/
@@ -0,0 +1,179 @@
+#ifndef BENCHMARKS_RTK_BASE_MANAGER_H
+#define BENCHMARKS_RTK_BASE_MANAGER_H
+
+#include <AUnit.h>
+#include <RTKBaseManager.h>
+#include <AllocTracker.h>
+#include <Storage.h>
+#include <BenchmarkBaseline.h>
+
+using namespace aunit;
+using namespace RTKBaseManager;
+
+const uint16_t BENCH_ITERATIONS = 200;
+const uint16_t BENCH_FS_ITERATIONS = 20;
+const char BENCH_PATH[] = "/benchPath";
+const char BENCH_MISSING_PATH[] = "/benchMissing";
+
+typedef struct {
+  uint32_t usPerOp;
+  float    allocsPerOp;
+} bench_result_t;
+
+template <typename Op>
+bench_result_t runBench(const char* name, uint16_t iterations, Op op) {
+  alloc_stats_t before, after;
+  op(); // warm up, first storage access and lazy inits are not measured
+
+  getAllocStats(&before);
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < iterations; i++) op();
+  uint32_t elapsed = micros() - start;
+  getAllocStats(&after);
+
+  bench_result_t result;
+  result.usPerOp = elapsed / iterations;
+  result.allocsPerOp = (float)(after.allocs - before.allocs) / iterations;
+  // Parsable by tools, like the "BENCH" lines of the baseline
+  Serial.printf("BENCH %s us_per_op=%u allocs_per_op=%.2f\n", name, result.usPerOp,
+                allocTrackingEnabled() ? result.allocsPerOp : -1.0f);
+  return result;
+}
+
+// Expands the index page the way send_P() does, one processor() call per placeholder
+static size_t renderWithProcessor(const char* html) {
+  size_t len = 0;
+  const char* p = html;
+  while (*p) {
+    const char* start = strchr(p, '%');
+    if (start == nullptr) return len + strlen(p);
+    const char* end = strchr(start + 1, '%');
+    if (end == nullptr) return len + strlen(p);
+    len += start - p;
+    String name;
+    name.concat(start + 1, end - start - 1);
+    len += processor(name).length();
+    p = end + 1;
+  }
+  return len;
+}
+
+static bool withinBaseline(const bench_result_t& result, const bench_baseline_t& baseline) {
+  if (result.usPerOp > baseline.usPerOp * BENCH_TIME_TOLERANCE) return false;
+  return !allocTrackingEnabled() || result.allocsPerOp <= baseline.allocsPerOp;
+}
+
+// A miss shows what was measured against what was expected before it fails
+#define assertBench(result, baseline) \
+  do { \
+    if (!withinBaseline((result), (baseline))) { \
+      Serial.printf("BENCH over baseline: us_per_op=%u (baseline %u) allocs_per_op=%.2f (baseline %.2f)\n", \
+                    (unsigned int)(result).usPerOp, (unsigned int)(baseline).usPerOp, \
+                    (result).allocsPerOp, (baseline).allocsPerOp); \
+    } \
+    assertLessOrEqual((float)(result).usPerOp, (baseline).usPerOp * BENCH_TIME_TOLERANCE); \
+    if (allocTrackingEnabled()) assertLessOrEqual((result).allocsPerOp, (baseline).allocsPerOp); \
+  } while (false)
+
+test(bench_getDeconstructedValAsCSV) {
+  String input = "12.345678999";
+  bench_result_t result = runBench("getDeconstructedValAsCSV", BENCH_ITERATIONS, [&]() {
+    getDeconstructedValAsCSV(input);
+  });
+  assertBench(result, BASELINE_GET_DECONSTRUCTED_VAL_AS_CSV);
+}
+
+test(bench_getDoubleStringFromCSV) {
+  String input = "123456789,99";
+  bench_result_t result = runBench("getDoubleStringFromCSV", BENCH_ITERATIONS, [&]() {
+    getDoubleStringFromCSV(input);
+  });
+  assertBench(result, BASELINE_GET_DOUBLE_STRING_FROM_CSV);
+}
+
+test(bench_getValueAsStringFromCSV) {
+  String input = "123456789,99";
+  bench_result_t result = runBench("getValueAsStringFromCSV", BENCH_ITERATIONS, [&]() {
+    getValueAsStringFromCSV(input, SEP, HIGH_PREC_IDX);
+  });
+  assertBench(result, BASELINE_GET_VALUE_AS_STRING_FROM_CSV);
+}
+
+test(bench_getIntLocationFromStorage) {
+  location_int_t location;
+  writeStored(BENCH_PATH, "123456789,99");
+  bench_result_t result = runBench("getIntLocationFromStorage", BENCH_FS_ITERATIONS, [&]() {
+    getIntLocationFromStorage(&location, BENCH_PATH, BENCH_PATH, BENCH_PATH);
+  });
+  removeStored(BENCH_PATH);
+  assertBench(result, BASELINE_GET_INT_LOCATION_FROM_STORAGE);
+}
+
+// Formats every backend, the config is written back to the active one at the end
+test(bench_storageBackends) {
+  bench_result_t write[STORAGE_BACKEND_COUNT], read[STORAGE_BACKEND_COUNT], lookup[STORAGE_BACKEND_COUNT];
+  bool measured[STORAGE_BACKEND_COUNT] = { false };
+  config_snapshot_t saved;
+  char name[32];
+  char value[CONFIG_VALUE_MAX_LEN + 1];
+
+  readConfig(&saved);
+  activeStorage()->end();
+  for (uint8_t kind = 0; kind < STORAGE_BACKEND_COUNT; kind++) {
+    const storage_backend_t* backend = getStorageBackend(kind);
+    if (backend == nullptr || !backend->begin(true)) continue;
+    flash_stats_t before, after;
+    uint32_t n = 0;
+
+    snprintf(name, sizeof(name), "storageWrite_%s", backend->name);
+    getFlashStats(&before);
+    write[kind] = runBench(name, BENCH_FS_ITERATIONS, [&]() {
+      // Another value every time, NVS skips writes of an unchanged value
+      snprintf(value, sizeof(value), "%u,99", 123456789u + n++);
+      backend->write(BENCH_PATH, value);
+    });
+    getFlashStats(&after);
+    // Wear: the flash bytes written and erased per write, runBench() adds a warm up write
+    Serial.printf("BENCH %s flash_written_per_op=%.1f flash_erased_per_op=%.1f\n", name,
+                  (float)(after.bytesWritten - before.bytesWritten) / (BENCH_FS_ITERATIONS + 1),
+                  (float)(after.bytesErased - before.bytesErased) / (BENCH_FS_ITERATIONS + 1));
+
+    snprintf(name, sizeof(name), "storageRead_%s", backend->name);
+    read[kind] = runBench(name, BENCH_FS_ITERATIONS, [&]() {
+      backend->read(BENCH_PATH, value, sizeof(value));
+    });
+
+    // Open cost alone: the file system walk or key lookup of a missing value
+    snprintf(name, sizeof(name), "storageLookup_%s", backend->name);
+    lookup[kind] = runBench(name, BENCH_FS_ITERATIONS, [&]() {
+      backend->read(BENCH_MISSING_PATH, value, sizeof(value));
+    });
+
+    backend->wipe();
+    backend->end();
+    measured[kind] = true;
+  }
+
+  activeStorage()->begin(true);
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    if (PARAM_TABLE[i].check == CHECK_NONE || saved.values[i][0] == '\0') continue;
+    writeStored(PARAM_TABLE[i].path, saved.values[i]);
+  }
+  loadConfig();
+
+  for (uint8_t kind = 0; kind < STORAGE_BACKEND_COUNT; kind++) {
+    if (!measured[kind]) continue;
+    assertBench(write[kind], BASELINE_STORAGE_WRITE[kind]);
+    assertBench(read[kind], BASELINE_STORAGE_READ[kind]);
+    assertBench(lookup[kind], BASELINE_STORAGE_LOOKUP[kind]);
+  }
+}
+
+test(bench_processorIndexRender) {
+  bench_result_t result = runBench("processorIndexRender", BENCH_FS_ITERATIONS, []() {
+    renderWithProcessor(INDEX_HTML);
+  });
+  assertBench(result, BASELINE_PROCESSOR_INDEX_RENDER);
+}
+
+#endif /*** BENCHMARKS_RTK_BASE_MANAGER_H ***/
@@ -0,0 +1,192 @@
+#include <BootGuard.h>
+#include <AdmissionControl.h>
+#include <AllocTracker.h>
+#include <FlashBudget.h>
+#include <StatusApi.h>
+#include <WiFi.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <safe_mode_html.h>
+
+using RTKBaseManager::boot_entry_t;
+using RTKBaseManager::boot_stats_t;
+
+/********************************************************************************
+*                             Boot record
+* ******************************************************************************/
+
+static const uint32_t BOOT_MAGIC = 0x544F4F42;     // "BOOT"
+static const uint64_t HEARTBEAT_US = 1000000;
+
+typedef struct {
+  uint32_t     magic;
+  uint32_t     checksum;    // of everything behind it
+  uint32_t     boots;
+  uint8_t      failures;
+  uint8_t      count;
+  boot_entry_t history[RTKBaseManager::BOOT_HISTORY_LEN];
+} boot_record_t;
+
+// Not initialized at boot, valid after any reset but a power cycle if magic and checksum match
+RTC_NOINIT_ATTR static boot_record_t bootRecord;
+static portMUX_TYPE bootMux = portMUX_INITIALIZER_UNLOCKED;
+static bool safeMode = false;
+static esp_timer_handle_t heartbeatTimer = nullptr;
+
+static uint32_t recordChecksum(const boot_record_t* record) {
+  const uint8_t* data = (const uint8_t*)&record->boots;
+  size_t len = sizeof(boot_record_t) - offsetof(boot_record_t, boots);
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++) hash = (hash ^ data[i]) * 16777619u;
+  return hash;
+}
+
+// Under bootMux once the heartbeat runs
+static void sealRecord() {
+  bootRecord.checksum = recordChecksum(&bootRecord);
+}
+
+static const char* reasonName(uint8_t reason) {
+  switch (reason) {
+    case ESP_RST_POWERON:   return "power_on";
+    case ESP_RST_EXT:       return "external";
+    case ESP_RST_SW:        return "software";
+    case ESP_RST_PANIC:     return "panic";
+    case ESP_RST_INT_WDT:   return "interrupt_watchdog";
+    case ESP_RST_TASK_WDT:  return "task_watchdog";
+    case ESP_RST_WDT:       return "watchdog";
+    case ESP_RST_DEEPSLEEP: return "deep_sleep";
+    case ESP_RST_BROWNOUT:  return "brownout";
+    case ESP_RST_SDIO:      return "sdio";
+    default:                return "unknown";
+  }
+}
+
+// The run time of this boot, it is stable once it survived BOOT_STABLE_MS
+static void heartbeat(void* arg) {
+  portENTER_CRITICAL(&bootMux);
+  boot_entry_t* boot = &bootRecord.history[0];
+  boot->uptimeMs = millis();
+  if (!boot->stable && boot->uptimeMs >= BOOT_STABLE_MS) {
+    boot->stable = true;
+    bootRecord.failures = 0;
+  }
+  sealRecord();
+  portEXIT_CRITICAL(&bootMux);
+}
+
+bool RTKBaseManager::needsSafeMode(uint8_t failures, uint8_t reason) {
+  // A power cycle is the way out that needs no page
+  return failures >= BOOT_SAFE_MODE_FAILURES && reason != ESP_RST_POWERON;
+}
+
+bool RTKBaseManager::beginBoot() {
+  uint8_t reason = esp_reset_reason();
+  bool valid = bootRecord.magic == BOOT_MAGIC && bootRecord.count <= BOOT_HISTORY_LEN &&
+               bootRecord.checksum == recordChecksum(&bootRecord);
+  if (!valid) {
+    memset(&bootRecord, 0, sizeof(bootRecord));
+    bootRecord.magic = BOOT_MAGIC;
+  }
+  safeMode = needsSafeMode(bootRecord.failures, reason);
+
+  // Failed until the heartbeat finds it stable
+  if (bootRecord.failures < UINT8_MAX) bootRecord.failures++;
+  bootRecord.boots++;
+  memmove(&bootRecord.history[1], &bootRecord.history[0], (BOOT_HISTORY_LEN - 1) * sizeof(boot_entry_t));
+  memset(&bootRecord.history[0], 0, sizeof(boot_entry_t));
+  bootRecord.history[0].reason = reason;
+  bootRecord.history[0].safeMode = safeMode;
+  if (bootRecord.count < BOOT_HISTORY_LEN) bootRecord.count++;
+  sealRecord();
+
+  DEBUG_SERIAL.printf("Boot %u, reset reason %s, %u failed boots in a row%s\r\n", (unsigned int)bootRecord.boots, reasonName(reason),
+                      (unsigned int)(bootRecord.failures - 1), safeMode ? ", starting in safe mode" : "");
+
+  esp_timer_create_args_t args;
+  memset(&args, 0, sizeof(args));
+  args.callback = heartbeat;
+  args.name = "bootHeartbeat";
+  if (esp_timer_create(&args, &heartbeatTimer) == ESP_OK) esp_timer_start_periodic(heartbeatTimer, HEARTBEAT_US);
+  return safeMode;
+}
+
+void RTKBaseManager::endBootSetup() {
+  portENTER_CRITICAL(&bootMux);
+  bootRecord.history[0].setupMs = millis();
+  sealRecord();
+  portEXIT_CRITICAL(&bootMux);
+  DEBUG_SERIAL.printf("Setup done in %u ms\r\n", (unsigned int)bootRecord.history[0].setupMs);
+}
+
+void RTKBaseManager::clearBootFailures() {
+  portENTER_CRITICAL(&bootMux);
+  bootRecord.failures = 0;
+  sealRecord();
+  portEXIT_CRITICAL(&bootMux);
+}
+
+bool RTKBaseManager::inSafeMode() {
+  return safeMode;
+}
+
+void RTKBaseManager::getBootStats(boot_stats_t* stats) {
+  portENTER_CRITICAL(&bootMux);
+  stats->boots = bootRecord.boots;
+  stats->failures = bootRecord.failures;
+  stats->safeMode = safeMode;
+  stats->count = bootRecord.count;
+  memcpy(stats->history, bootRecord.history, sizeof(stats->history));
+  portEXIT_CRITICAL(&bootMux);
+}
+
+/********************************************************************************
+*                             Safe mode
+* ******************************************************************************/
+
+void RTKBaseManager::startSafeServer(AsyncWebServer *server) {
+  // The page and the actions to leave safe mode, nothing that needs the full config
+  server->on("/", HTTP_GET, accounted(admitted([](AsyncWebServerRequest *request) {
+    request->send_P(200, "text/html", SAFE_MODE_HTML);
+  })));
+  server->on("/actionUpdateData", HTTP_POST, accounted(admitted(actionUpdateData)), nullptr, accountedBody(actionUpdateDataBody));
+  server->on("/actionWipeData", HTTP_POST, accounted(admitted(actionWipeData)));
+  server->on("/actionRebootESP32", HTTP_POST, accounted(admitted(actionRebootESP32)));
+  server->on("/api/boot", HTTP_GET, accounted(admitted(actionBoot)));
+  server->onNotFound(accounted(admitted(notFound)));
+  server->begin();
+}
+
+void RTKBaseManager::checkSafeModeTimeout() {
+  if (!safeMode || millis() < BOOT_SAFE_MODE_TIMEOUT_MS || WiFi.softAPgetStationNum() > 0) return;
+  // Maybe the network is back, one more failed boot returns here at once
+  DEBUG_SERIAL.println(F("Safe mode unused, rebooting"));
+  portENTER_CRITICAL(&bootMux);
+  bootRecord.failures = BOOT_SAFE_MODE_FAILURES - 1;
+  sealRecord();
+  portEXIT_CRITICAL(&bootMux);
+  flushFlashWrites();
+  ESP.restart();
+}
+
+/********************************************************************************
+*                             API
+* ******************************************************************************/
+
+void RTKBaseManager::actionBoot(AsyncWebServerRequest *request) {
+  boot_stats_t stats;
+  getBootStats(&stats);
+
+  char json[BOOT_HISTORY_LEN * 128 + 128];
+  size_t len = snprintf(json, sizeof(json), "{\"boots\":%u,\"failures\":%u,\"safe_mode\":%s,\"history\":[",
+                        (unsigned int)stats.boots, stats.failures, stats.safeMode ? "true" : "false");
+  for (uint8_t i = 0; i < stats.count && len < sizeof(json); i++) {
+    const boot_entry_t& b = stats.history[i];
+    len += snprintf(json + len, sizeof(json) - len,
+                    "%s{\"reason\":\"%s\",\"safe_mode\":%s,\"stable\":%s,\"setup_ms\":%u,\"uptime_ms\":%u}",
+                    (i == 0) ? "" : ",", reasonName(b.reason), b.safeMode ? "true" : "false", b.stable ? "true" : "false",
+                    (unsigned int)b.setupMs, (unsigned int)b.uptimeMs);
+  }
+  if (len < sizeof(json)) snprintf(json + len, sizeof(json) - len, "]}");
+  request->send(200, "application/json", json);
+}
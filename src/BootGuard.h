@@ -0,0 +1,107 @@
+/**
+ * @file    BootGuard.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Counts boots and keeps the reset reasons and durations of the last
+ *          BOOT_HISTORY_LEN boots in RTC memory, which survives every reset
+ *          but a power cycle and costs no flash write in a reboot loop. A boot
+ *          that ends before BOOT_STABLE_MS of uptime counts as failed. After
+ *          BOOT_SAFE_MODE_FAILURES failed boots in a row the base comes up in
+ *          safe mode right away: AP and a minimal page to fix or wipe the
+ *          config, without the WiFi scan, the casters or the recorder. A
+ *          reboot from the page boots normally again, an unused safe mode
+ *          reboots by itself after BOOT_SAFE_MODE_TIMEOUT_MS.
+ *
+ *          GET /api/boot   -> boot counter, safe mode and history as JSON
+ */
+
+#ifndef BOOT_GUARD_H
+#define BOOT_GUARD_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <RTKBaseManager.h>
+
+namespace RTKBaseManager {
+  const uint8_t BOOT_HISTORY_LEN = 8;
+
+typedef struct {
+  uint8_t  reason;          // esp_reset_reason_t that started the boot
+  bool     safeMode;
+  bool     stable;          // reached BOOT_STABLE_MS
+  uint32_t setupMs;         // until setup() was done, 0 if it never was
+  uint32_t uptimeMs;        // last heartbeat, how long the boot ran
+} boot_entry_t;
+
+typedef struct {
+  uint32_t     boots;       // since the last power cycle
+  uint8_t      failures;    // failed boots in a row, this one included until it is stable
+  bool         safeMode;
+  uint8_t      count;       // entries in history
+  boot_entry_t history[BOOT_HISTORY_LEN];   // newest first, [0] is this boot
+} boot_stats_t;
+
+  /**
+   * @brief Count this boot and start the heartbeat, call first in setup()
+   *
+   * @return true   If the base has to come up in safe mode
+   * @return false  If not
+   */
+  bool beginBoot(void);
+
+  /**
+   * @brief Record the setup time, call last in setup()
+   */
+  void endBootSetup(void);
+
+  /**
+   * @brief Forget the failed boots, call before an intended restart
+   */
+  void clearBootFailures(void);
+
+  /**
+   * @brief Check if the boot is in safe mode
+   *
+   * @return true   If so
+   */
+  bool inSafeMode(void);
+
+  /**
+   * @brief Decide if a boot starts in safe mode
+   *
+   * @param failures  Failed boots in a row before this one
+   * @param reason    esp_reset_reason_t of this boot
+   * @return true     If at least BOOT_SAFE_MODE_FAILURES and not a power on
+   */
+  bool needsSafeMode(uint8_t failures, uint8_t reason);
+
+  /**
+   * @brief Get the boot counters and history
+   *
+   * @param stats Address of the struct to write to
+   */
+  void getBootStats(boot_stats_t* stats);
+
+  /**
+   * @brief Register the routes of the safe mode page and start the server
+   *
+   * @param server  Web server
+   */
+  void startSafeServer(AsyncWebServer *server);
+
+  /**
+   * @brief Reboot an unused safe mode after BOOT_SAFE_MODE_TIMEOUT_MS, call
+   *        from loop()
+   */
+  void checkSafeModeTimeout(void);
+
+  /**
+   * @brief Handler of /api/boot
+   *
+   * @param request Request
+   */
+  void actionBoot(AsyncWebServerRequest *request);
+}
+
+#endif /*** BOOT_GUARD_H ***/
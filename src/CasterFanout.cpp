@@ -0,0 +1,739 @@
+#include <CasterFanout.h>
+#include <GnssUart.h>
+#include <LocalCaster.h>
+#include <Recorder.h>
+#include <RtcmScheduler.h>
+#include <AsyncTCP.h>
+#include <esp_system.h>
+#include <lwip/dns.h>
+#include <StatusApi.h>
+#include <TimeSeries.h>
+#include <TaskRuntime.h>
+#ifdef RTK_SIMULATION
+#include <Simulation.h>
+#endif
+
+/********************************************************************************
+*                             Targets
+* ******************************************************************************/
+
+using RTKBaseManager::rtcm_frame_t;
+
+typedef enum {
+  LINK_IDLE,
+  LINK_RESOLVING,       // waits for the DNS answer of the target
+  LINK_CONNECTING,
+  LINK_OPEN,            // TCP up, no request sent yet: the warm standby
+  LINK_HANDSHAKE,       // SOURCE request sent, waiting for ICY 200 OK
+  LINK_STREAMING,
+  LINK_CLOSED           // disconnected, handled by the egress task
+} link_state_t;
+
+typedef enum {
+  DNS_NONE,             // no address or a stale one
+  DNS_PENDING,          // lookup running, onResolved() answers on the lwIP task
+  DNS_RESOLVED,
+  DNS_FAILED
+} dns_state_t;
+
+typedef struct {
+  AsyncClient           client;
+  uint8_t               target;                           // index in targets
+  volatile link_state_t state;
+  link_state_t          reached;                          // furthest state of the current connection
+  bool                  rejected;                         // by the caster in the handshake
+  uint32_t              phaseStartMs;                     // of the current state
+  char                  reply[32];                        // status line of the caster, may come in parts
+  uint8_t               replyLen;
+  uint8_t               failures;                         // in a row, sets the backoff
+  uint32_t              nextAttemptMs;
+} caster_link_t;
+
+typedef struct {
+  caster_link_t         links[2];                         // primary and warm standby, they swap roles
+  volatile uint8_t      primary;                          // index in links
+  QueueHandle_t         queue;                            // frames to send, one reference each
+  rtcm_frame_t*         pending;                          // taken from the queue, waits for TCP space
+  RTKBaseManager::rtcm_window_t window;                   // sent on the primary, not acknowledged
+  RTKBaseManager::caster_drop_policy_t policy;
+  bool                  configured;
+  bool                  reload;                           // config changed, apply once disconnected
+  bool                  rejected;                         // last primary was refused
+  char                  host[RTKBaseManager::CONFIG_VALUE_MAX_LEN + 1];
+  uint16_t              port;
+  char                  mount[RTKBaseManager::CONFIG_VALUE_MAX_LEN + 1];
+  char                  password[RTKBaseManager::CONFIG_VALUE_MAX_LEN + 1];
+  char                  request[160];                     // SOURCE request with the password
+  IPAddress             address;                          // cached DNS answer
+  volatile dns_state_t  dns;
+  uint32_t              resolvedMs;
+  uint32_t              dnsMs;                            // phases of the last primary connection
+  uint32_t              tcpMs;
+  uint32_t              handshakeMs;
+  bool                  down;                             // lost the stream, not back yet
+  uint32_t              downSinceMs;
+  uint32_t              lastOutageMs;
+  uint32_t              maxOutageMs;
+  uint32_t              outages;
+  uint32_t              promotions;                       // standby took over
+  uint32_t              dnsLookups;
+  uint32_t              dnsHits;
+  uint32_t              framesSent;
+  uint32_t              framesDropped;
+  uint32_t              bytesAcked;
+  uint32_t              bytesSaved;                       // decimated by the rate schedule
+  uint32_t              connects;
+} caster_target_t;
+
+// Config names of the casters, row 0 is the caster of the single caster config
+static const char* const TARGET_PARAMS[RTKBaseManager::CASTER_MAX_TARGETS][4] = {
+  { RTKBaseManager::PARAM_RTK_CASTER_HOST,   RTKBaseManager::PARAM_RTK_CASTER_PORT,   RTKBaseManager::PARAM_RTK_MOINT_POINT,   RTKBaseManager::PARAM_RTK_MOINT_POINT_PW   },
+  { RTKBaseManager::PARAM_RTK_CASTER_HOST_2, RTKBaseManager::PARAM_RTK_CASTER_PORT_2, RTKBaseManager::PARAM_RTK_MOINT_POINT_2, RTKBaseManager::PARAM_RTK_MOINT_POINT_PW_2 },
+  { RTKBaseManager::PARAM_RTK_CASTER_HOST_3, RTKBaseManager::PARAM_RTK_CASTER_PORT_3, RTKBaseManager::PARAM_RTK_MOINT_POINT_3, RTKBaseManager::PARAM_RTK_MOINT_POINT_PW_3 },
+};
+
+static caster_target_t targets[RTKBaseManager::CASTER_MAX_TARGETS];
+
+// A caster holds its queue, its window and the pending frame; the local caster its
+// ring and the window of a rover beside it, a rover further behind is evicted
+static_assert(RTCM_POOL_FRAMES >= RTKBaseManager::CASTER_MAX_TARGETS * (CASTER_QUEUE_LEN + RTCM_IN_FLIGHT_LEN + 1) +
+                                  LOCAL_CASTER_RING_LEN + RTCM_IN_FLIGHT_LEN + 1,
+              "RTCM_POOL_FRAMES too small for the casters, raise it or shorten the queues");
+static RTKBaseManager::rtcm_framer_t framer;
+static RTKBaseManager::rate_schedule_t schedule;          // rtcm_rates, owned by the ingest task
+static uint32_t scheduleVersion = 0;
+static TaskHandle_t ingestTask = nullptr;
+static TaskHandle_t egressTask = nullptr;
+static bool uplinkEnabled = false;                        // false in AP mode, no route to the casters
+static bool standbyEnabled = false;                       // caster_standby
+
+static void wakeEgress() {
+  if (egressTask != nullptr) xTaskNotifyGive(egressTask);
+}
+
+static caster_link_t* primaryLink(caster_target_t* t) {
+  return &t->links[t->primary];
+}
+
+static caster_link_t* standbyLink(caster_target_t* t) {
+  return &t->links[t->primary ^ 1];
+}
+
+static bool isStreaming(caster_target_t* t) {
+  return primaryLink(t)->state == LINK_STREAMING;
+}
+
+static bool settingsChanged(const caster_target_t* t, const RTKBaseManager::config_snapshot_t* config, uint8_t i) {
+  using namespace RTKBaseManager;
+  const char* host = config->values[findParam(TARGET_PARAMS[i][0])];
+  uint16_t port = atoi(config->values[findParam(TARGET_PARAMS[i][1])]);
+  const char* mount = config->values[findParam(TARGET_PARAMS[i][2])];
+  const char* password = config->values[findParam(TARGET_PARAMS[i][3])];
+  return strcmp(t->host, host) != 0 || t->port != port || strcmp(t->mount, mount) != 0 || strcmp(t->password, password) != 0;
+}
+
+static void loadTarget(caster_target_t* t, uint8_t i) {
+  using namespace RTKBaseManager;
+  config_snapshot_t config;
+  readConfig(&config);
+  strncpy(t->host, config.values[findParam(TARGET_PARAMS[i][0])], sizeof(t->host) - 1);
+  t->port = atoi(config.values[findParam(TARGET_PARAMS[i][1])]);
+  strncpy(t->mount, config.values[findParam(TARGET_PARAMS[i][2])], sizeof(t->mount) - 1);
+  strncpy(t->password, config.values[findParam(TARGET_PARAMS[i][3])], sizeof(t->password) - 1);
+  snprintf(t->request, sizeof(t->request), "SOURCE %s /%s\r\nSource-Agent: NTRIP RTKBaseManager/%s\r\n\r\n",
+           t->password, t->mount, FIRMWARE_VERSION);
+  t->reload = false;
+  t->rejected = false;
+  t->dns = DNS_NONE;
+  t->down = false;
+  for (uint8_t l = 0; l < 2; l++) {
+    t->links[l].failures = 0;
+    t->links[l].nextAttemptMs = millis();
+  }
+  t->configured = t->host[0] != '\0' && t->port != 0 && t->mount[0] != '\0';
+}
+
+uint32_t RTKBaseManager::backoffDelayMs(uint8_t failures, uint32_t random) {
+  uint32_t delay = CASTER_BACKOFF_MIN_MS;
+  for (uint8_t i = 1; i < failures && delay < CASTER_BACKOFF_MAX_MS; i++) delay <<= 1;
+  if (delay > CASTER_BACKOFF_MAX_MS) delay = CASTER_BACKOFF_MAX_MS;
+  // Equal jitter: bases that lost the same caster do not come back in step
+  return delay / 2 + random % (delay / 2 + 1);
+}
+
+/********************************************************************************
+*                             Connection, runs on async_tcp
+* ******************************************************************************/
+
+// Sends the SOURCE request, from onConnect() or on the egress task for a standby taking over
+static void startHandshake(caster_target_t* t, caster_link_t* l) {
+  size_t len = strlen(t->request);
+  RTKBaseManager::openWindow(&t->window, len);
+  l->phaseStartMs = millis();
+  l->replyLen = 0;
+  l->state = LINK_HANDSHAKE;
+  l->reached = LINK_HANDSHAKE;
+  l->client.setNoDelay(true);
+  l->client.write(t->request, len);
+}
+
+static void onConnect(void* arg, AsyncClient* client) {
+  caster_link_t* l = (caster_link_t*)arg;
+  caster_target_t* t = &targets[l->target];
+  uint32_t tcpMs = millis() - l->phaseStartMs;
+  // Only an open standby swaps roles, a connecting link keeps its role
+  if (l == primaryLink(t)) {
+    t->tcpMs = tcpMs;
+    startHandshake(t, l);
+  } else {
+    l->state = LINK_OPEN;
+    l->reached = LINK_OPEN;
+  }
+}
+
+static void onData(void* arg, AsyncClient* client, void* data, size_t len) {
+  caster_link_t* l = (caster_link_t*)arg;
+  caster_target_t* t = &targets[l->target];
+  if (l->state != LINK_HANDSHAKE) return;
+  // The status line may come in several segments, decide once it is complete
+  size_t room = sizeof(l->reply) - 1 - l->replyLen;
+  size_t take = (len < room) ? len : room;
+  memcpy(l->reply + l->replyLen, data, take);
+  l->replyLen += take;
+  l->reply[l->replyLen] = '\0';
+  if (strstr(l->reply, "\r\n") == nullptr && l->replyLen < sizeof(l->reply) - 1) return;
+
+  // NTRIP 1 answers ICY 200 OK, some casters answer like HTTP
+  const char* reply = l->reply;
+  bool ok = strncmp(reply, "ICY 200 OK", 10) == 0 || strncmp(reply, "HTTP/1.1 200", 12) == 0 ||
+            strncmp(reply, "HTTP/1.0 200", 12) == 0;
+  if (!ok) {
+    DEBUG_SERIAL.printf("Caster %s rejected mount point %s\r\n", t->host, t->mount);
+    l->rejected = true;
+    client->close();
+    return;
+  }
+  uint32_t now = millis();
+  t->handshakeMs = now - l->phaseStartMs;
+  l->phaseStartMs = now;
+  l->state = LINK_STREAMING;
+  l->reached = LINK_STREAMING;
+  if (t->down) {
+    // Outage: from the lost stream to the next accepted one
+    t->lastOutageMs = now - t->downSinceMs;
+    if (t->lastOutageMs > t->maxOutageMs) t->maxOutageMs = t->lastOutageMs;
+    t->outages++;
+    t->down = false;
+  }
+  wakeEgress();
+}
+
+static void onAck(void* arg, AsyncClient* client, size_t len, uint32_t time) {
+  caster_link_t* l = (caster_link_t*)arg;
+  caster_target_t* t = &targets[l->target];
+  if (l != primaryLink(t)) return;
+  uint8_t before = RTKBaseManager::windowCount(&t->window);
+  t->bytesAcked += RTKBaseManager::ackWindow(&t->window, len);
+  if (RTKBaseManager::windowCount(&t->window) != before) wakeEgress();
+}
+
+static void onDisconnect(void* arg, AsyncClient* client) {
+  caster_link_t* l = (caster_link_t*)arg;
+  caster_target_t* t = &targets[l->target];
+  if (l == primaryLink(t)) RTKBaseManager::closeWindow(&t->window);
+  l->state = LINK_CLOSED;
+  wakeEgress();
+}
+
+/********************************************************************************
+*                             Connection manager, runs on the egress task
+* ******************************************************************************/
+
+// Runs on the lwIP task, the links waiting in LINK_RESOLVING pick the answer up
+static void onResolved(const char* name, const ip_addr_t* addr, void* arg) {
+  caster_target_t* t = (caster_target_t*)arg;
+  if (addr != nullptr) {
+    t->address = IPAddress(ip_addr_get_ip4_u32(addr));
+    t->resolvedMs = millis();
+    t->dns = DNS_RESOLVED;
+  } else {
+    t->dns = DNS_FAILED;
+  }
+  wakeEgress();
+}
+
+// Starts a lookup without waiting for it, the egress task keeps serving the other casters
+static dns_state_t resolveTarget(caster_target_t* t, IPAddress* ip) {
+  if (ip->fromString(t->host)) return DNS_RESOLVED;
+  if (t->dns == DNS_PENDING) return DNS_PENDING;
+  if (t->dns == DNS_RESOLVED && millis() - t->resolvedMs < CASTER_DNS_TTL_MS) {
+    t->dnsHits++;
+    *ip = t->address;
+    return DNS_RESOLVED;
+  }
+  t->dnsLookups++;
+  t->dns = DNS_PENDING;
+  ip_addr_t addr;
+  err_t err = dns_gethostbyname(t->host, &addr, onResolved, t);
+  if (err == ERR_OK) {
+    // Answered from the lwIP cache, the callback is not called
+    t->address = IPAddress(ip_addr_get_ip4_u32(&addr));
+    t->resolvedMs = millis();
+    t->dns = DNS_RESOLVED;
+    *ip = t->address;
+    return DNS_RESOLVED;
+  }
+  // onResolved() may already have run, the waiting link picks the address up
+  if (err == ERR_INPROGRESS) return DNS_PENDING;
+  t->dns = DNS_FAILED;
+  return DNS_FAILED;
+}
+
+static void deferLink(caster_link_t* l, uint32_t now) {
+  if (l->failures < UINT8_MAX) l->failures++;
+  l->nextAttemptMs = now + RTKBaseManager::backoffDelayMs(l->failures, esp_random());
+}
+
+// TCP connect once the address is known, start is when the lookup began
+static void openLink(caster_target_t* t, caster_link_t* l, const IPAddress& ip, uint32_t start) {
+  l->phaseStartMs = millis();
+  if (l == primaryLink(t)) {
+    t->dnsMs = l->phaseStartMs - start;
+    t->connects++;
+  }
+  l->state = LINK_CONNECTING;
+  l->reached = LINK_CONNECTING;
+  if (!l->client.connect(ip, t->port)) l->state = LINK_CLOSED;
+}
+
+static void connectLink(caster_target_t* t, caster_link_t* l) {
+  uint32_t now = millis();
+  IPAddress ip;
+  l->rejected = false;
+  switch (resolveTarget(t, &ip)) {
+    case DNS_RESOLVED:
+      openLink(t, l, ip, now);
+      break;
+    case DNS_PENDING:
+      l->phaseStartMs = now;
+      l->state = LINK_RESOLVING;
+      l->reached = LINK_RESOLVING;
+      break;
+    default:
+      t->dns = DNS_NONE;
+      deferLink(l, now);
+      break;
+  }
+}
+
+// A link waiting for DNS goes on once the answer is in
+static void resumeLink(caster_target_t* t, caster_link_t* l, uint32_t now) {
+  dns_state_t dns = t->dns;
+  if (dns == DNS_PENDING) return;
+  if (dns == DNS_RESOLVED) {
+    openLink(t, l, t->address, l->phaseStartMs);
+    return;
+  }
+  t->dns = DNS_NONE;
+  l->state = LINK_IDLE;
+  l->reached = LINK_IDLE;
+  deferLink(l, now);
+}
+
+// No answer from the caster in time, the disconnect ends in linkClosed() and its backoff
+static void checkTimeout(caster_link_t* l, uint32_t now) {
+  if ((l->state == LINK_CONNECTING || l->state == LINK_HANDSHAKE) && now - l->phaseStartMs >= CASTER_HANDSHAKE_TIMEOUT_MS) {
+    l->client.close();
+  }
+}
+
+static void linkClosed(caster_target_t* t, caster_link_t* l, uint32_t now) {
+  bool primary = l == primaryLink(t);
+  bool streamed = l->reached == LINK_STREAMING;
+  if (primary && streamed && !t->down) {
+    t->down = true;
+    t->downSinceMs = now;
+  }
+  if (primary) t->rejected = l->rejected;
+  // No TCP connection at all, the cached address may be stale
+  if (l->reached < LINK_OPEN && t->dns == DNS_RESOLVED) t->dns = DNS_NONE;
+
+  // A stream that lasted counts as success and is resumed at once, a standby as soon as it was open
+  bool ok = primary ? (streamed && now - l->phaseStartMs >= CASTER_STABLE_MS) : l->reached >= LINK_OPEN;
+  l->state = LINK_IDLE;
+  l->reached = LINK_IDLE;
+  if (ok) {
+    l->failures = 0;
+    l->nextAttemptMs = primary ? now : now + CASTER_BACKOFF_MIN_MS;
+  } else {
+    deferLink(l, now);
+  }
+}
+
+static bool linkBusy(const caster_link_t* l) {
+  return l->state != LINK_IDLE && l->state != LINK_CLOSED;
+}
+
+static bool due(const caster_link_t* l, uint32_t now) {
+  return (int32_t)(now - l->nextAttemptMs) >= 0;
+}
+
+static void manageTarget(caster_target_t* t, uint8_t i) {
+  uint32_t now = millis();
+  for (uint8_t l = 0; l < 2; l++) {
+    caster_link_t* link = &t->links[l];
+    if (link->state == LINK_CLOSED) linkClosed(t, link, now);
+    else if (link->state == LINK_RESOLVING) resumeLink(t, link, now);
+    else checkTimeout(link, now);
+  }
+  caster_link_t* p = primaryLink(t);
+  caster_link_t* s = standbyLink(t);
+
+  if (t->reload) {
+    if (!linkBusy(p) && !linkBusy(s)) loadTarget(t, i);
+    // A link waiting for DNS is done once the answer is in, the lookup can not be cancelled
+    if (linkBusy(p) && p->state != LINK_RESOLVING) p->client.close();
+    if (linkBusy(s) && s->state != LINK_RESOLVING) s->client.close();
+    return;
+  }
+  if (!t->configured) return;
+
+  if (p->state == LINK_IDLE && due(p, now)) {
+    if (s->state == LINK_OPEN) {
+      // Warm standby: DNS and TCP are done, only the handshake is left
+      t->primary ^= 1;
+      t->promotions++;
+      t->connects++;
+      t->dnsMs = 0;
+      t->tcpMs = 0;
+      startHandshake(t, s);
+      return;
+    }
+    connectLink(t, p);
+  }
+
+  if (!standbyEnabled) {
+    if (linkBusy(s) && s->state != LINK_RESOLVING) s->client.close();
+  } else if (p->state == LINK_STREAMING && s->state == LINK_IDLE && due(s, now)) {
+    connectLink(t, s);
+  }
+}
+
+/********************************************************************************
+*                             Egress task
+* ******************************************************************************/
+
+// Frames of a caster that is not streaming are stale, drop them
+static void dropQueued(caster_target_t* t) {
+  rtcm_frame_t* frame;
+  if (t->pending != nullptr) {
+    RTKBaseManager::releaseFrame(t->pending);
+    t->pending = nullptr;
+  }
+  while (xQueueReceive(t->queue, &frame, 0) == pdTRUE) RTKBaseManager::releaseFrame(frame);
+}
+
+static void pumpTarget(caster_target_t* t) {
+  AsyncClient* client = &primaryLink(t)->client;
+  bool added = false;
+  while (true) {
+    if (t->pending == nullptr && xQueueReceive(t->queue, &t->pending, 0) != pdTRUE) break;
+    rtcm_frame_t* frame = t->pending;
+    if (client->space() < frame->len) break;
+    if (!RTKBaseManager::pushWindow(&t->window, frame)) break;
+    t->pending = nullptr;
+
+    // No copy flag: TCP sends from the pool frame, onAck() releases it
+    if (client->add((const char*)frame->data, frame->len, 0) < frame->len) {
+      client->close();
+      break;
+    }
+    t->framesSent++;
+    added = true;
+  }
+  if (added) client->send();
+}
+
+static void egressLoop(void* parameter) {
+  uint32_t seenVersion = 0;
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+
+    uint32_t version = RTKBaseManager::configVersion();
+    if (uplinkEnabled && version != seenVersion) {
+      seenVersion = version;
+      RTKBaseManager::config_snapshot_t config;
+      RTKBaseManager::readConfig(&config);
+      standbyEnabled = strcmp(config.values[RTKBaseManager::findParam(RTKBaseManager::PARAM_CASTER_STANDBY)],
+                              RTKBaseManager::SWITCH_ON) == 0;
+      for (uint8_t i = 0; i < RTKBaseManager::CASTER_MAX_TARGETS; i++) {
+        if (settingsChanged(&targets[i], &config, i)) targets[i].reload = true;
+      }
+    }
+
+    for (uint8_t i = 0; i < RTKBaseManager::CASTER_MAX_TARGETS; i++) {
+      caster_target_t* t = &targets[i];
+      manageTarget(t, i);
+      if (isStreaming(t)) pumpTarget(t);
+      else dropQueued(t);
+    }
+    RTKBaseManager::pumpLocalClients();
+  }
+}
+
+/********************************************************************************
+*                             Ingest task
+* ******************************************************************************/
+
+static void loadSchedule() {
+  RTKBaseManager::config_snapshot_t config;
+  RTKBaseManager::readConfig(&config);
+  scheduleVersion = config.version;
+  RTKBaseManager::parseRates(&schedule, config.values[RTKBaseManager::findParam(RTKBaseManager::PARAM_RTCM_RATES)]);
+}
+
+void RTKBaseManager::ingestBytes(const uint8_t* data, size_t len) {
+  if (configVersion() != scheduleVersion) loadSchedule();
+  size_t used = 0;
+  while (used < len) {
+    rtcm_frame_t* frame;
+    used += feedFramer(&framer, data + used, len - used, &frame);
+    if (frame != nullptr) publishFrame(frame);
+  }
+}
+
+// Polls a Stream, for sources without driver events like the simulation
+static void ingestLoop(void* parameter) {
+  Stream* source = (Stream*)parameter;
+  uint8_t buf[256];
+  while (true) {
+    int available = source->available();
+    if (available <= 0) {
+      vTaskDelay(pdMS_TO_TICKS(5));
+      continue;
+    }
+    size_t n = source->readBytes(buf, ((size_t)available < sizeof(buf)) ? available : sizeof(buf));
+    RTKBaseManager::ingestBytes(buf, n);
+  }
+}
+
+void RTKBaseManager::publishFrame(rtcm_frame_t* frame) {
+  recordFrame(frame);
+  seriesFrame(frame);
+  // The rate schedule trims the uplink only, the local caster gets every frame
+  bool uplink = scheduleFrame(&schedule, frame);
+#ifdef RTK_SIMULATION
+  simFramePublished(frame, uplink);
+#endif
+  for (uint8_t i = 0; i < CASTER_MAX_TARGETS; i++) {
+    caster_target_t* t = &targets[i];
+    if (!isStreaming(t)) continue;
+    if (!uplink) {
+      t->bytesSaved += frame->len;
+      continue;
+    }
+    retainFrame(frame);
+    if (xQueueSend(t->queue, &frame, 0) == pdTRUE) continue;
+
+    // Full: this caster is slow, the others are not held up
+    t->framesDropped++;
+    rtcm_frame_t* oldest;
+    if (t->policy == DROP_OLDEST && xQueueReceive(t->queue, &oldest, 0) == pdTRUE) {
+      releaseFrame(oldest);
+      if (xQueueSend(t->queue, &frame, 0) == pdTRUE) continue;
+    }
+    releaseFrame(frame);
+  }
+  broadcastFrame(frame);
+  releaseFrame(frame);
+  wakeEgress();
+}
+
+void RTKBaseManager::startCasters(Stream* source, bool uplink) {
+  if (egressTask != nullptr) return;
+  uplinkEnabled = uplink;
+  for (uint8_t i = 0; i < CASTER_MAX_TARGETS; i++) {
+    caster_target_t* t = &targets[i];
+    beginWindow(&t->window);
+    t->queue = xQueueCreate(CASTER_QUEUE_LEN, sizeof(rtcm_frame_t*));
+    t->policy = DROP_OLDEST;
+    t->configured = false;
+    t->reload = uplink;
+    for (uint8_t l = 0; l < 2; l++) {
+      caster_link_t* link = &t->links[l];
+      link->target = i;
+      link->state = LINK_IDLE;
+      link->client.onConnect(onConnect, link);
+      link->client.onData(onData, link);
+      link->client.onAck(onAck, link);
+      link->client.onDisconnect(onDisconnect, link);
+    }
+  }
+  beginFramer(&framer);
+  spawnTask(TASK_ROLE_CORRECTION_EGRESS, egressLoop, "rtcmEgress", 4096, nullptr, &egressTask);
+  loadSchedule();
+  if (source != nullptr) spawnTask(TASK_ROLE_GNSS_INGEST, ingestLoop, "gnssIngest", 4096, source, &ingestTask);
+}
+
+/********************************************************************************
+*                             Stats
+* ******************************************************************************/
+
+void RTKBaseManager::setDropPolicy(uint8_t target, caster_drop_policy_t policy) {
+  if (target < CASTER_MAX_TARGETS) targets[target].policy = policy;
+}
+
+static RTKBaseManager::caster_state_t stateOf(caster_target_t* t) {
+  if (!t->configured) return RTKBaseManager::CASTER_UNCONFIGURED;
+  switch (primaryLink(t)->state) {
+    case LINK_RESOLVING:
+    case LINK_CONNECTING:  return RTKBaseManager::CASTER_CONNECTING;
+    case LINK_HANDSHAKE:   return RTKBaseManager::CASTER_HANDSHAKE;
+    case LINK_STREAMING:   return RTKBaseManager::CASTER_STREAMING;
+    default:               return t->rejected ? RTKBaseManager::CASTER_REJECTED : RTKBaseManager::CASTER_DISCONNECTED;
+  }
+}
+
+static RTKBaseManager::standby_state_t standbyOf(caster_target_t* t) {
+  if (!standbyEnabled) return RTKBaseManager::STANDBY_OFF;
+  switch (standbyLink(t)->state) {
+    case LINK_RESOLVING:
+    case LINK_CONNECTING:  return RTKBaseManager::STANDBY_CONNECTING;
+    case LINK_OPEN:        return RTKBaseManager::STANDBY_READY;
+    default:               return RTKBaseManager::STANDBY_IDLE;
+  }
+}
+
+void RTKBaseManager::getCasterStats(uint8_t target, caster_stats_t* stats) {
+  caster_target_t* t = &targets[target];
+  memset(stats, 0, sizeof(caster_stats_t));
+  strncpy(stats->host, t->host, sizeof(stats->host) - 1);
+  stats->port = t->port;
+  strncpy(stats->mount, t->mount, sizeof(stats->mount) - 1);
+  stats->state = stateOf(t);
+  stats->standby = standbyOf(t);
+  stats->policy = t->policy;
+  stats->queued = (t->queue != nullptr) ? uxQueueMessagesWaiting(t->queue) : 0;
+  stats->inFlight = windowCount(&t->window);
+  stats->framesSent = t->framesSent;
+  stats->framesDropped = t->framesDropped;
+  stats->bytesAcked = t->bytesAcked;
+  stats->connects = t->connects;
+  stats->bytesSaved = t->bytesSaved;
+
+  const caster_link_t* p = primaryLink(t);
+  int32_t retryIn = (int32_t)(p->nextAttemptMs - millis());
+  stats->failures = p->failures;
+  stats->retryInMs = (p->state == LINK_IDLE && retryIn > 0) ? retryIn : 0;
+  stats->dnsMs = t->dnsMs;
+  stats->tcpMs = t->tcpMs;
+  stats->handshakeMs = t->handshakeMs;
+  stats->downMs = t->down ? millis() - t->downSinceMs : 0;
+  stats->lastOutageMs = t->lastOutageMs;
+  stats->maxOutageMs = t->maxOutageMs;
+  stats->outages = t->outages;
+  stats->promotions = t->promotions;
+  stats->dnsLookups = t->dnsLookups;
+  stats->dnsHits = t->dnsHits;
+}
+
+void RTKBaseManager::getRtcmStats(rtcm_stats_t* stats) {
+  stats->frames = framer.frames;
+  stats->crcErrors = framer.crcErrors;
+  stats->poolEmpty = framer.poolEmpty;
+  stats->skipped = framer.skipped;
+  stats->freeFrames = freeFrames();
+  stats->bytesPassed = schedule.bytesPassed;
+  stats->bytesDecimated = schedule.bytesDropped;
+  stats->uplinkSaved = 0;
+  for (uint8_t i = 0; i < CASTER_MAX_TARGETS; i++) stats->uplinkSaved += targets[i].bytesSaved;
+}
+
+void RTKBaseManager::getRateSchedule(rate_schedule_t* copy) {
+  memcpy(copy, &schedule, sizeof(rate_schedule_t));
+}
+
+static const char* stateName(RTKBaseManager::caster_state_t state) {
+  switch (state) {
+    case RTKBaseManager::CASTER_UNCONFIGURED:  return "unconfigured";
+    case RTKBaseManager::CASTER_DISCONNECTED:  return "disconnected";
+    case RTKBaseManager::CASTER_CONNECTING:    return "connecting";
+    case RTKBaseManager::CASTER_HANDSHAKE:     return "handshake";
+    case RTKBaseManager::CASTER_STREAMING:     return "streaming";
+    case RTKBaseManager::CASTER_REJECTED:      return "rejected";
+    default:                                   return "unknown";
+  }
+}
+
+static const char* standbyName(RTKBaseManager::standby_state_t standby) {
+  switch (standby) {
+    case RTKBaseManager::STANDBY_OFF:          return "off";
+    case RTKBaseManager::STANDBY_IDLE:         return "idle";
+    case RTKBaseManager::STANDBY_CONNECTING:   return "connecting";
+    case RTKBaseManager::STANDBY_READY:        return "ready";
+    default:                                   return "unknown";
+  }
+}
+
+void RTKBaseManager::actionCasters(AsyncWebServerRequest *request) {
+  rtcm_stats_t rtcm;
+  getRtcmStats(&rtcm);
+
+  rate_schedule_t rates;
+  getRateSchedule(&rates);
+
+  gnss_uart_stats_t uart;
+  getGnssUartStats(&uart);
+
+  char json[CASTER_MAX_TARGETS * (2 * 2 * CONFIG_VALUE_MAX_LEN + 500) + RATE_MAX_RULES * 96 + 600];
+  size_t len = snprintf(json, sizeof(json),
+                        "{\"uart\":{\"active\":%s,\"baud\":%u,\"bursts\":%u,\"bytes\":%u,\"last_burst\":%u,\"max_burst\":%u,"
+                        "\"split_bursts\":%u,\"fifo_overflows\":%u,\"buffer_overflows\":%u,\"frame_errors\":%u,\"parity_errors\":%u,"
+                        "\"burst_sizes\":[",
+                        uart.active ? "true" : "false", (unsigned int)uart.baud, (unsigned int)uart.bursts.bursts,
+                        (unsigned int)uart.bursts.bytes, (unsigned int)uart.bursts.lastBurst, (unsigned int)uart.bursts.maxBurst,
+                        (unsigned int)uart.bursts.splits, (unsigned int)uart.fifoOverflows, (unsigned int)uart.bufferOverflows,
+                        (unsigned int)uart.frameErrors, (unsigned int)uart.parityErrors);
+  for (uint8_t i = 0; i < UART_BURST_BUCKETS; i++) {
+    len += snprintf(json + len, sizeof(json) - len, "%s%u", (i == 0) ? "" : ",", (unsigned int)uart.bursts.sizes[i]);
+  }
+  len += snprintf(json + len, sizeof(json) - len,
+                  "]},\"rtcm\":{\"frames\":%u,\"crc_errors\":%u,\"pool_empty\":%u,\"skipped\":%u,\"free_frames\":%u,"
+                  "\"passed_bytes\":%u,\"decimated_bytes\":%u,\"uplink_saved_bytes\":%u,\"rates\":[",
+                  (unsigned int)rtcm.frames, (unsigned int)rtcm.crcErrors, (unsigned int)rtcm.poolEmpty,
+                  (unsigned int)rtcm.skipped, rtcm.freeFrames, (unsigned int)rtcm.bytesPassed,
+                  (unsigned int)rtcm.bytesDecimated, (unsigned int)rtcm.uplinkSaved);
+  for (uint8_t i = 0; i < rates.count && len < sizeof(json); i++) {
+    const rate_rule_t& r = rates.rules[i];
+    char type[8];
+    if (r.type == RATE_TYPE_MSM) snprintf(type, sizeof(type), "msm");
+    else if (r.type <= 7) snprintf(type, sizeof(type), "msm%u", r.type);
+    else snprintf(type, sizeof(type), "%u", r.type);
+    len += snprintf(json + len, sizeof(json) - len,
+                    "%s{\"type\":\"%s\",\"interval_s\":%u,\"passed\":%u,\"dropped\":%u,\"saved_bytes\":%u}",
+                    (i == 0) ? "" : ",", type, (unsigned int)(r.intervalMs / 1000), (unsigned int)r.passed,
+                    (unsigned int)r.dropped, (unsigned int)r.bytesDropped);
+  }
+  if (len < sizeof(json)) len += snprintf(json + len, sizeof(json) - len, "]},\"casters\":[");
+  for (uint8_t i = 0; i < CASTER_MAX_TARGETS && len < sizeof(json); i++) {
+    caster_stats_t s;
+    getCasterStats(i, &s);
+    len += snprintf(json + len, sizeof(json) - len, "%s{\"host\":", (i == 0) ? "" : ",");
+    len = appendJsonString(json, sizeof(json), len, s.host);
+    len += snprintf(json + len, sizeof(json) - len, ",\"port\":%u,\"mount\":", s.port);
+    len = appendJsonString(json, sizeof(json), len, s.mount);
+    len += snprintf(json + len, sizeof(json) - len,
+                    ",\"state\":\"%s\",\"policy\":\"%s\",\"queued\":%u,\"in_flight\":%u,\"sent\":%u,\"dropped\":%u,\"bytes\":%u,\"saved_bytes\":%u,\"connects\":%u",
+                    stateName(s.state), (s.policy == DROP_OLDEST) ? "drop_oldest" : "drop_newest", s.queued, s.inFlight,
+                    (unsigned int)s.framesSent, (unsigned int)s.framesDropped, (unsigned int)s.bytesAcked, (unsigned int)s.bytesSaved, (unsigned int)s.connects);
+    len += snprintf(json + len, sizeof(json) - len,
+                    ",\"standby\":\"%s\",\"failures\":%u,\"retry_in_ms\":%u,\"dns_ms\":%u,\"tcp_ms\":%u,\"handshake_ms\":%u,"
+                    "\"down_ms\":%u,\"last_outage_ms\":%u,\"max_outage_ms\":%u,\"outages\":%u,\"promotions\":%u,"
+                    "\"dns_lookups\":%u,\"dns_hits\":%u}",
+                    standbyName(s.standby), s.failures, (unsigned int)s.retryInMs, (unsigned int)s.dnsMs, (unsigned int)s.tcpMs,
+                    (unsigned int)s.handshakeMs, (unsigned int)s.downMs, (unsigned int)s.lastOutageMs, (unsigned int)s.maxOutageMs,
+                    (unsigned int)s.outages, (unsigned int)s.promotions, (unsigned int)s.dnsLookups, (unsigned int)s.dnsHits);
+  }
+  if (len < sizeof(json)) snprintf(json + len, sizeof(json) - len, "]}");
+  request->send(200, "application/json", json);
+}
@@ -0,0 +1,171 @@
+/**
+ * @file    CasterFanout.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Sends the RTCM stream of the receiver to up to CASTER_MAX_TARGETS
+ *          NTRIP casters (NTRIP 1 SOURCE). Every frame is stored once in the
+ *          pool of Rtcm.h, the casters only queue references and hand the
+ *          pool memory to TCP without a copy. The reference is dropped when
+ *          the caster acknowledged the bytes. Every caster has its own queue
+ *          and drop policy, a slow caster loses its own frames only.
+ *
+ *          Connections are managed per caster: names are resolved without
+ *          blocking and cached for CASTER_DNS_TTL_MS, TCP connect and
+ *          handshake time out after CASTER_HANDSHAKE_TIMEOUT_MS, failed
+ *          attempts back off exponentially with jitter and the DNS, TCP and
+ *          handshake phases are timed. With
+ *          caster_standby on a second TCP connection is kept open while
+ *          streaming and takes over with the handshake only. The rate
+ *          schedule of RtcmScheduler.h decides which frames go to the casters.
+ */
+
+#ifndef CASTER_FANOUT_H
+#define CASTER_FANOUT_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <RTKBaseManager.h>
+#include <Rtcm.h>
+#include <RtcmScheduler.h>
+
+namespace RTKBaseManager {
+  const uint8_t CASTER_MAX_TARGETS = 3;
+
+typedef enum {
+  CASTER_UNCONFIGURED,  // host, port or mount point missing
+  CASTER_DISCONNECTED,
+  CASTER_CONNECTING,
+  CASTER_HANDSHAKE,     // SOURCE request sent, waiting for ICY 200 OK
+  CASTER_STREAMING,
+  CASTER_REJECTED       // the caster refused the mount point or password
+} caster_state_t;
+
+typedef enum {
+  STANDBY_OFF,          // caster_standby is off
+  STANDBY_IDLE,         // waits for the primary to stream or for its backoff
+  STANDBY_CONNECTING,
+  STANDBY_READY         // TCP connected, takes over with the handshake only
+} standby_state_t;
+
+typedef enum {
+  DROP_OLDEST,          // a full queue gives up its oldest frame, keeps the stream current
+  DROP_NEWEST           // a full queue refuses new frames, keeps the stream gapless while it lasts
+} caster_drop_policy_t;
+
+typedef struct {
+  char                  host[CONFIG_VALUE_MAX_LEN + 1];
+  uint16_t              port;
+  char                  mount[CONFIG_VALUE_MAX_LEN + 1];
+  caster_state_t        state;
+  standby_state_t       standby;
+  caster_drop_policy_t  policy;
+  uint8_t               queued;       // frames waiting
+  uint8_t               inFlight;     // frames sent, not acknowledged
+  uint32_t              framesSent;
+  uint32_t              framesDropped;
+  uint32_t              bytesAcked;
+  uint32_t              bytesSaved;   // not sent because of the rate schedule
+  uint32_t              connects;
+  uint8_t               failures;     // in a row, sets the backoff
+  uint32_t              retryInMs;    // until the next attempt
+  uint32_t              dnsMs;        // phases of the last connection, 0 if skipped
+  uint32_t              tcpMs;
+  uint32_t              handshakeMs;
+  uint32_t              downMs;       // of the current outage, 0 while streaming
+  uint32_t              lastOutageMs; // from the lost stream to the next accepted one
+  uint32_t              maxOutageMs;
+  uint32_t              outages;
+  uint32_t              promotions;   // the standby took over
+  uint32_t              dnsLookups;
+  uint32_t              dnsHits;      // answered from the cache
+} caster_stats_t;
+
+typedef struct {
+  uint32_t frames;                    // valid frames of the receiver
+  uint32_t crcErrors;
+  uint32_t poolEmpty;
+  uint32_t skipped;
+  uint8_t  freeFrames;
+  uint32_t bytesPassed;               // by the rate schedule
+  uint32_t bytesDecimated;
+  uint32_t uplinkSaved;               // bytes not sent, summed over the streaming casters
+} rtcm_stats_t;
+
+  /**
+   * @brief Start the GNSS ingest and the correction egress tasks, call once
+   *        the network is up
+   *
+   * @param source  Stream polled for the receiver bytes, nullptr if they come
+   *                from startGnssUart() through ingestBytes()
+   * @param uplink  True in station mode, false in AP mode: the stream only
+   *                goes to the local caster
+   */
+  void startCasters(Stream* source, bool uplink);
+
+  /**
+   * @brief Frame the bytes of the receiver and publish the complete frames,
+   *        call from the ingest task only, e.g. as burst handler of startGnssUart()
+   *
+   * @param data  Bytes as received
+   * @param len   Number of bytes
+   */
+  void ingestBytes(const uint8_t* data, size_t len);
+
+  /**
+   * @brief Delay before the next connection attempt: exponential from
+   *        CASTER_BACKOFF_MIN_MS to CASTER_BACKOFF_MAX_MS, with equal jitter
+   *
+   * @param failures  Failed attempts in a row, at least 1
+   * @param random    Random number, e.g. esp_random()
+   * @return uint32_t Delay in ms, between half and all of the exponential step
+   */
+  uint32_t backoffDelayMs(uint8_t failures, uint32_t random);
+
+  /**
+   * @brief Hand a frame to every streaming caster and to the local caster,
+   *        takes over the caller's reference
+   *
+   * @param frame Complete frame
+   */
+  void publishFrame(rtcm_frame_t* frame);
+
+  /**
+   * @brief Set the drop policy of a caster
+   *
+   * @param target  Caster index, 0 is the caster of caster_host
+   * @param policy  Policy
+   */
+  void setDropPolicy(uint8_t target, caster_drop_policy_t policy);
+
+  /**
+   * @brief Get the counters of a caster
+   *
+   * @param target  Caster index
+   * @param stats   Address of the struct to write to
+   */
+  void getCasterStats(uint8_t target, caster_stats_t* stats);
+
+  /**
+   * @brief Get the counters of the receiver stream
+   *
+   * @param stats   Address of the struct to write to
+   */
+  void getRtcmStats(rtcm_stats_t* stats);
+
+  /**
+   * @brief Get a copy of the rate schedule with its counters
+   *
+   * @param copy    Address of the schedule to write to
+   */
+  void getRateSchedule(rate_schedule_t* copy);
+
+  /**
+   * @brief Handler of /api/casters, stream and caster counters as JSON
+   *
+   * @param request Request
+   */
+  void actionCasters(AsyncWebServerRequest *request);
+}
+
+#endif /*** CASTER_FANOUT_H ***/
@@ -0,0 +1,100 @@
+#include <Cbor.h>
+
+/********************************************************************************
+*                             Windowed writer
+* ******************************************************************************/
+
+static const uint8_t MAJOR_UINT = 0;
+static const uint8_t MAJOR_NEGATIVE = 1;
+static const uint8_t MAJOR_TEXT = 3;
+static const uint8_t MAJOR_ARRAY = 4;
+static const uint8_t MAJOR_MAP = 5;
+static const uint8_t SIMPLE_FALSE = 0xF4;
+static const uint8_t SIMPLE_TRUE = 0xF5;
+static const uint8_t SIMPLE_NULL = 0xF6;
+
+// Stores the part of data which falls into the window, counts all of it
+static void put(RTKBaseManager::cbor_writer_t* writer, const uint8_t* data, size_t n) {
+  size_t from = writer->len;
+  writer->len += n;
+  if (writer->out == nullptr) return;
+
+  size_t windowEnd = writer->skip + writer->room;
+  size_t begin = (from > writer->skip) ? from : writer->skip;
+  size_t end = (writer->len < windowEnd) ? writer->len : windowEnd;
+  if (begin >= end) return;
+  memcpy(writer->out + (begin - writer->skip), data + (begin - from), end - begin);
+}
+
+// Initial byte plus the shortest big endian argument
+static void putHead(RTKBaseManager::cbor_writer_t* writer, uint8_t major, uint32_t value) {
+  uint8_t head[5];
+  size_t n;
+  if (value < 24) {
+    head[0] = (major << 5) | value;
+    n = 1;
+  } else if (value <= 0xFF) {
+    head[0] = (major << 5) | 24;
+    head[1] = value;
+    n = 2;
+  } else if (value <= 0xFFFF) {
+    head[0] = (major << 5) | 25;
+    head[1] = value >> 8;
+    head[2] = value;
+    n = 3;
+  } else {
+    head[0] = (major << 5) | 26;
+    head[1] = value >> 24;
+    head[2] = value >> 16;
+    head[3] = value >> 8;
+    head[4] = value;
+    n = 5;
+  }
+  put(writer, head, n);
+}
+
+void RTKBaseManager::cborBegin(cbor_writer_t* writer, uint8_t* out, size_t skip, size_t room) {
+  writer->out = out;
+  writer->skip = skip;
+  writer->room = (out == nullptr) ? 0 : room;
+  writer->len = 0;
+}
+
+size_t RTKBaseManager::cborWindowLength(const cbor_writer_t* writer) {
+  if (writer->len <= writer->skip) return 0;
+  size_t n = writer->len - writer->skip;
+  return (n < writer->room) ? n : writer->room;
+}
+
+void RTKBaseManager::cborUint(cbor_writer_t* writer, uint32_t value) {
+  putHead(writer, MAJOR_UINT, value);
+}
+
+void RTKBaseManager::cborInt(cbor_writer_t* writer, int32_t value) {
+  // Negative numbers are stored as -1 - n, no overflow for INT32_MIN
+  if (value < 0) putHead(writer, MAJOR_NEGATIVE, (uint32_t)(-1 - value));
+  else putHead(writer, MAJOR_UINT, (uint32_t)value);
+}
+
+void RTKBaseManager::cborBool(cbor_writer_t* writer, bool value) {
+  uint8_t simple = value ? SIMPLE_TRUE : SIMPLE_FALSE;
+  put(writer, &simple, 1);
+}
+
+void RTKBaseManager::cborNull(cbor_writer_t* writer) {
+  put(writer, &SIMPLE_NULL, 1);
+}
+
+void RTKBaseManager::cborText(cbor_writer_t* writer, const char* text) {
+  size_t n = strlen(text);
+  putHead(writer, MAJOR_TEXT, n);
+  put(writer, (const uint8_t*)text, n);
+}
+
+void RTKBaseManager::cborMap(cbor_writer_t* writer, uint32_t count) {
+  putHead(writer, MAJOR_MAP, count);
+}
+
+void RTKBaseManager::cborArray(cbor_writer_t* writer, uint32_t count) {
+  putHead(writer, MAJOR_ARRAY, count);
+}
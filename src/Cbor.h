@@ -0,0 +1,62 @@
+/**
+ * @file    Cbor.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Minimal CBOR (RFC 8949) encoder without allocations. The writer
+ *          only keeps a window of the stream: bytes before skip and behind
+ *          skip + room are counted but not stored. Encoding the same data
+ *          again with the next window fills the TCP buffers of a response
+ *          chunk by chunk, a dry run without a window gives the length.
+ */
+
+#ifndef CBOR_H
+#define CBOR_H
+
+#include <Arduino.h>
+
+namespace RTKBaseManager {
+
+typedef struct {
+  uint8_t* out;     // window buffer, null for a dry run
+  size_t   skip;    // stream offset of out[0]
+  size_t   room;    // size of out
+  size_t   len;     // bytes of the whole stream so far
+} cbor_writer_t;
+
+  /**
+   * @brief Start a stream
+   *
+   * @param writer  Writer
+   * @param out     Window buffer, nullptr to only count the length
+   * @param skip    Stream offset of the window
+   * @param room    Size of the window
+   */
+  void cborBegin(cbor_writer_t* writer, uint8_t* out, size_t skip, size_t room);
+
+  /**
+   * @brief Bytes stored in the window
+   *
+   * @param writer  Writer
+   * @return size_t Bytes of the stream between skip and skip + room
+   */
+  size_t cborWindowLength(const cbor_writer_t* writer);
+
+  void cborUint(cbor_writer_t* writer, uint32_t value);
+  void cborInt(cbor_writer_t* writer, int32_t value);
+  void cborBool(cbor_writer_t* writer, bool value);
+  void cborText(cbor_writer_t* writer, const char* text);
+  void cborNull(cbor_writer_t* writer);
+
+  /**
+   * @brief Start a map or array of known size, followed by count key value
+   *        pairs or count items
+   *
+   * @param writer  Writer
+   * @param count   Number of pairs or items
+   */
+  void cborMap(cbor_writer_t* writer, uint32_t count);
+  void cborArray(cbor_writer_t* writer, uint32_t count);
+}
+
+#endif /*** CBOR_H ***/
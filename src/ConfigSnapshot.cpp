@@ -0,0 +1,64 @@
+#include <RTKBaseManager.h>
+#include <Storage.h>
+#include <Discovery.h>
+#include <Seqlock.h>
+
+/********************************************************************************
+*                             Config snapshot
+* ******************************************************************************/
+
+// Published through a seqlock, readers copy without a lock
+static Seqlock<RTKBaseManager::config_snapshot_t> currentConfig;
+
+static void parseLocation(RTKBaseManager::config_snapshot_t* config) {
+  using namespace RTKBaseManager;
+  const char* latStr = config->values[findParam(PARAM_RTK_LOCATION_LATITUDE)];
+  const char* lonStr = config->values[findParam(PARAM_RTK_LOCATION_LONGITUDE)];
+  const char* altStr = config->values[findParam(PARAM_RTK_LOCATION_ALTITUDE)];
+
+  config->hasLocation = latStr[0] != '\0' && lonStr[0] != '\0' && altStr[0] != '\0';
+  if (!config->hasLocation) return;
+
+  getIntPartsFromCSV(latStr, &config->location.lat, &config->location.lat_hp);
+  getIntPartsFromCSV(lonStr, &config->location.lon, &config->location.lon_hp);
+  getIntPartsFromCSV(altStr, &config->location.alt, &config->location.alt_hp);
+}
+
+// Older firmware stored the altitude like a coordinate, in 1e-9 m, and rejected
+// everything above 214 m. Such a value is out of range as cm, convert it once.
+static void migrateAltitude(char* value, size_t size) {
+  using namespace RTKBaseManager;
+  if (value[0] == '\0') return;
+  int32_t cm;
+  int8_t hp;
+  getIntPartsFromCSV(value, &cm, &hp);
+  if (cm >= ALTITUDE_MIN_M * 100 && cm <= ALTITUDE_MAX_M * 100) return;
+  int64_t units = ((int64_t)cm * 100 + hp) / 100000;     // 1e-4 m
+  snprintf(value, size, "%ld,%d", (long)(units / 100), (int)(units % 100));
+  writeStored(PATH_RTK_LOCATION_ALTITUDE, value);
+}
+
+void RTKBaseManager::loadConfig() {
+  config_snapshot_t next;
+  memset(&next, 0, sizeof(next));
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    readStored(PARAM_TABLE[i].path, next.values[i], sizeof(next.values[i]));
+  }
+  int8_t alt = findParam(PARAM_RTK_LOCATION_ALTITUDE);
+  migrateAltitude(next.values[alt], sizeof(next.values[alt]));
+  parseLocation(&next);
+  publishConfig(&next);
+  updateDiscovery(&next);
+}
+
+void RTKBaseManager::publishConfig(config_snapshot_t* next) {
+  currentConfig.write(next, &next->version);
+}
+
+void RTKBaseManager::readConfig(config_snapshot_t* config) {
+  currentConfig.read(config);
+}
+
+uint32_t RTKBaseManager::configVersion() {
+  return currentConfig.writes();
+}
@@ -0,0 +1,49 @@
+#include <Discovery.h>
+#include <atomic>
+
+/********************************************************************************
+*                             mDNS services
+* ******************************************************************************/
+
+static std::atomic<bool> discoveryStarted(false);
+// Version of the snapshot in the TXT records, 0 before the first update
+static std::atomic<uint32_t> advertisedVersion(0);
+
+const char* RTKBaseManager::surveyState(const config_snapshot_t* config) {
+  const char* method = config->values[findParam(PARAM_RTK_LOCATION_METHOD)];
+  if (strcmp(method, PARAM_RTK_SURVEY_ENABLED) == 0) {
+    return config->hasLocation ? SURVEY_STATE_DONE : SURVEY_STATE_PENDING;
+  }
+  if (strcmp(method, PARAM_RTK_COORDS_ENABLED) == 0) return SURVEY_STATE_FIXED;
+  return SURVEY_STATE_NONE;
+}
+
+bool RTKBaseManager::startDiscovery(const char* deviceName) {
+  if (discoveryStarted) return true;
+  if (!MDNS.begin(deviceName)) return false;
+
+  MDNS.addService(SERVICE_HTTP, SERVICE_PROTO, SERVICE_PORT);
+  MDNS.addServiceTxt(SERVICE_HTTP, SERVICE_PROTO, "path", "/");
+  MDNS.addService(SERVICE_RTKBASE, SERVICE_PROTO, SERVICE_PORT);
+  MDNS.addServiceTxt(SERVICE_RTKBASE, SERVICE_PROTO, TXT_FIRMWARE, FIRMWARE_VERSION);
+  discoveryStarted = true;
+
+  // The config was loaded before the WiFi came up
+  config_snapshot_t config;
+  readConfig(&config);
+  updateDiscovery(&config);
+  return true;
+}
+
+void RTKBaseManager::updateDiscovery(const config_snapshot_t* config) {
+  if (!discoveryStarted) return;
+  // Every TXT change is announced on the network, skip known versions
+  if (advertisedVersion.exchange(config->version) == config->version) return;
+
+  char version[11];
+  snprintf(version, sizeof(version), "%u", (unsigned int)config->version);
+  MDNS.addServiceTxt(SERVICE_RTKBASE, SERVICE_PROTO, TXT_MOUNT_POINT, config->values[findParam(PARAM_RTK_MOINT_POINT)]);
+  MDNS.addServiceTxt(SERVICE_RTKBASE, SERVICE_PROTO, TXT_LOCATION_METHOD, config->values[findParam(PARAM_RTK_LOCATION_METHOD)]);
+  MDNS.addServiceTxt(SERVICE_RTKBASE, SERVICE_PROTO, TXT_SURVEY_STATE, surveyState(config));
+  MDNS.addServiceTxt(SERVICE_RTKBASE, SERVICE_PROTO, TXT_CONFIG_VERSION, version);
+}
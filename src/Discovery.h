@@ -0,0 +1,64 @@
+/**
+ * @file    Discovery.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   mDNS service advertisement: the web server as _http._tcp and the
+ *          base station as _rtkbase._tcp. The TXT records of _rtkbase carry
+ *          firmware, mount point, location method, survey state and config
+ *          version, so a fleet is found and checked by browsing, without
+ *          polling /api/status of every device. The records are updated
+ *          whenever a new config is loaded.
+ */
+
+#ifndef DISCOVERY_H
+#define DISCOVERY_H
+
+#include <Arduino.h>
+#include <RTKBaseManager.h>
+
+namespace RTKBaseManager {
+  constexpr char SERVICE_HTTP[] PROGMEM = "http";
+  constexpr char SERVICE_RTKBASE[] PROGMEM = "rtkbase";
+  constexpr char SERVICE_PROTO[] PROGMEM = "tcp";
+  const uint16_t SERVICE_PORT = 80;
+
+  constexpr char TXT_FIRMWARE[] PROGMEM = "fw";
+  constexpr char TXT_MOUNT_POINT[] PROGMEM = "mount";
+  constexpr char TXT_LOCATION_METHOD[] PROGMEM = "method";
+  constexpr char TXT_SURVEY_STATE[] PROGMEM = "survey";
+  constexpr char TXT_CONFIG_VERSION[] PROGMEM = "cfg";
+
+  constexpr char SURVEY_STATE_NONE[] PROGMEM = "none";        // no location method saved
+  constexpr char SURVEY_STATE_PENDING[] PROGMEM = "pending";  // survey enabled, no location yet
+  constexpr char SURVEY_STATE_DONE[] PROGMEM = "done";        // survey enabled, location saved
+  constexpr char SURVEY_STATE_FIXED[] PROGMEM = "fixed";      // coordinates entered
+
+  /**
+   * @brief Start mDNS and advertise the services, call once connected as station
+   *
+   * @param deviceName  Host name, reachable as <deviceName>.local
+   * @return true       If mDNS is running
+   * @return false      If mDNS could not be started
+   */
+  bool startDiscovery(const char* deviceName);
+
+  /**
+   * @brief Set the TXT records of _rtkbase._tcp from a config snapshot,
+   *        does nothing before startDiscovery() or if the version was
+   *        already advertised
+   *
+   * @param config  Published snapshot
+   */
+  void updateDiscovery(const config_snapshot_t* config);
+
+  /**
+   * @brief Survey state of a config snapshot as advertised in the TXT record
+   *
+   * @param config        Snapshot
+   * @return const char*  One of the SURVEY_STATE_* strings
+   */
+  const char* surveyState(const config_snapshot_t* config);
+}
+
+#endif /*** DISCOVERY_H ***/
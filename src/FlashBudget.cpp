@@ -0,0 +1,393 @@
+#include <FlashBudget.h>
+#include <Storage.h>
+#include <TaskRuntime.h>
+#include <Preferences.h>
+#include <esp_partition.h>
+#include <freertos/semphr.h>
+
+using RTKBaseManager::flash_hour_t;
+using RTKBaseManager::flash_ledger_t;
+using RTKBaseManager::flash_path_stats_t;
+
+/********************************************************************************
+*                             Ledger
+* ******************************************************************************/
+
+static const uint32_t MINUTE_MS = 60000;
+static const uint32_t HOURS_PER_YEAR = 8760;
+// Kept apart from the values so the counters survive a wipe
+static const char LEDGER_NAMESPACE[] = "rtkflash";
+static const char KEY_HOURS[] = "hours";
+static const char KEY_WIPES[] = "wipes";
+static const char KEY_PATHS[] = "paths";
+static const char KEY_HOURLY[] = "hourly";
+static const char KEY_MINUTES[] = "minutes";
+static const uint32_t CLOCK_MAGIC = 0x484F5552;   // "HOUR"
+
+// Service time, not initialized at boot: after a reset that is not a power cycle
+// it is newer than the ledger in NVS, so a base rebooting often still moves on
+typedef struct {
+  uint32_t magic;
+  uint32_t checksum;      // of everything behind it
+  uint32_t serviceHours;
+  uint32_t minutes;       // into the current hour
+} service_clock_t;
+
+RTC_NOINIT_ATTR static service_clock_t serviceClock;
+
+static flash_ledger_t ledger;
+static uint32_t lastErases = 0;                   // of getFlashStats() when the hour began
+static uint8_t minutes = 0;                       // into the current service hour
+static SemaphoreHandle_t flashLock = nullptr;     // flash writes can not run in a critical section
+static TaskHandle_t budgetTask = nullptr;
+
+// Writes over the budget, the latest value per PARAM_TABLE entry
+static char held[RTKBaseManager::PARAM_COUNT][RTKBaseManager::CONFIG_VALUE_MAX_LEN + 1];
+static bool isHeld[RTKBaseManager::PARAM_COUNT];
+static uint8_t heldCount = 0;
+
+// No lock before startFlashBudget(), setup() is the only writer then
+static void lockFlash() {
+  if (flashLock != nullptr) xSemaphoreTake(flashLock, portMAX_DELAY);
+}
+
+static void unlockFlash() {
+  if (flashLock != nullptr) xSemaphoreGive(flashLock);
+}
+
+// Derived entries share the path of their source, the first entry counts
+static uint8_t pathSlot(const char* path) {
+  using namespace RTKBaseManager;
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    if (PARAM_TABLE[i].check != CHECK_NONE && strcmp(PARAM_TABLE[i].path, path) == 0) return i;
+  }
+  return FLASH_OTHER_PATH;
+}
+
+static flash_hour_t* thisHour() {
+  return &ledger.hours[ledger.serviceHours % FLASH_BUDGET_HOURS];
+}
+
+static uint32_t clockChecksum(const service_clock_t* clock) {
+  const uint8_t* data = (const uint8_t*)&clock->serviceHours;
+  size_t len = sizeof(service_clock_t) - offsetof(service_clock_t, serviceHours);
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++) hash = (hash ^ data[i]) * 16777619u;
+  return hash;
+}
+
+static void tickClock() {
+  serviceClock.magic = CLOCK_MAGIC;
+  serviceClock.serviceHours = ledger.serviceHours;
+  serviceClock.minutes = minutes;
+  serviceClock.checksum = clockChecksum(&serviceClock);
+}
+
+// Under flashLock, the counters of the slot are from FLASH_BUDGET_HOURS ago
+static void nextHour() {
+  ledger.serviceHours++;
+  minutes = 0;
+  memset(thisHour(), 0, sizeof(flash_hour_t));
+}
+
+static void countWrite(uint8_t slot, uint32_t bytes) {
+  ledger.paths[slot].writes++;
+  ledger.paths[slot].bytes += bytes;
+  thisHour()->writes++;
+  thisHour()->bytes += bytes;
+}
+
+static void dropHeld(uint8_t slot) {
+  if (slot == RTKBaseManager::FLASH_OTHER_PATH || !isHeld[slot]) return;
+  isHeld[slot] = false;
+  heldCount--;
+}
+
+// Under flashLock, force ignores the budget
+static void writeHeld(bool force) {
+  using namespace RTKBaseManager;
+  for (uint8_t i = 0; i < PARAM_COUNT && heldCount > 0; i++) {
+    if (!isHeld[i]) continue;
+    uint32_t cost = flashWriteCost(strlen(held[i]));
+    if (!force && !withinFlashBudget(thisHour(), cost)) break;
+    // Left held if the write fails, the next hour tries again
+    if (!activeStorage()->write(PARAM_TABLE[i].path, held[i])) continue;
+    countWrite(i, cost);
+    dropHeld(i);
+  }
+}
+
+static void loadLedger() {
+  using namespace RTKBaseManager;
+  memset(&ledger, 0, sizeof(ledger));
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    if (PARAM_TABLE[i].check == CHECK_NONE) continue;
+    ledger.paths[i].hash = PerfectHash::fnv1a(PARAM_TABLE[i].path, PerfectHash::FNV_OFFSET);
+  }
+
+  Preferences prefs;
+  if (!prefs.begin(LEDGER_NAMESPACE, true)) return;
+  ledger.serviceHours = prefs.getUInt(KEY_HOURS, 0);
+  minutes = prefs.getUChar(KEY_MINUTES, 0);
+  ledger.wipes = prefs.getUInt(KEY_WIPES, 0);
+  if (prefs.getBytesLength(KEY_HOURLY) == sizeof(ledger.hours)) {
+    prefs.getBytes(KEY_HOURLY, ledger.hours, sizeof(ledger.hours));
+  }
+
+  // The table may have changed since, entries are matched by the hash of the path
+  size_t len = prefs.getBytesLength(KEY_PATHS);
+  flash_path_stats_t* saved = (flash_path_stats_t*)malloc(len);
+  if (saved != nullptr && prefs.getBytes(KEY_PATHS, saved, len) == len) {
+    for (size_t n = 0; n < len / sizeof(flash_path_stats_t); n++) {
+      uint8_t slot = FLASH_OTHER_PATH;
+      for (uint8_t i = 0; i < PARAM_COUNT && saved[n].hash != 0; i++) {
+        if (ledger.paths[i].hash == saved[n].hash) slot = i;
+      }
+      flash_path_stats_t* stats = &ledger.paths[slot];
+      stats->writes += saved[n].writes;
+      stats->bytes += saved[n].bytes;
+      stats->deferred += saved[n].deferred;
+      stats->coalesced += saved[n].coalesced;
+    }
+  }
+  free(saved);
+  prefs.end();
+}
+
+// The clock of the last boot is ahead of NVS if the base did not power cycle since
+static void resumeClock() {
+  bool valid = serviceClock.magic == CLOCK_MAGIC && serviceClock.checksum == clockChecksum(&serviceClock) &&
+               serviceClock.minutes < 60;
+  if (!valid) return;
+  if (serviceClock.serviceHours < ledger.serviceHours ||
+      (serviceClock.serviceHours == ledger.serviceHours && serviceClock.minutes <= minutes)) return;
+  uint32_t behind = serviceClock.serviceHours - ledger.serviceHours;
+  for (uint32_t h = 0; h < behind && h < FLASH_BUDGET_HOURS; h++) nextHour();
+  ledger.serviceHours = serviceClock.serviceHours;
+  minutes = serviceClock.minutes;
+}
+
+// Under flashLock, NVS skips the unchanged keys
+static void saveLedger() {
+  Preferences prefs;
+  if (!prefs.begin(LEDGER_NAMESPACE, false)) return;
+  prefs.putUInt(KEY_HOURS, ledger.serviceHours);
+  prefs.putUChar(KEY_MINUTES, minutes);
+  prefs.putUInt(KEY_WIPES, ledger.wipes);
+  prefs.putBytes(KEY_PATHS, ledger.paths, sizeof(ledger.paths));
+  prefs.putBytes(KEY_HOURLY, ledger.hours, sizeof(ledger.hours));
+  prefs.end();
+}
+
+/********************************************************************************
+*                             Budget
+* ******************************************************************************/
+
+bool RTKBaseManager::withinFlashBudget(const flash_hour_t* hour, uint32_t bytes) {
+  return hour->writes < FLASH_BUDGET_WRITES && hour->bytes + bytes <= FLASH_BUDGET_BYTES;
+}
+
+uint32_t RTKBaseManager::flashWriteCost(size_t len) {
+  return len + FLASH_WRITE_OVERHEAD;
+}
+
+uint32_t RTKBaseManager::flashLifetimeYears(uint32_t sectors, uint32_t erases, uint32_t hours) {
+  if (erases == 0 || hours == 0) return UINT32_MAX;
+  // Wear leveling spreads the erases over all sectors of the partition
+  uint64_t years = (uint64_t)sectors * FLASH_ENDURANCE_CYCLES * hours / ((uint64_t)erases * HOURS_PER_YEAR);
+  return (years < UINT32_MAX) ? (uint32_t)years : UINT32_MAX;
+}
+
+bool RTKBaseManager::budgetedWrite(const char* path, const char* value) {
+  uint8_t slot = pathSlot(path);
+  size_t len = strlen(value);
+  uint32_t cost = flashWriteCost(len);
+  char stored[CONFIG_VALUE_MAX_LEN + 1];
+  bool success = true;
+
+  lockFlash();
+  flash_path_stats_t* stats = &ledger.paths[slot];
+  bool unchanged = activeStorage()->read(path, stored, sizeof(stored)) == len && strcmp(stored, value) == 0;
+  bool holdable = budgetTask != nullptr && slot != FLASH_OTHER_PATH && len < sizeof(held[0]);
+
+  if (slot != FLASH_OTHER_PATH && isHeld[slot]) {
+    // Still over the budget until the next hour, the latest value wins
+    stats->coalesced++;
+    if (unchanged || !holdable) {
+      dropHeld(slot);
+    } else {
+      memcpy(held[slot], value, len + 1);
+      unlockFlash();
+      return true;
+    }
+  } else if (unchanged) {
+    stats->coalesced++;
+  }
+
+  if (!unchanged) {
+    if (holdable && !withinFlashBudget(thisHour(), cost)) {
+      DEBUG_SERIAL.printf("Flash budget of the hour used up, holding %s\r\n", path);
+      memcpy(held[slot], value, len + 1);
+      isHeld[slot] = true;
+      heldCount++;
+      stats->deferred++;
+      thisHour()->deferred++;
+    } else {
+      success = activeStorage()->write(path, value);
+      countWrite(slot, cost);
+    }
+  }
+  unlockFlash();
+  return success;
+}
+
+bool RTKBaseManager::budgetedRemove(const char* path) {
+  uint8_t slot = pathSlot(path);
+  lockFlash();
+  bool wasHeld = slot != FLASH_OTHER_PATH && isHeld[slot];
+  dropHeld(slot);
+  bool success = activeStorage()->remove(path);
+  if (success) countWrite(slot, FLASH_WRITE_OVERHEAD);
+  unlockFlash();
+  return success || wasHeld;
+}
+
+void RTKBaseManager::budgetedWipe() {
+  lockFlash();
+  memset(isHeld, 0, sizeof(isHeld));
+  heldCount = 0;
+  activeStorage()->wipe();
+  ledger.wipes++;
+  unlockFlash();
+}
+
+size_t RTKBaseManager::readHeldWrite(const char* path, char* out, size_t outLen) {
+  if (heldCount == 0 || outLen == 0) return 0;
+  uint8_t slot = pathSlot(path);
+  size_t len = 0;
+  lockFlash();
+  if (slot != FLASH_OTHER_PATH && isHeld[slot]) {
+    len = strlen(held[slot]);
+    if (len >= outLen) len = outLen - 1;
+    memcpy(out, held[slot], len);
+    out[len] = '\0';
+  }
+  unlockFlash();
+  return len;
+}
+
+void RTKBaseManager::flushFlashWrites() {
+  if (budgetTask == nullptr) return;
+  lockFlash();
+  writeHeld(true);
+  saveLedger();
+  unlockFlash();
+}
+
+uint8_t RTKBaseManager::getFlashLedger(flash_ledger_t* copy) {
+  lockFlash();
+  memcpy(copy, &ledger, sizeof(flash_ledger_t));
+  uint8_t count = heldCount;
+  unlockFlash();
+  return count;
+}
+
+/********************************************************************************
+*                             Hourly task
+* ******************************************************************************/
+
+static void budgetLoop(void* parameter) {
+  using namespace RTKBaseManager;
+  TickType_t wake = xTaskGetTickCount();
+  while (true) {
+    // Counted in ticks, millis() wraps after 49 days. The minutes go on over
+    // reboots, a base that reboots within the hour does not stay in it
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(MINUTE_MS));
+    lockFlash();
+    bool rollover = ++minutes >= 60;
+    if (!rollover) {
+      tickClock();
+      unlockFlash();
+      continue;
+    }
+    unlockFlash();
+
+    flash_stats_t flash;
+    getFlashStats(&flash);
+    lockFlash();
+    thisHour()->erases = flash.erases - lastErases;
+    lastErases = flash.erases;
+    nextHour();
+    tickClock();
+    writeHeld(false);
+    if (ledger.serviceHours % FLASH_LEDGER_SAVE_HOURS == 0) saveLedger();
+    unlockFlash();
+  }
+}
+
+void RTKBaseManager::startFlashBudget() {
+  if (budgetTask != nullptr) return;
+  loadLedger();
+  resumeClock();
+  tickClock();
+  flash_stats_t flash;
+  getFlashStats(&flash);
+  lastErases = flash.erases;
+  flashLock = xSemaphoreCreateMutex();
+  if (!spawnTask(TASK_ROLE_BACKGROUND, budgetLoop, "flashBudget", 4096, nullptr, &budgetTask)) {
+    DEBUG_SERIAL.println(F("Flash budget task not started, writes are not limited"));
+  }
+}
+
+/********************************************************************************
+*                             API
+* ******************************************************************************/
+
+void RTKBaseManager::actionFlash(AsyncWebServerRequest *request) {
+  flash_ledger_t copy;
+  uint8_t heldWrites = getFlashLedger(&copy);
+
+  uint32_t bytes = 0;
+  for (uint8_t i = 0; i < FLASH_PATH_COUNT; i++) bytes += copy.paths[i].bytes;
+  uint32_t erases = bytes / FLASH_SECTOR_SIZE;
+  const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                              (STORAGE_BACKEND == STORAGE_NVS) ? "nvs" : "spiffs");
+  uint32_t sectors = (partition != nullptr) ? partition->size / FLASH_SECTOR_SIZE : 0;
+  uint32_t years = flashLifetimeYears(sectors, erases, copy.serviceHours + 1);
+  const flash_hour_t* hour = &copy.hours[copy.serviceHours % FLASH_BUDGET_HOURS];
+
+  char json[FLASH_PATH_COUNT * 140 + FLASH_BUDGET_HOURS * 48 + 400];
+  size_t len = snprintf(json, sizeof(json),
+                        "{\"service_hours\":%u,\"wipes\":%u,\"held\":%u,\"budget\":{\"writes\":%u,\"bytes\":%u},"
+                        "\"hour\":{\"writes\":%u,\"bytes\":%u,\"deferred\":%u},\"bytes\":%u,\"erase_estimate\":%u,\"sectors\":%u,",
+                        (unsigned int)copy.serviceHours, (unsigned int)copy.wipes, heldWrites, FLASH_BUDGET_WRITES, FLASH_BUDGET_BYTES,
+                        hour->writes, (unsigned int)hour->bytes, hour->deferred, (unsigned int)bytes, (unsigned int)erases,
+                        (unsigned int)sectors);
+  if (len < sizeof(json)) {
+    len += (years == UINT32_MAX) ? snprintf(json + len, sizeof(json) - len, "\"lifetime_years\":null,\"paths\":[")
+                                 : snprintf(json + len, sizeof(json) - len, "\"lifetime_years\":%u,\"paths\":[", (unsigned int)years);
+  }
+
+  bool first = true;
+  for (uint8_t i = 0; i < FLASH_PATH_COUNT && len < sizeof(json); i++) {
+    const flash_path_stats_t& p = copy.paths[i];
+    if (p.writes == 0 && p.deferred == 0 && p.coalesced == 0) continue;
+    len += snprintf(json + len, sizeof(json) - len,
+                    "%s{\"path\":\"%s\",\"writes\":%u,\"bytes\":%u,\"erase_estimate\":%u,\"deferred\":%u,\"coalesced\":%u}",
+                    first ? "" : ",", (i == FLASH_OTHER_PATH) ? "other" : PARAM_TABLE[i].path, (unsigned int)p.writes,
+                    (unsigned int)p.bytes, (unsigned int)(p.bytes / FLASH_SECTOR_SIZE), (unsigned int)p.deferred,
+                    (unsigned int)p.coalesced);
+    first = false;
+  }
+
+  // [writes, bytes, deferred, erases] per hour, oldest first, the last one is this hour
+  if (len < sizeof(json)) len += snprintf(json + len, sizeof(json) - len, "],\"hours\":[");
+  uint32_t count = (copy.serviceHours + 1 < FLASH_BUDGET_HOURS) ? copy.serviceHours + 1 : FLASH_BUDGET_HOURS;
+  for (uint32_t n = 0; n < count && len < sizeof(json); n++) {
+    const flash_hour_t& h = copy.hours[(copy.serviceHours + 1 - count + n) % FLASH_BUDGET_HOURS];
+    len += snprintf(json + len, sizeof(json) - len, "%s[%u,%u,%u,%u]", (n == 0) ? "" : ",",
+                    h.writes, (unsigned int)h.bytes, h.deferred, (unsigned int)h.erases);
+  }
+  if (len < sizeof(json)) snprintf(json + len, sizeof(json) - len, "]}");
+  request->send(200, "application/json", json);
+}
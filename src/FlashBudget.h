@@ -0,0 +1,149 @@
+/**
+ * @file    FlashBudget.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Accounting and an hourly budget of the config writes to flash.
+ *          writeStored(), removeStored() and wipeStorage() are counted per
+ *          path and per hour of service: writes, bytes (the value plus
+ *          FLASH_WRITE_OVERHEAD of file system or NVS metadata) and the
+ *          sector erases they cost. The counters are kept in NVS every
+ *          FLASH_LEDGER_SAVE_HOURS and before every restart of the firmware,
+ *          so they add up over the years in service. The service hour goes
+ *          on over reboots, the minutes into it are kept in RTC memory.
+ *
+ *          A write of an unchanged value is skipped. A write over the budget
+ *          of the hour (FLASH_BUDGET_WRITES, FLASH_BUDGET_BYTES) is held in
+ *          RAM and written at the next hour; a later write of the same path
+ *          replaces it, so a script posting the same form again and again
+ *          costs one write per hour. readStored() returns a held value, a
+ *          restart of the firmware writes all of them first.
+ *
+ *          GET /api/flash  -> counters per path and hour, lifetime estimate
+ */
+
+#ifndef FLASH_BUDGET_H
+#define FLASH_BUDGET_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <RTKBaseManager.h>
+
+namespace RTKBaseManager {
+  const uint8_t  FLASH_OTHER_PATH = PARAM_COUNT;          // paths outside PARAM_TABLE, never held
+  const uint8_t  FLASH_PATH_COUNT = PARAM_COUNT + 1;
+  const uint32_t FLASH_SECTOR_SIZE = 4096;                // erase unit of the SPI flash
+
+typedef struct {
+  uint32_t hash;          // fnv1a of the path, finds the entry again after a table change
+  uint32_t writes;        // to flash, removes included
+  uint32_t bytes;         // estimated flash bytes of these writes
+  uint32_t deferred;      // held over the budget
+  uint32_t coalesced;     // skipped as unchanged or replaced while held
+} flash_path_stats_t;
+
+typedef struct {
+  uint32_t bytes;
+  uint16_t writes;
+  uint16_t deferred;
+  uint32_t erases;        // measured sector erases, only with RTK_FLASH_TRACKING
+} flash_hour_t;
+
+typedef struct {
+  uint32_t            serviceHours;                       // hours of uptime over all boots
+  uint32_t            wipes;
+  flash_path_stats_t  paths[FLASH_PATH_COUNT];            // indexed like PARAM_TABLE, then other paths
+  flash_hour_t        hours[FLASH_BUDGET_HOURS];          // by service hour % FLASH_BUDGET_HOURS
+} flash_ledger_t;
+
+  /**
+   * @brief Load the counters of the last boots and start the hourly task,
+   *        call after setupStorage(). Writes before are not budgeted.
+   */
+  void startFlashBudget(void);
+
+  /**
+   * @brief Write a value within the budget, hold it if over, see writeStored()
+   *
+   * @param path    Path of the value
+   * @param value   Value
+   * @return true   If written, unchanged or held
+   * @return false  If the write failed
+   */
+  bool budgetedWrite(const char* path, const char* value);
+
+  /**
+   * @brief Remove a value and drop a held write of it, see removeStored()
+   *
+   * @param path    Path of the value
+   * @return true   If the value was removed
+   * @return false  If it did not exist
+   */
+  bool budgetedRemove(const char* path);
+
+  /**
+   * @brief Wipe all values and drop the held writes, see wipeStorage()
+   */
+  void budgetedWipe(void);
+
+  /**
+   * @brief Copy a held value
+   *
+   * @param path    Path of the value
+   * @param out     Buffer, zero terminated
+   * @param outLen  Size of the buffer
+   * @return size_t Length of the value, 0 if none is held
+   */
+  size_t readHeldWrite(const char* path, char* out, size_t outLen);
+
+  /**
+   * @brief Write all held values regardless of the budget and save the
+   *        counters, call before an intended restart
+   */
+  void flushFlashWrites(void);
+
+  /**
+   * @brief Check if a write fits into the budget of an hour
+   *
+   * @param hour    Counters of the hour
+   * @param bytes   Estimated flash bytes of the write
+   * @return true   If it fits
+   */
+  bool withinFlashBudget(const flash_hour_t* hour, uint32_t bytes);
+
+  /**
+   * @brief Estimate the flash bytes of a write
+   *
+   * @param len       Length of the value
+   * @return uint32_t Value plus FLASH_WRITE_OVERHEAD
+   */
+  uint32_t flashWriteCost(size_t len);
+
+  /**
+   * @brief Estimate the lifetime of a wear leveled partition
+   *
+   * @param sectors   Sectors of the partition
+   * @param erases    Sector erases so far
+   * @param hours     Hours in service so far
+   * @return uint32_t Years until every sector reached FLASH_ENDURANCE_CYCLES
+   *                  at the rate so far, UINT32_MAX without wear
+   */
+  uint32_t flashLifetimeYears(uint32_t sectors, uint32_t erases, uint32_t hours);
+
+  /**
+   * @brief Get the counters
+   *
+   * @param ledger  Address of the struct to write to
+   * @return uint8_t Number of held writes
+   */
+  uint8_t getFlashLedger(flash_ledger_t* ledger);
+
+  /**
+   * @brief Handler of /api/flash
+   *
+   * @param request Request
+   */
+  void actionFlash(AsyncWebServerRequest *request);
+}
+
+#endif /*** FLASH_BUDGET_H ***/
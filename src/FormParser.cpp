@@ -0,0 +1,245 @@
+#include <FormParser.h>
+#include <TaskRuntime.h>
+#include <RtcmScheduler.h>
+
+/********************************************************************************
+*                             Decoding
+* ******************************************************************************/
+
+static int8_t hexValue(uint8_t c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static bool failForm(RTKBaseManager::form_parser_t* form, RTKBaseManager::form_error_t error) {
+  if (form->error == RTKBaseManager::FORM_OK) {
+    form->error = error;
+    form->errorField = form->field;
+  }
+  return false;
+}
+
+static void selectField(RTKBaseManager::form_parser_t* form) {
+  form->name[form->nameLen] = '\0';
+  int8_t idx = RTKBaseManager::findParam(form->name);
+  // Unknown fields like save_button and read only placeholders are skipped
+  if (idx == RTKBaseManager::PARAM_NONE || RTKBaseManager::PARAM_TABLE[idx].check == RTKBaseManager::CHECK_NONE) {
+    form->field = RTKBaseManager::FORM_NO_FIELD;
+    return;
+  }
+  form->field = idx;
+  // The last of repeated fields wins
+  form->lengths[form->field] = 0;
+  form->values[form->field][0] = '\0';
+}
+
+static bool appendValueChar(RTKBaseManager::form_parser_t* form, uint8_t c) {
+  if (form->field == RTKBaseManager::FORM_NO_FIELD) return true;
+  uint8_t& len = form->lengths[form->field];
+  if (len >= RTKBaseManager::FORM_VALUE_MAX_LEN) return failForm(form, RTKBaseManager::FORM_ERR_TOO_LONG);
+  if (c < 0x20 || c > 0x7E) return failForm(form, RTKBaseManager::FORM_ERR_CHARACTER);
+  form->values[form->field][len++] = (char)c;
+  form->values[form->field][len] = '\0';
+  return true;
+}
+
+static bool appendDecoded(RTKBaseManager::form_parser_t* form, uint8_t c) {
+  if (form->state == RTKBaseManager::FORM_STATE_VALUE) return appendValueChar(form, c);
+  // Names longer than any table name can not match, keep them unknown
+  if (form->nameLen < RTKBaseManager::FORM_NAME_MAX_LEN) {
+    form->name[form->nameLen++] = (char)c;
+  } else {
+    form->name[0] = '\0';
+  }
+  return true;
+}
+
+static void endField(RTKBaseManager::form_parser_t* form) {
+  form->state = RTKBaseManager::FORM_STATE_NAME;
+  form->field = RTKBaseManager::FORM_NO_FIELD;
+  form->nameLen = 0;
+}
+
+void RTKBaseManager::beginForm(form_parser_t* form) {
+  memset(form, 0, sizeof(form_parser_t));
+  form->state = FORM_STATE_NAME;
+  form->field = FORM_NO_FIELD;
+  form->errorField = FORM_NO_FIELD;
+  form->error = FORM_OK;
+}
+
+bool RTKBaseManager::feedForm(form_parser_t* form, const uint8_t* data, size_t len) {
+  if (form->error != FORM_OK) return false;
+
+  for (size_t i = 0; i < len; i++) {
+    uint8_t c = data[i];
+
+    if (form->escape > 0) {
+      int8_t nibble = hexValue(c);
+      if (nibble < 0) return failForm(form, FORM_ERR_ENCODING);
+      form->escaped = (form->escaped << 4) | nibble;
+      if (--form->escape == 0 && !appendDecoded(form, form->escaped)) return false;
+      continue;
+    }
+
+    switch (c) {
+      case '%':
+        form->escape = 2;
+        form->escaped = 0;
+        break;
+      case '+':
+        if (!appendDecoded(form, ' ')) return false;
+        break;
+      case '=':
+        if (form->state == FORM_STATE_NAME) {
+          selectField(form);
+          form->state = FORM_STATE_VALUE;
+        } else if (!appendValueChar(form, c)) {
+          return false;
+        }
+        break;
+      case '&':
+        endField(form);
+        break;
+      default:
+        if (!appendDecoded(form, c)) return false;
+        break;
+    }
+  }
+  return true;
+}
+
+bool RTKBaseManager::putFormField(form_parser_t* form, const char* name, const char* value, size_t len) {
+  if (form->error != FORM_OK) return false;
+
+  size_t nameLen = strlen(name);
+  if (nameLen > FORM_NAME_MAX_LEN) return true;
+  memcpy(form->name, name, nameLen);
+  form->nameLen = nameLen;
+  selectField(form);
+  form->state = FORM_STATE_VALUE;
+  for (size_t i = 0; i < len; i++) {
+    if (!appendValueChar(form, (uint8_t)value[i])) return false;
+  }
+  endField(form);
+  return true;
+}
+
+bool RTKBaseManager::endForm(form_parser_t* form) {
+  if (form->error != FORM_OK) return false;
+  if (form->escape > 0) return failForm(form, FORM_ERR_ENCODING);
+  endField(form);
+
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    if (form->lengths[i] == 0) continue;
+    form_error_t error = checkParamValue(&PARAM_TABLE[i], form->values[i], form->lengths[i]);
+    if (error != FORM_OK) {
+      form->error = error;
+      form->errorField = i;
+      return false;
+    }
+  }
+  return true;
+}
+
+uint8_t RTKBaseManager::commitForm(const form_parser_t* form) {
+  uint8_t saved = 0;
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    if (form->lengths[i] == 0) continue;
+    if (storeParam(&PARAM_TABLE[i], form->values[i])) saved++;
+  }
+  return saved;
+}
+
+/********************************************************************************
+*                             Validation
+* ******************************************************************************/
+
+// Accepts [-]d[.d], counts the digits before and after the dot
+static bool scanDecimal(const char* value, size_t len, bool allowSign, uint8_t* intDigits, uint8_t* decimals) {
+  size_t i = 0;
+  bool dot = false;
+  *intDigits = 0;
+  *decimals = 0;
+
+  if (allowSign && len > 0 && value[0] == '-') i++;
+  for (; i < len; i++) {
+    char c = value[i];
+    if (c == '.' && !dot) {
+      dot = true;
+    } else if (c >= '0' && c <= '9') {
+      dot ? (*decimals)++ : (*intDigits)++;
+    } else {
+      return false;
+    }
+  }
+  return *intDigits > 0 && (!dot || *decimals > 0);
+}
+
+static RTKBaseManager::form_error_t checkDecimal(const char* value, size_t len, bool allowSign,
+                                                  uint8_t maxIntDigits, uint8_t minDecimals, uint8_t maxDecimals,
+                                                  double minVal, double maxVal) {
+  uint8_t intDigits, decimals;
+  if (!scanDecimal(value, len, allowSign, &intDigits, &decimals)) return RTKBaseManager::FORM_ERR_FORMAT;
+  if (intDigits > maxIntDigits || decimals < minDecimals || decimals > maxDecimals) return RTKBaseManager::FORM_ERR_FORMAT;
+  double d = strtod(value, nullptr);
+  return (d < minVal || d > maxVal) ? RTKBaseManager::FORM_ERR_RANGE : RTKBaseManager::FORM_OK;
+}
+
+RTKBaseManager::form_error_t RTKBaseManager::checkParamValue(const param_entry_t* param, const char* value, size_t len) {
+  switch (param->check) {
+    case CHECK_TEXT:
+      // Values end up in HTML attributes and pass the template processor
+      for (size_t i = 0; i < len; i++) {
+        if (strchr("\"<>&%", value[i]) != nullptr) return FORM_ERR_CHARACTER;
+      }
+      return FORM_OK;
+    case CHECK_SECRET:
+      // Control characters were already rejected while decoding
+      return FORM_OK;
+    case CHECK_HOST:
+      for (size_t i = 0; i < len; i++) {
+        char c = value[i];
+        if (!isalnum(c) && c != '.' && c != '-') return FORM_ERR_CHARACTER;
+      }
+      return FORM_OK;
+    case CHECK_PORT:
+      return checkDecimal(value, len, false, 5, 0, 0, 1, 65535);
+    case CHECK_METHOD:
+      return (strcmp(value, PARAM_RTK_SURVEY_ENABLED) == 0 || strcmp(value, PARAM_RTK_COORDS_ENABLED) == 0) ? FORM_OK : FORM_ERR_FORMAT;
+    case CHECK_ACCURACY:
+      return checkDecimal(value, len, false, 3, 0, 3, 0.001, 999.0);
+    case CHECK_LATITUDE:
+      return checkDecimal(value, len, true, 2, 7, 9, -90.0, 90.0);
+    case CHECK_LONGITUDE:
+      return checkDecimal(value, len, true, 3, 7, 9, -180.0, 180.0);
+    case CHECK_ALTITUDE:
+      // Stored in 0.1 mm, see getAltitudeAsCSV()
+      return checkDecimal(value, len, true, 4, 0, 4, ALTITUDE_MIN_M, ALTITUDE_MAX_M);
+    case CHECK_PROFILE:
+      return (findRuntimeProfile(value) != nullptr) ? FORM_OK : FORM_ERR_FORMAT;
+    case CHECK_SWITCH:
+      return (strcmp(value, SWITCH_ON) == 0 || strcmp(value, SWITCH_OFF) == 0) ? FORM_OK : FORM_ERR_FORMAT;
+    case CHECK_RATES: {
+      rate_schedule_t schedule;
+      return parseRates(&schedule, value) ? FORM_OK : FORM_ERR_FORMAT;
+    }
+    case CHECK_NONE:
+    default:
+      return FORM_ERR_CHARACTER;
+  }
+}
+
+const char* RTKBaseManager::formErrorText(form_error_t error) {
+  switch (error) {
+    case FORM_OK:             return "ok";
+    case FORM_ERR_ENCODING:   return "broken url encoding";
+    case FORM_ERR_TOO_LONG:   return "value too long";
+    case FORM_ERR_CHARACTER:  return "character not allowed";
+    case FORM_ERR_FORMAT:     return "wrong number format";
+    case FORM_ERR_RANGE:      return "number out of range";
+    default:                  return "unknown error";
+  }
+}
@@ -0,0 +1,122 @@
+/**
+ * @file    FormParser.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Incremental application/x-www-form-urlencoded parser for the config form.
+ *          Chunks are decoded in place into one fixed size buffer per PARAM_TABLE
+ *          entry, so a POST costs no String per field. Lengths, characters and
+ *          numeric formats are checked before anything is written to the storage.
+ */
+
+#ifndef FORM_PARSER_H
+#define FORM_PARSER_H
+
+#include <Arduino.h>
+#include <RTKBaseManager.h>
+
+namespace RTKBaseManager {
+  // Same as maxlength of the input fields in index_html.h
+  const uint8_t FORM_VALUE_MAX_LEN = 30;
+  const uint8_t FORM_NAME_MAX_LEN = 31;
+  const int8_t  FORM_NO_FIELD = -1;
+  // Content type the index page uses to post the form as body, the
+  // ESPAsyncWebServer only streams bodies it does not parse into params itself
+  constexpr char FORM_CONTENT_TYPE[] PROGMEM = "application/x-rtkbase-form";
+
+typedef enum {
+  FORM_OK,
+  FORM_ERR_ENCODING,    // broken percent escape
+  FORM_ERR_TOO_LONG,    // value longer than FORM_VALUE_MAX_LEN
+  FORM_ERR_CHARACTER,   // character not allowed for this field
+  FORM_ERR_FORMAT,      // not a number or wrong number of decimal places
+  FORM_ERR_RANGE        // number out of range
+} form_error_t;
+
+typedef enum {
+  FORM_STATE_NAME,
+  FORM_STATE_VALUE
+} form_state_t;
+
+typedef struct {
+  char          values[PARAM_COUNT][FORM_VALUE_MAX_LEN + 1]; // decoded values, indexed like PARAM_TABLE
+  uint8_t       lengths[PARAM_COUNT];                          // 0 if not posted or empty
+  char          name[FORM_NAME_MAX_LEN + 1];                   // name of the current field
+  uint8_t       nameLen;
+  int8_t        field;      // PARAM_TABLE index of the current field or FORM_NO_FIELD
+  form_state_t  state;
+  uint8_t       escape;     // remaining hex digits of a percent escape
+  uint8_t       escaped;    // high nibble of a percent escape
+  form_error_t  error;
+  int8_t        errorField; // PARAM_TABLE index of the field which failed
+} form_parser_t;
+
+  /**
+   * @brief Reset the parser for a new body
+   *
+   * @param form Parser state
+   */
+  void beginForm(form_parser_t* form);
+
+  /**
+   * @brief Decode the next chunk of a url encoded body, chunks may split
+   *        names, values and percent escapes anywhere
+   *
+   * @param form  Parser state
+   * @param data  Chunk
+   * @param len   Length of chunk
+   * @return true   If the form is still valid
+   * @return false  If an error was found, see form->error
+   */
+  bool feedForm(form_parser_t* form, const uint8_t* data, size_t len);
+
+  /**
+   * @brief Finish the body and validate all posted values
+   *
+   * @param form  Parser state
+   * @return true   If all values are valid and may be saved
+   * @return false  If an error was found, see form->error
+   */
+  bool endForm(form_parser_t* form);
+
+  /**
+   * @brief Put an already decoded field, used for bodies the web server parsed
+   *        into params itself. Call endForm() afterwards.
+   *
+   * @param form  Parser state
+   * @param name  Field name
+   * @param value Decoded value
+   * @param len   Length of value
+   * @return true   If the form is still valid
+   * @return false  If an error was found, see form->error
+   */
+  bool putFormField(form_parser_t* form, const char* name, const char* value, size_t len);
+
+  /**
+   * @brief Save all posted values of a valid form to the storage
+   *
+   * @param form  Parser state after endForm() returned true
+   * @return uint8_t Number of saved values
+   */
+  uint8_t commitForm(const form_parser_t* form);
+
+  /**
+   * @brief Check a posted value against the check of its table entry
+   *
+   * @param param   Table entry
+   * @param value   Zero terminated value
+   * @param len     Length of value
+   * @return form_error_t FORM_OK if the value is valid
+   */
+  form_error_t checkParamValue(const param_entry_t* param, const char* value, size_t len);
+
+  /**
+   * @brief Get a readable text of a form error
+   *
+   * @param error Error code
+   * @return const char* Error text
+   */
+  const char* formErrorText(form_error_t error);
+}
+
+#endif /*** FORM_PARSER_H ***/
@@ -0,0 +1,106 @@
+#include <GnssUart.h>
+#include <TaskRuntime.h>
+#include <driver/uart.h>
+
+using RTKBaseManager::gnss_uart_stats_t;
+
+static const uart_port_t PORT = (uart_port_t)GNSS_UART_NUM;
+// A burst of exactly n FIFO thresholds has no RX timeout event, it ends here
+static const TickType_t IDLE_TICKS = pdMS_TO_TICKS(10);
+
+static QueueHandle_t events = nullptr;
+static RTKBaseManager::gnss_burst_handler_t burstHandler = nullptr;
+static uint8_t burst[GNSS_UART_BURST_LEN];
+static size_t burstLen = 0;
+static gnss_uart_stats_t stats;
+
+static void deliverBurst(bool idle) {
+  if (burstLen == 0) return;
+  countBurst(&stats.bursts, burstLen, idle);
+  burstHandler(burst, burstLen);
+  burstLen = 0;
+}
+
+// The bytes of an event, a long burst fills the buffer more than once
+static void readData(size_t pending) {
+  while (pending > 0) {
+    size_t room = sizeof(burst) - burstLen;
+    int n = uart_read_bytes(PORT, burst + burstLen, (pending < room) ? pending : room, 0);
+    if (n <= 0) break;
+    burstLen += n;
+    pending -= n;
+    if (burstLen == sizeof(burst)) deliverBurst(false);
+  }
+}
+
+// What is left is stale, the framer finds the next preamble
+static void flushInput() {
+  deliverBurst(false);
+  uart_flush_input(PORT);
+  xQueueReset(events);
+}
+
+static void uartLoop(void* parameter) {
+  uart_event_t event;
+  while (true) {
+    if (xQueueReceive(events, &event, (burstLen > 0) ? IDLE_TICKS : portMAX_DELAY) != pdTRUE) {
+      deliverBurst(true);
+      continue;
+    }
+    switch (event.type) {
+      case UART_DATA:
+        readData(event.size);
+        if (event.timeout_flag) deliverBurst(true);
+        break;
+      case UART_FIFO_OVF:
+        stats.fifoOverflows++;
+        flushInput();
+        break;
+      case UART_BUFFER_FULL:
+        stats.bufferOverflows++;
+        flushInput();
+        break;
+      case UART_FRAME_ERR:
+        stats.frameErrors++;
+        break;
+      case UART_PARITY_ERR:
+        stats.parityErrors++;
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+bool RTKBaseManager::startGnssUart(gnss_burst_handler_t handler) {
+  if (stats.active) return true;
+  uart_config_t config;
+  memset(&config, 0, sizeof(config));
+  config.baud_rate = GNSS_BAUD;
+  config.data_bits = UART_DATA_8_BITS;
+  config.parity = UART_PARITY_DISABLE;
+  config.stop_bits = UART_STOP_BITS_1;
+  config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+  config.source_clk = UART_SCLK_APB;
+
+  // No TX buffer, commands to the receiver are short and written blocking
+  if (uart_driver_install(PORT, GNSS_UART_RX_BUFFER_LEN, 0, GNSS_UART_EVENT_QUEUE_LEN, &events, 0) != ESP_OK) {
+    DEBUG_SERIAL.println(F("GNSS UART driver not installed"));
+    return false;
+  }
+  if (uart_param_config(PORT, &config) != ESP_OK ||
+      uart_set_pin(PORT, GNSS_TX_PIN, GNSS_RX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK ||
+      uart_set_rx_timeout(PORT, GNSS_UART_RX_TIMEOUT) != ESP_OK) {
+    DEBUG_SERIAL.println(F("GNSS UART not configured"));
+    uart_driver_delete(PORT);
+    return false;
+  }
+  burstHandler = handler;
+  stats.baud = GNSS_BAUD;
+  stats.active = spawnTask(TASK_ROLE_GNSS_INGEST, uartLoop, "gnssUart", 4096, nullptr, nullptr);
+  return stats.active;
+}
+
+void RTKBaseManager::getGnssUartStats(gnss_uart_stats_t* copy) {
+  memcpy(copy, &stats, sizeof(gnss_uart_stats_t));
+}
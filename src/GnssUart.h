@@ -0,0 +1,54 @@
+/**
+ * @file    GnssUart.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Receiver port on the UART driver of the ESP-IDF, for 460800 and
+ *          921600 baud. The driver moves the FIFO into a ring buffer of
+ *          GNSS_UART_RX_BUFFER_LEN bytes from its interrupt and posts events,
+ *          the ingest task sleeps on the event queue instead of polling. The
+ *          RX timeout ends a burst when the line is idle for
+ *          GNSS_UART_RX_TIMEOUT symbols, the whole burst is handed on at once.
+ *          Overruns of the FIFO and of the ring buffer are counted, the input
+ *          is flushed and the framer resyncs on the next preamble.
+ */
+
+#ifndef GNSS_UART_H
+#define GNSS_UART_H
+
+#include <Arduino.h>
+#include <RTKBaseManager.h>
+#include <UartBurst.h>
+
+namespace RTKBaseManager {
+
+typedef void (*gnss_burst_handler_t)(const uint8_t* data, size_t len);
+
+typedef struct {
+  bool               active;          // driver installed and task running
+  uint32_t           baud;
+  uart_burst_stats_t bursts;
+  uint32_t           fifoOverflows;   // hardware FIFO, the interrupt came too late
+  uint32_t           bufferOverflows; // ring buffer, the ingest task fell behind
+  uint32_t           frameErrors;
+  uint32_t           parityErrors;
+} gnss_uart_stats_t;
+
+  /**
+   * @brief Install the UART driver on GNSS_UART_NUM and start the ingest task
+   *
+   * @param handler Gets every burst, runs on the ingest task
+   * @return true   If running
+   * @return false  If the driver could not be installed
+   */
+  bool startGnssUart(gnss_burst_handler_t handler);
+
+  /**
+   * @brief Get the counters of the receiver port
+   *
+   * @param stats Address of the struct to write to
+   */
+  void getGnssUartStats(gnss_uart_stats_t* stats);
+}
+
+#endif /*** GNSS_UART_H ***/
@@ -0,0 +1,318 @@
+#include <LocalCaster.h>
+#include <AsyncTCP.h>
+#include <StatusApi.h>
+
+/********************************************************************************
+*                             Broadcast ring
+* ******************************************************************************/
+
+using RTKBaseManager::rtcm_frame_t;
+
+typedef enum {
+  SLOT_FREE,
+  SLOT_REQUEST,         // connected, request not complete
+  SLOT_STREAMING,       // ICY 200 OK sent, fed by pumpLocalClients()
+  SLOT_CLOSING,         // evicted, waiting for the disconnect
+  SLOT_CLOSED           // disconnected, the client is deleted by the egress task
+} slot_state_t;
+
+typedef struct {
+  AsyncClient*          client;
+  volatile slot_state_t state;
+  uint32_t              cursor;                                   // ring seq of the next frame to send
+  char                  request[RTKBaseManager::LOCAL_CASTER_REQUEST_MAX_LEN + 1];
+  uint16_t              requestLen;
+  RTKBaseManager::rtcm_window_t window;                           // sent, not acknowledged
+  uint32_t              framesSent;
+} local_client_t;
+
+static const char ICY_OK[] PROGMEM = "ICY 200 OK\r\n\r\n";
+static const char REPLY_BUSY[] PROGMEM = "HTTP/1.0 503 Service Unavailable\r\n\r\n";
+static const char REPLY_BAD_REQUEST[] PROGMEM = "HTTP/1.0 400 Bad Request\r\n\r\n";
+static const uint32_t REQUEST_TIMEOUT_S = 5;
+
+// Seq n is in ring[n % LOCAL_CASTER_RING_LEN] until seq n + LOCAL_CASTER_RING_LEN is written
+static rtcm_frame_t* ring[LOCAL_CASTER_RING_LEN];
+static uint32_t writeSeq = 0;
+static portMUX_TYPE ringMux = portMUX_INITIALIZER_UNLOCKED;
+
+static local_client_t slots[LOCAL_CASTER_MAX_CLIENTS];
+static portMUX_TYPE slotsMux = portMUX_INITIALIZER_UNLOCKED;
+static AsyncServer* casterServer = nullptr;
+static RTKBaseManager::local_caster_stats_t counters;
+
+// Compare and set of a slot state, the two tasks race for the transitions out of STREAMING
+static bool moveSlot(local_client_t* s, slot_state_t from, slot_state_t to) {
+  portENTER_CRITICAL(&slotsMux);
+  bool moved = s->state == from;
+  if (moved) s->state = to;
+  portEXIT_CRITICAL(&slotsMux);
+  return moved;
+}
+
+static bool anyStreaming() {
+  for (uint8_t i = 0; i < LOCAL_CASTER_MAX_CLIENTS; i++) {
+    if (slots[i].state == SLOT_STREAMING) return true;
+  }
+  return false;
+}
+
+// Hands the ring frames back to the pool once the last rover is gone
+static void releaseRing() {
+  rtcm_frame_t* held[LOCAL_CASTER_RING_LEN];
+  portENTER_CRITICAL(&ringMux);
+  for (uint8_t i = 0; i < LOCAL_CASTER_RING_LEN; i++) {
+    held[i] = ring[i];
+    ring[i] = nullptr;
+  }
+  portEXIT_CRITICAL(&ringMux);
+  for (uint8_t i = 0; i < LOCAL_CASTER_RING_LEN; i++) {
+    if (held[i] != nullptr) RTKBaseManager::releaseFrame(held[i]);
+  }
+}
+
+void RTKBaseManager::broadcastFrame(rtcm_frame_t* frame) {
+  if (casterServer == nullptr) return;
+  // Without rovers the ring would only keep pool frames from the casters
+  if (!anyStreaming()) {
+    releaseRing();
+    return;
+  }
+
+  retainFrame(frame);
+  portENTER_CRITICAL(&ringMux);
+  rtcm_frame_t* replaced = ring[writeSeq % LOCAL_CASTER_RING_LEN];
+  ring[writeSeq % LOCAL_CASTER_RING_LEN] = frame;
+  writeSeq++;
+  portEXIT_CRITICAL(&ringMux);
+  if (replaced != nullptr) releaseFrame(replaced);
+}
+
+/********************************************************************************
+*                             Sourcetable
+* ******************************************************************************/
+
+const char* RTKBaseManager::localMountPoint(const config_snapshot_t* config) {
+  const char* mount = config->values[findParam(PARAM_RTK_MOINT_POINT)];
+  return (mount[0] != '\0') ? mount : DEVICE_NAME;
+}
+
+size_t RTKBaseManager::buildSourcetable(char* buf, size_t size, const char* mount, const config_snapshot_t* config) {
+  // STR;mountpoint;identifier;format;format-details;carrier;nav-system;network;country;
+  //     latitude;longitude;nmea;solution;generator;compr-encryp;authentication;fee;bitrate;misc
+  char body[SOURCETABLE_MAX_LEN];
+  double lat = config->hasLocation ? config->location.lat * 1e-7 : 0.0;
+  double lon = config->hasLocation ? config->location.lon * 1e-7 : 0.0;
+  int bodyLen = snprintf(body, sizeof(body),
+                         "STR;%s;%s;RTCM 3;;2;GNSS;RTKBase;;%.2f;%.2f;0;0;RTKBaseManager %s;none;N;N;0;\r\nENDSOURCETABLE\r\n",
+                         mount, DEVICE_NAME, lat, lon, FIRMWARE_VERSION);
+  if (bodyLen < 0 || (size_t)bodyLen >= sizeof(body)) return 0;
+
+  int len = snprintf(buf, size, "SOURCETABLE 200 OK\r\nServer: NTRIP RTKBaseManager/%s\r\n"
+                                "Content-Type: text/plain\r\nContent-Length: %d\r\n\r\n%s",
+                     FIRMWARE_VERSION, bodyLen, body);
+  return (len < 0 || (size_t)len >= size) ? 0 : len;
+}
+
+/********************************************************************************
+*                             Rovers, runs on async_tcp
+* ******************************************************************************/
+
+static void deleteClient(void* arg, AsyncClient* client) {
+  delete client;
+}
+
+static void answerRequest(local_client_t* s, AsyncClient* client) {
+  using namespace RTKBaseManager;
+  // First line only: GET /<mount> HTTP/1.x
+  char* lineEnd = strstr(s->request, "\r\n");
+  if (lineEnd != nullptr) *lineEnd = '\0';
+  if (strncmp(s->request, "GET /", 5) != 0) {
+    client->write(REPLY_BAD_REQUEST);
+    client->close();
+    return;
+  }
+  char* path = s->request + 5;
+  char* pathEnd = strchr(path, ' ');
+  if (pathEnd != nullptr) *pathEnd = '\0';
+
+  config_snapshot_t config;
+  readConfig(&config);
+  const char* mount = localMountPoint(&config);
+  if (path[0] == '\0' || strcmp(path, mount) != 0) {
+    // NTRIP 1: the root and unknown mount points get the sourcetable
+    char reply[SOURCETABLE_MAX_LEN + 160];
+    size_t len = buildSourcetable(reply, sizeof(reply), mount, &config);
+    if (len > 0) client->write(reply, len);
+    client->close();
+    counters.sourcetables++;
+    return;
+  }
+
+  // The rover starts with the next frame, older ones are stale for it
+  portENTER_CRITICAL(&ringMux);
+  s->cursor = writeSeq;
+  portEXIT_CRITICAL(&ringMux);
+  openWindow(&s->window, strlen(ICY_OK));
+  client->setRxTimeout(0);
+  client->setNoDelay(true);
+  client->write(ICY_OK);
+  s->framesSent = 0;
+  s->state = SLOT_STREAMING;
+  counters.accepted++;
+}
+
+static void onRequestData(void* arg, AsyncClient* client, void* data, size_t len) {
+  local_client_t* s = (local_client_t*)arg;
+  // Rovers may send GGA sentences while streaming, they are not needed
+  if (s->state != SLOT_REQUEST) return;
+
+  size_t room = RTKBaseManager::LOCAL_CASTER_REQUEST_MAX_LEN - s->requestLen;
+  size_t n = (len < room) ? len : room;
+  memcpy(s->request + s->requestLen, data, n);
+  s->requestLen += n;
+  s->request[s->requestLen] = '\0';
+  if (strstr(s->request, "\r\n\r\n") == nullptr && s->requestLen < RTKBaseManager::LOCAL_CASTER_REQUEST_MAX_LEN) return;
+  answerRequest(s, client);
+}
+
+static void onClientAck(void* arg, AsyncClient* client, size_t len, uint32_t time) {
+  local_client_t* s = (local_client_t*)arg;
+  counters.bytesAcked += RTKBaseManager::ackWindow(&s->window, len);
+}
+
+static void onClientDisconnect(void* arg, AsyncClient* client) {
+  local_client_t* s = (local_client_t*)arg;
+  RTKBaseManager::closeWindow(&s->window);
+  // The egress task may still be sending on the client, it deletes it
+  s->state = SLOT_CLOSED;
+}
+
+static void onNewClient(void* arg, AsyncClient* client) {
+  local_client_t* s = nullptr;
+  portENTER_CRITICAL(&slotsMux);
+  for (uint8_t i = 0; i < LOCAL_CASTER_MAX_CLIENTS; i++) {
+    if (slots[i].state != SLOT_FREE) continue;
+    s = &slots[i];
+    s->state = SLOT_REQUEST;
+    break;
+  }
+  portEXIT_CRITICAL(&slotsMux);
+
+  if (s == nullptr) {
+    counters.refused++;
+    client->onDisconnect(deleteClient, nullptr);
+    client->write(REPLY_BUSY);
+    client->close();
+    return;
+  }
+  s->client = client;
+  s->requestLen = 0;
+  s->request[0] = '\0';
+  client->setRxTimeout(REQUEST_TIMEOUT_S);
+  client->onData(onRequestData, s);
+  client->onAck(onClientAck, s);
+  client->onDisconnect(onClientDisconnect, s);
+}
+
+bool RTKBaseManager::startLocalCaster() {
+  if (casterServer != nullptr) return true;
+  for (uint8_t i = 0; i < LOCAL_CASTER_MAX_CLIENTS; i++) {
+    beginWindow(&slots[i].window);
+    slots[i].state = SLOT_FREE;
+  }
+  counters.maxClients = LOCAL_CASTER_MAX_CLIENTS;
+  casterServer = new AsyncServer(LOCAL_CASTER_PORT);
+  casterServer->onClient(onNewClient, nullptr);
+  casterServer->begin();
+  DEBUG_SERIAL.printf("Local caster on port %u\r\n", LOCAL_CASTER_PORT);
+  return true;
+}
+
+/********************************************************************************
+*                             Egress
+* ******************************************************************************/
+
+static void pumpClient(local_client_t* s) {
+  bool added = false;
+  while (true) {
+    rtcm_frame_t* frame = nullptr;
+    portENTER_CRITICAL(&ringMux);
+    uint32_t behind = writeSeq - s->cursor;
+    if (behind > 0 && behind <= LOCAL_CASTER_RING_LEN) {
+      frame = ring[s->cursor % LOCAL_CASTER_RING_LEN];
+      if (frame != nullptr) RTKBaseManager::retainFrame(frame);
+    }
+    portEXIT_CRITICAL(&ringMux);
+
+    if (behind > LOCAL_CASTER_RING_LEN) {
+      // Its next frame is gone, a gap would corrupt the rover's stream
+      if (moveSlot(s, SLOT_STREAMING, SLOT_CLOSING)) {
+        counters.evicted++;
+        s->client->close();
+      }
+      break;
+    }
+    if (frame == nullptr) break;
+    if (s->client->space() < frame->len || !RTKBaseManager::pushWindow(&s->window, frame)) {
+      RTKBaseManager::releaseFrame(frame);
+      break;
+    }
+    // No copy flag: TCP sends from the pool frame, onClientAck() releases it
+    if (s->client->add((const char*)frame->data, frame->len, 0) < frame->len) {
+      if (moveSlot(s, SLOT_STREAMING, SLOT_CLOSING)) s->client->close();
+      break;
+    }
+    s->cursor++;
+    s->framesSent++;
+    counters.framesSent++;
+    added = true;
+  }
+  if (added) s->client->send();
+}
+
+void RTKBaseManager::pumpLocalClients() {
+  if (casterServer == nullptr) return;
+  for (uint8_t i = 0; i < LOCAL_CASTER_MAX_CLIENTS; i++) {
+    local_client_t* s = &slots[i];
+    if (s->state == SLOT_CLOSED) {
+      delete s->client;
+      s->client = nullptr;
+      moveSlot(s, SLOT_CLOSED, SLOT_FREE);
+    } else if (s->state == SLOT_STREAMING) {
+      pumpClient(s);
+    }
+  }
+}
+
+/********************************************************************************
+*                             Stats
+* ******************************************************************************/
+
+void RTKBaseManager::getLocalCasterStats(local_caster_stats_t* stats) {
+  memcpy(stats, &counters, sizeof(local_caster_stats_t));
+  stats->clients = 0;
+  for (uint8_t i = 0; i < LOCAL_CASTER_MAX_CLIENTS; i++) {
+    if (slots[i].state == SLOT_STREAMING) stats->clients++;
+  }
+  stats->writeSeq = writeSeq;
+}
+
+void RTKBaseManager::actionLocalCaster(AsyncWebServerRequest *request) {
+  local_caster_stats_t s;
+  getLocalCasterStats(&s);
+  config_snapshot_t config;
+  readConfig(&config);
+
+  char json[2 * CONFIG_VALUE_MAX_LEN + 300];
+  size_t len = snprintf(json, sizeof(json), "{\"port\":%u,\"mount\":", LOCAL_CASTER_PORT);
+  len = appendJsonString(json, sizeof(json), len, localMountPoint(&config));
+  if (len < sizeof(json)) {
+    snprintf(json + len, sizeof(json) - len,
+             ",\"clients\":%u,\"max_clients\":%u,\"frames\":%u,\"accepted\":%u,\"sourcetables\":%u,"
+             "\"refused\":%u,\"evicted\":%u,\"sent\":%u,\"bytes\":%u}",
+             s.clients, s.maxClients, (unsigned int)s.writeSeq, (unsigned int)s.accepted, (unsigned int)s.sourcetables,
+             (unsigned int)s.refused, (unsigned int)s.evicted, (unsigned int)s.framesSent, (unsigned int)s.bytesAcked);
+  }
+  request->send(200, "application/json", json);
+}
@@ -0,0 +1,96 @@
+/**
+ * @file    LocalCaster.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   NTRIP 1 caster on LOCAL_CASTER_PORT for the rovers of the local
+ *          network, in station and in AP mode. The frames of the receiver go
+ *          into one broadcast ring of pool references, every rover reads the
+ *          ring with its own cursor and gets the pool memory without a copy.
+ *          A rover that falls more than LOCAL_CASTER_RING_LEN frames behind
+ *          is evicted, it can not hold up the others or the pool.
+ *
+ *          GET /         -> sourcetable of the stored mount point and position
+ *          GET /<mount>  -> ICY 200 OK and the RTCM stream
+ */
+
+#ifndef LOCAL_CASTER_H
+#define LOCAL_CASTER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <RTKBaseManager.h>
+#include <Rtcm.h>
+
+namespace RTKBaseManager {
+  const uint16_t LOCAL_CASTER_REQUEST_MAX_LEN = 256;
+  const uint16_t SOURCETABLE_MAX_LEN = 512;
+
+typedef struct {
+  uint8_t  clients;                   // streaming rovers
+  uint8_t  maxClients;                // LOCAL_CASTER_MAX_CLIENTS
+  uint32_t writeSeq;                  // frames put into the ring
+  uint32_t accepted;                  // stream requests
+  uint32_t sourcetables;              // sourcetable requests
+  uint32_t refused;                   // no free client slot
+  uint32_t evicted;                   // fell behind the ring
+  uint32_t framesSent;
+  uint32_t bytesAcked;
+} local_caster_stats_t;
+
+  /**
+   * @brief Listen on LOCAL_CASTER_PORT, call once the network is up
+   *
+   * @return true   If the server is listening
+   * @return false  If it was not started
+   */
+  bool startLocalCaster(void);
+
+  /**
+   * @brief Put a frame into the broadcast ring, the ring takes its own reference
+   *
+   * @param frame Complete frame
+   */
+  void broadcastFrame(rtcm_frame_t* frame);
+
+  /**
+   * @brief Send the ring to the streaming rovers and evict the ones behind,
+   *        runs on the correction egress task
+   */
+  void pumpLocalClients(void);
+
+  /**
+   * @brief Build the sourcetable reply with a STR record of the mount point
+   *
+   * @param buf       Buffer
+   * @param size      Size of the buffer
+   * @param mount     Mount point
+   * @param config    Config snapshot for the position, 0.00 without one
+   * @return size_t   Length of the reply, 0 if it does not fit
+   */
+  size_t buildSourcetable(char* buf, size_t size, const char* mount, const config_snapshot_t* config);
+
+  /**
+   * @brief Mount point of the local caster: mount_point or DEVICE_NAME
+   *
+   * @param config    Config snapshot
+   * @return const char* Mount point
+   */
+  const char* localMountPoint(const config_snapshot_t* config);
+
+  /**
+   * @brief Get the counters of the local caster
+   *
+   * @param stats Address of the struct to write to
+   */
+  void getLocalCasterStats(local_caster_stats_t* stats);
+
+  /**
+   * @brief Handler of /api/local_caster, counters of the local caster as JSON
+   *
+   * @param request Request
+   */
+  void actionLocalCaster(AsyncWebServerRequest *request);
+}
+
+#endif /*** LOCAL_CASTER_H ***/
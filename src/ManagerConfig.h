@@ -9,14 +9,205 @@
 //                       Default Serial settings
 /******************************************************************************/
 //set to true for debug output, false for no debug output
+#ifndef DEBUGGING
 #define DEBUGGING true 
+#endif
 #define DEBUG_SERIAL \
   if (DEBUGGING) Serial
 
 #define BAUD                          115200
 
+/******************************************************************************/
+//                       Firmware
+/******************************************************************************/
+// Advertised in the mDNS TXT record, see Discovery.h
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION              "0.1.0"
+#endif
+
+/******************************************************************************/
+//                       Web server admission control
+/******************************************************************************/
+// Requests beyond these limits are answered with 503 and Retry-After
+#ifndef MAX_INFLIGHT_REQUESTS
+#define MAX_INFLIGHT_REQUESTS         4       // concurrent requests
+#endif
+#ifndef MIN_FREE_HEAP
+#define MIN_FREE_HEAP                 40000   // bytes of free heap
+#endif
+#ifndef MIN_FREE_HEAP_BLOCK
+#define MIN_FREE_HEAP_BLOCK           8192    // bytes of the largest free block, guards fragmentation
+#endif
+#define RETRY_AFTER_S                 "2"
+
+/******************************************************************************/
+//                       Storage backend
+/******************************************************************************/
+// Where the config values live, see Storage.h. Values of another backend used
+// before are migrated at the first boot with the new one.
+#define STORAGE_SPIFFS                0       // one file per value
+#define STORAGE_LITTLEFS              1       // one file per value, same partition as SPIFFS
+#define STORAGE_NVS                   2       // one key per value, ESP32 only
+#ifndef STORAGE_BACKEND
+#ifdef ESP32
+#define STORAGE_BACKEND               STORAGE_NVS
+#else
+#define STORAGE_BACKEND               STORAGE_SPIFFS
+#endif
+#endif
+
+
+/******************************************************************************/
+//                       Network survey
+/******************************************************************************/
+#ifndef NETWORK_SURVEY_INTERVAL_MS
+#define NETWORK_SURVEY_INTERVAL_MS    60000   // between two background scans
+#endif
+#ifndef NETWORK_MAX_AGE_MS
+#define NETWORK_MAX_AGE_MS            300000  // networks not seen for longer are dropped
+#endif
+
+/******************************************************************************/
+//                       Task monitor
+/******************************************************************************/
+#ifndef TASK_STATS_INTERVAL_MS
+#define TASK_STATS_INTERVAL_MS        5000    // CPU use per task is reported per interval
+#endif
+
+/******************************************************************************/
+//                       Corrections
+/******************************************************************************/
+// Receiver port the RTCM stream is read from, see GnssUart.h
+#ifndef GNSS_UART_NUM
+#define GNSS_UART_NUM                 2       // UART2, Serial2 must not be used then
+#endif
+#ifndef GNSS_BAUD
+#define GNSS_BAUD                     115200  // 460800 or 921600 for a fast receiver
+#endif
+#ifndef GNSS_RX_PIN
+#define GNSS_RX_PIN                   16
+#endif
+#ifndef GNSS_TX_PIN
+#define GNSS_TX_PIN                   17
+#endif
+#ifndef GNSS_UART_RX_BUFFER_LEN
+#define GNSS_UART_RX_BUFFER_LEN       16384   // driver ring buffer, about 170 ms at 921600 baud
+#endif
+#ifndef GNSS_UART_EVENT_QUEUE_LEN
+#define GNSS_UART_EVENT_QUEUE_LEN     32
+#endif
+#ifndef GNSS_UART_RX_TIMEOUT
+#define GNSS_UART_RX_TIMEOUT          10      // idle symbols that end a burst
+#endif
+#ifndef GNSS_UART_BURST_LEN
+#define GNSS_UART_BURST_LEN           4096    // longer bursts are handed on in parts
+#endif
+// Frames shared by all casters, about 1 kB each, see Rtcm.h. Enough for every
+// caster holding a full queue, window and pending frame, the local ring with one
+// rover window beside it and the frame of the framer, checked in CasterFanout.cpp
+#ifndef RTCM_POOL_FRAMES
+#define RTCM_POOL_FRAMES              52
+#endif
+#ifndef CASTER_QUEUE_LEN
+#define CASTER_QUEUE_LEN              8       // frames waiting per caster before the drop policy applies
+#endif
+#ifndef RTCM_IN_FLIGHT_LEN
+#define RTCM_IN_FLIGHT_LEN            4       // frames sent per connection but not acknowledged yet
+#endif
+#ifndef CASTER_BACKOFF_MIN_MS
+#define CASTER_BACKOFF_MIN_MS         1000    // after the first failed connection attempt
+#endif
+#ifndef CASTER_BACKOFF_MAX_MS
+#define CASTER_BACKOFF_MAX_MS         60000
+#endif
+#ifndef CASTER_STABLE_MS
+#define CASTER_STABLE_MS              10000   // a stream lasting longer resets the backoff
+#endif
+#ifndef CASTER_HANDSHAKE_TIMEOUT_MS
+#define CASTER_HANDSHAKE_TIMEOUT_MS   10000   // for TCP connect and for the ICY 200 OK each
+#endif
+#ifndef CASTER_DNS_TTL_MS
+#define CASTER_DNS_TTL_MS             300000  // lwIP does not hand out the record TTL
+#endif
+// Caster for rovers in the local network, also in AP mode, see LocalCaster.h
+#ifndef LOCAL_CASTER_PORT
+#define LOCAL_CASTER_PORT             2101
+#endif
+#ifndef LOCAL_CASTER_MAX_CLIENTS
+#define LOCAL_CASTER_MAX_CLIENTS      16
+#endif
+#ifndef LOCAL_CASTER_RING_LEN
+#define LOCAL_CASTER_RING_LEN         8       // frames a rover may fall behind before it is evicted
+#endif
+// Recording of the receiver stream in the recorder partition, see Recorder.h
+#ifndef RECORDER_BUFFER_LEN
+#define RECORDER_BUFFER_LEN           8192    // bytes of frames waiting for the flash, covers sector erases
+#endif
+
+/******************************************************************************/
+//                       Time series
+/******************************************************************************/
+// Fixed size rings of /api/series, see TimeSeries.h
+#ifndef SERIES_RAW_INTERVAL_MS
+#define SERIES_RAW_INTERVAL_MS        5000    // divides a minute
+#endif
+#ifndef SERIES_RAW_LEN
+#define SERIES_RAW_LEN                60      // 5 minutes of samples
+#endif
+#ifndef SERIES_MINUTE_LEN
+#define SERIES_MINUTE_LEN             180     // 3 hours of minutes
+#endif
+#ifndef SERIES_TEN_MINUTE_LEN
+#define SERIES_TEN_MINUTE_LEN         144     // 24 hours of ten minutes
+#endif
 
+/******************************************************************************/
+//                       Flash budget
+/******************************************************************************/
+// Accounting and budget of the config writes, see FlashBudget.h
+#ifndef FLASH_BUDGET_WRITES
+#define FLASH_BUDGET_WRITES           32      // per hour, a full form is about 20
+#endif
+#ifndef FLASH_BUDGET_BYTES
+#define FLASH_BUDGET_BYTES            16384   // estimated flash bytes per hour
+#endif
+#ifndef FLASH_WRITE_OVERHEAD
+#define FLASH_WRITE_OVERHEAD          256     // metadata bytes per write, file system or NVS entry
+#endif
+#ifndef FLASH_BUDGET_HOURS
+#define FLASH_BUDGET_HOURS            24      // hours of counters in /api/flash
+#endif
+#ifndef FLASH_LEDGER_SAVE_HOURS
+#define FLASH_LEDGER_SAVE_HOURS       6       // counters are saved to NVS this often
+#endif
+#ifndef FLASH_ENDURANCE_CYCLES
+#define FLASH_ENDURANCE_CYCLES        100000  // erase cycles of a sector
+#endif
 
+/******************************************************************************/
+//                       Boot guard
+/******************************************************************************/
+// Reboot loop detection and safe mode, see BootGuard.h
+#ifndef BOOT_STABLE_MS
+#define BOOT_STABLE_MS                60000   // a shorter boot counts as failed
+#endif
+#ifndef BOOT_SAFE_MODE_FAILURES
+#define BOOT_SAFE_MODE_FAILURES       3       // failed boots in a row before safe mode
+#endif
+#ifndef BOOT_SAFE_MODE_TIMEOUT_MS
+#define BOOT_SAFE_MODE_TIMEOUT_MS     900000  // reboot an unused safe mode after 15 minutes
+#endif
+
+/******************************************************************************/
+//                       Simulation
+/******************************************************************************/
+// Only with RTK_SIMULATION, see Simulation.h
+#ifndef SIM_SPEED
+#define SIM_SPEED                     4       // trace time per real time
+#endif
+#ifndef SIM_SEED
+#define SIM_SEED                      1       // of the synthetic trace
+#endif
 
 #endif  /*** MANAGER_CONFIG_H ***/
 #endif
\ No newline at end of file
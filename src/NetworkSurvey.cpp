@@ -0,0 +1,222 @@
+#include <NetworkSurvey.h>
+#include <CasterFanout.h>
+#include <LocalCaster.h>
+#include <StatusApi.h>
+#include <TaskRuntime.h>
+
+/********************************************************************************
+*                             Network table
+* ******************************************************************************/
+
+static const uint32_t SURVEY_MAGIC = 0x53555256;   // "SURV"
+
+typedef struct {
+  uint32_t                        magic;
+  uint32_t                        checksum;   // of everything behind it
+  uint32_t                        updatedMs;  // millis() of the last merge
+  uint8_t                         count;
+  RTKBaseManager::network_entry_t entries[MAX_SSIDS];
+} network_table_t;
+
+// Not initialized at boot, valid after a software reboot if magic and checksum match
+RTC_NOINIT_ATTR static network_table_t surveyTable;
+static portMUX_TYPE surveyMux = portMUX_INITIALIZER_UNLOCKED;
+static bool surveyRestored = false;
+static TaskHandle_t surveyTask = nullptr;
+
+static uint32_t tableChecksum(const network_table_t* table) {
+  const uint8_t* data = (const uint8_t*)&table->updatedMs;
+  size_t len = sizeof(network_table_t) - offsetof(network_table_t, updatedMs);
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++) hash = (hash ^ data[i]) * 16777619u;
+  return hash;
+}
+
+// Takes the table of the last boot over, with its times moved before this boot
+static void restoreTable() {
+  if (surveyRestored) return;
+  surveyRestored = true;
+
+  bool valid = surveyTable.magic == SURVEY_MAGIC && surveyTable.count <= MAX_SSIDS &&
+               surveyTable.checksum == tableChecksum(&surveyTable);
+  if (!valid) {
+    memset(&surveyTable, 0, sizeof(surveyTable));
+  } else {
+    for (uint8_t i = 0; i < surveyTable.count; i++) {
+      surveyTable.entries[i].seenMs -= (int32_t)surveyTable.updatedMs;
+    }
+    DEBUG_SERIAL.printf("%u networks of the last boot in the survey cache\r\n", surveyTable.count);
+  }
+  surveyTable.magic = SURVEY_MAGIC;
+  surveyTable.updatedMs = 0;
+  surveyTable.checksum = tableChecksum(&surveyTable);
+}
+
+static void copyTable(network_table_t* to, const network_table_t* from) {
+  portENTER_CRITICAL(&surveyMux);
+  memcpy(to, from, sizeof(network_table_t));
+  portEXIT_CRITICAL(&surveyMux);
+}
+
+static void mergeResult(network_table_t* table, const RTKBaseManager::network_entry_t* seen) {
+  uint8_t slot = table->count;
+  for (uint8_t i = 0; i < table->count; i++) {
+    if (memcmp(table->entries[i].bssid, seen->bssid, sizeof(seen->bssid)) == 0) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot == MAX_SSIDS) {
+    // Full: replace the entry seen longest ago, the weaker one of equally old
+    slot = 0;
+    for (uint8_t i = 1; i < MAX_SSIDS; i++) {
+      const RTKBaseManager::network_entry_t& e = table->entries[i];
+      const RTKBaseManager::network_entry_t& oldest = table->entries[slot];
+      if (e.seenMs < oldest.seenMs || (e.seenMs == oldest.seenMs && e.rssi < oldest.rssi)) slot = i;
+    }
+    // A weaker network of this scan must not push out a stronger one of it
+    if (table->entries[slot].seenMs == seen->seenMs && table->entries[slot].rssi >= seen->rssi) return;
+  } else if (slot == table->count) {
+    table->count++;
+  }
+  memcpy(&table->entries[slot], seen, sizeof(RTKBaseManager::network_entry_t));
+}
+
+static void dropOld(network_table_t* table, int32_t now) {
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < table->count; i++) {
+    if (now - table->entries[i].seenMs > NETWORK_MAX_AGE_MS) continue;
+    if (kept != i) memcpy(&table->entries[kept], &table->entries[i], sizeof(RTKBaseManager::network_entry_t));
+    kept++;
+  }
+  table->count = kept;
+}
+
+int16_t RTKBaseManager::surveyNetworks() {
+  restoreTable();
+  int16_t nNetworks = WiFi.scanNetworks();
+  if (nNetworks < 0) return WIFI_SCAN_FAILED;
+
+  int32_t now = (int32_t)millis();
+  network_table_t next;
+  copyTable(&next, &surveyTable);
+  for (int16_t i = 0; i < nNetworks; i++) {
+    network_entry_t seen;
+    memset(&seen, 0, sizeof(seen));
+    strncpy(seen.ssid, WiFi.SSID(i).c_str(), NETWORK_SSID_MAX_LEN);
+    if (seen.ssid[0] == '\0') continue;
+    memcpy(seen.bssid, WiFi.BSSID(i), sizeof(seen.bssid));
+    seen.rssi = (int8_t)WiFi.RSSI(i);
+    seen.channel = (uint8_t)WiFi.channel(i);
+    seen.seenMs = now;
+    mergeResult(&next, &seen);
+  }
+  WiFi.scanDelete();
+  dropOld(&next, now);
+  next.updatedMs = (uint32_t)now;
+  next.checksum = tableChecksum(&next);
+  copyTable(&surveyTable, &next);
+
+  DEBUG_SERIAL.print(nNetworks);  DEBUG_SERIAL.println(F(" networks found."));
+  return nNetworks;
+}
+
+// A scan takes the radio off the channel for seconds, casters and rovers would miss corrections
+static bool correctionsFlowing() {
+  using namespace RTKBaseManager;
+  for (uint8_t i = 0; i < CASTER_MAX_TARGETS; i++) {
+    caster_stats_t caster;
+    getCasterStats(i, &caster);
+    if (caster.state == CASTER_STREAMING) return true;
+  }
+  local_caster_stats_t local;
+  getLocalCasterStats(&local);
+  return local.clients > 0;
+}
+
+static void surveyLoop(void* parameter) {
+  // The UI needs a list right away if the boot did not scan
+  if (surveyTable.count == 0) RTKBaseManager::surveyNetworks();
+  while (true) {
+    // Woken early by requestSurvey(), that scan runs even while corrections flow
+    bool requested = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NETWORK_SURVEY_INTERVAL_MS)) > 0;
+    if (requested || !correctionsFlowing()) RTKBaseManager::surveyNetworks();
+  }
+}
+
+bool RTKBaseManager::requestSurvey() {
+  if (surveyTask == nullptr) return false;
+  xTaskNotifyGive(surveyTask);
+  return true;
+}
+
+void RTKBaseManager::startNetworkSurvey() {
+  restoreTable();
+  if (surveyTask != nullptr) return;
+  // Housekeeping, next to the WiFi stack at low priority in every profile, a scan may take seconds
+  spawnTask(TASK_ROLE_BACKGROUND, surveyLoop, "networkSurvey", 4096, nullptr, &surveyTask);
+}
+
+static void sortByRssi(RTKBaseManager::network_entry_t* networks, uint8_t count) {
+  for (uint8_t i = 1; i < count; i++) {
+    RTKBaseManager::network_entry_t e = networks[i];
+    uint8_t j = i;
+    while (j > 0 && networks[j - 1].rssi < e.rssi) {
+      networks[j] = networks[j - 1];
+      j--;
+    }
+    networks[j] = e;
+  }
+}
+
+uint8_t RTKBaseManager::getNetworks(network_entry_t* networks) {
+  network_table_t table;
+  restoreTable();
+  copyTable(&table, &surveyTable);
+  memcpy(networks, table.entries, table.count * sizeof(network_entry_t));
+  sortByRssi(networks, table.count);
+  return table.count;
+}
+
+bool RTKBaseManager::findNetwork(const char* ssid, network_entry_t* network) {
+  network_entry_t networks[MAX_SSIDS];
+  uint8_t count = getNetworks(networks);
+  for (uint8_t i = 0; i < count; i++) {
+    if (strcmp(networks[i].ssid, ssid) != 0) continue;
+    memcpy(network, &networks[i], sizeof(network_entry_t));
+    return true;
+  }
+  return false;
+}
+
+/********************************************************************************
+*                             API
+* ******************************************************************************/
+
+void RTKBaseManager::actionNetworks(AsyncWebServerRequest *request) {
+  // The scan runs on the survey task, the page asks again for its results
+  bool scanning = request->hasParam("refresh") && requestSurvey();
+  network_entry_t networks[MAX_SSIDS];
+  uint8_t count = getNetworks(networks);
+  int32_t now = (int32_t)millis();
+  portENTER_CRITICAL(&surveyMux);
+  int32_t updatedMs = (int32_t)surveyTable.updatedMs;
+  portEXIT_CRITICAL(&surveyMux);
+
+  // 2 * 32 escaped SSID chars and about 100 chars of numbers per entry
+  char json[MAX_SSIDS * 170 + 80];
+  size_t len = snprintf(json, sizeof(json), "{\"scanning\":%s,\"age_ms\":%d,\"networks\":[",
+                        scanning ? "true" : "false", (int)(now - updatedMs));
+  for (uint8_t i = 0; i < count && len < sizeof(json); i++) {
+    const network_entry_t& n = networks[i];
+    len += snprintf(json + len, sizeof(json) - len, "%s{\"ssid\":", (i == 0) ? "" : ",");
+    // SSIDs are arbitrary bytes, see appendJsonString()
+    len = appendJsonString(json, sizeof(json), len, n.ssid);
+    len += snprintf(json + len, sizeof(json) - len,
+                    ",\"bssid\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"rssi\":%d,\"channel\":%u,\"age_ms\":%d}",
+                    n.bssid[0], n.bssid[1], n.bssid[2], n.bssid[3], n.bssid[4], n.bssid[5],
+                    n.rssi, n.channel, (int)(now - n.seenMs));
+  }
+  if (len < sizeof(json)) snprintf(json + len, sizeof(json) - len, "]}");
+  request->send(200, "application/json", json);
+}
@@ -0,0 +1,81 @@
+/**
+ * @file    NetworkSurvey.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Background WiFi survey: a task scans every NETWORK_SURVEY_INTERVAL_MS
+ *          and keeps the last seen networks in a fixed table. While a caster
+ *          streams or a rover is connected only the boot scans and the ones
+ *          requested with /api/networks?refresh=1 run, a scan would cost them
+ *          seconds of corrections. The table lives
+ *          in RTC memory and survives a software reboot, so the boot can check
+ *          the saved SSID without waiting on a fresh scan.
+ */
+
+#ifndef NETWORK_SURVEY_H
+#define NETWORK_SURVEY_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <RTKBaseManager.h>
+
+namespace RTKBaseManager {
+  const uint8_t NETWORK_SSID_MAX_LEN = 32;
+
+typedef struct {
+  char     ssid[NETWORK_SSID_MAX_LEN + 1];
+  uint8_t  bssid[6];
+  int8_t   rssi;        // dBm
+  uint8_t  channel;
+  int32_t  seenMs;      // millis() of the last scan result, negative if seen before this boot
+} network_entry_t;
+
+  /**
+   * @brief Start the background survey task, call after the WiFi mode is set
+   */
+  void startNetworkSurvey(void);
+
+  /**
+   * @brief Scan now and merge the results into the table, blocks for the scan
+   *
+   * @return int16_t Number of networks found or WIFI_SCAN_FAILED
+   */
+  int16_t surveyNetworks(void);
+
+  /**
+   * @brief Wake the survey task for a scan now, also while corrections flow
+   *
+   * @return true   If the survey task runs
+   * @return false  If it was not started
+   */
+  bool requestSurvey(void);
+
+  /**
+   * @brief Find a network in the table, the strongest if several access
+   *        points share the SSID
+   *
+   * @param ssid    SSID
+   * @param network Address to write the entry to
+   * @return true   If the SSID is in the table
+   * @return false  If not
+   */
+  bool findNetwork(const char* ssid, network_entry_t* network);
+
+  /**
+   * @brief Copy the table, strongest network first
+   *
+   * @param networks Array of at least MAX_SSIDS entries
+   * @return uint8_t Number of entries copied
+   */
+  uint8_t getNetworks(network_entry_t* networks);
+
+  /**
+   * @brief Handler of /api/networks, the table and its age as JSON,
+   *        ?refresh=1 requests a scan
+   *
+   * @param request Request
+   */
+  void actionNetworks(AsyncWebServerRequest *request);
+}
+
+#endif /*** NETWORK_SURVEY_H ***/
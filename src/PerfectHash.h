@@ -0,0 +1,119 @@
+/**
+ * @file    PerfectHash.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Compile time perfect hashing for small constexpr tables with a
+ *          const char* name member. The seed is searched by the compiler, so a
+ *          table only needs a new line to get a new entry.
+ * <br>
+ * @note    Everything is C++11 constexpr (one return statement per function),
+ *          because the ESP32 Arduino core still builds with -std=gnu++11.
+ */
+
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace PerfectHash {
+  const uint32_t FNV_OFFSET = 2166136261u;
+  const uint32_t FNV_PRIME = 16777619u;
+  const uint8_t  NO_SLOT = 0xFF;
+  const uint32_t MAX_SEED = 200;
+
+  // Index sequence (std::index_sequence is C++14)
+  template <size_t... Is> struct IndexSeq {};
+  template <size_t N, size_t... Is> struct MakeIndexSeq : MakeIndexSeq<N - 1, N - 1, Is...> {};
+  template <size_t... Is> struct MakeIndexSeq<0, Is...> { typedef IndexSeq<Is...> type; };
+
+  /**
+   * @brief Bucket to table index map, NO_SLOT marks an empty bucket
+   */
+  template <size_t M> struct SlotMap {
+    uint8_t slot[M];
+  };
+
+  /**
+   * @brief FNV-1a over a zero terminated string
+   *
+   * @param str   String to hash
+   * @param hash  Hash state of the already hashed prefix
+   * @return uint32_t Hash value
+   */
+  constexpr uint32_t fnv1a(const char* str, uint32_t hash) {
+    return (*str == '\0') ? hash : fnv1a(str + 1, (hash ^ (uint8_t)*str) * FNV_PRIME);
+  }
+
+  // Murmur3 finalizer, spreads the low FNV bits before the modulo
+  constexpr uint32_t fmix3(uint32_t h) { return h ^ (h >> 16); }
+  constexpr uint32_t fmix2(uint32_t h) { return fmix3((h ^ (h >> 13)) * 0xc2b2ae35u); }
+  constexpr uint32_t fmix(uint32_t h)  { return fmix2((h ^ (h >> 16)) * 0x85ebca6bu); }
+
+  /**
+   * @brief Get the bucket of a key
+   *
+   * @param key     Zero terminated key
+   * @param seed    Seed of the perfect hash
+   * @param buckets Number of buckets
+   * @return size_t Bucket index
+   */
+  constexpr size_t bucketOf(const char* key, uint32_t seed, size_t buckets) {
+    return fmix(fnv1a(key, FNV_OFFSET ^ (seed * FNV_PRIME))) % buckets;
+  }
+
+  template <typename T, size_t N>
+  constexpr bool collidesWith(const T (&table)[N], size_t i, size_t j, uint32_t seed, size_t buckets) {
+    return (j >= N) ? false
+      : (bucketOf(table[i].name, seed, buckets) == bucketOf(table[j].name, seed, buckets))
+        || collidesWith(table, i, j + 1, seed, buckets);
+  }
+
+  template <typename T, size_t N>
+  constexpr bool hasCollision(const T (&table)[N], size_t i, uint32_t seed, size_t buckets) {
+    return (i >= N) ? false
+      : collidesWith(table, i, i + 1, seed, buckets) || hasCollision(table, i + 1, seed, buckets);
+  }
+
+  /**
+   * @brief Search the first seed without collisions, MAX_SEED if there is none
+   *
+   * @param table   Table with a name member per entry
+   * @param seed    First seed to try
+   * @param buckets Number of buckets
+   * @return uint32_t Collision free seed
+   */
+  template <typename T, size_t N>
+  constexpr uint32_t findSeed(const T (&table)[N], uint32_t seed, size_t buckets) {
+    return (seed >= MAX_SEED) ? MAX_SEED
+      : (!hasCollision(table, 0, seed, buckets) ? seed : findSeed(table, seed + 1, buckets));
+  }
+
+  template <typename T, size_t N>
+  constexpr uint8_t indexForBucket(const T (&table)[N], size_t bucket, size_t i, uint32_t seed, size_t buckets) {
+    return (i >= N) ? NO_SLOT
+      : ((bucketOf(table[i].name, seed, buckets) == bucket) ? (uint8_t)i
+        : indexForBucket(table, bucket, i + 1, seed, buckets));
+  }
+
+  template <typename T, size_t N, size_t... Bs>
+  constexpr SlotMap<sizeof...(Bs)> buildSlotMap(const T (&table)[N], uint32_t seed, IndexSeq<Bs...>) {
+    return SlotMap<sizeof...(Bs)>{{ indexForBucket(table, Bs, 0, seed, sizeof...(Bs))... }};
+  }
+
+  /**
+   * @brief Build the bucket to index map of a table at compile time
+   *
+   * @tparam M      Number of buckets
+   * @param table   Table with a name member per entry
+   * @param seed    Collision free seed, see findSeed()
+   * @return SlotMap<M>
+   */
+  template <size_t M, typename T, size_t N>
+  constexpr SlotMap<M> makeSlotMap(const T (&table)[N], uint32_t seed) {
+    return buildSlotMap(table, seed, typename MakeIndexSeq<M>::type());
+  }
+}
+
+#endif /*** PERFECT_HASH_H ***/
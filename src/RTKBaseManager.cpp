@@ -1,4 +1,20 @@
 #include <RTKBaseManager.h>
+#include <FormParser.h>
+#include <RenderCache.h>
+#include <AdmissionControl.h>
+#include <AllocTracker.h>
+#include <Storage.h>
+#include <Assets.h>
+#include <NetworkSurvey.h>
+#include <Discovery.h>
+#include <StatusApi.h>
+#include <TaskMonitor.h>
+#include <CasterFanout.h>
+#include <LocalCaster.h>
+#include <Recorder.h>
+#include <TimeSeries.h>
+#include <BootGuard.h>
+#include <FlashBudget.h>
 
 /********************************************************************************
 *                             WiFi
@@ -8,15 +24,16 @@ void RTKBaseManager::setupStationMode(const char* ssid, const char* password, co
   WiFi.mode(WIFI_STA);
   WiFi.begin( ssid, password);
   if (WiFi.waitForConnectResult() != WL_CONNECTED) {
-    // TODO:  - count reboots and stop after 3 times (save in SPIFFS)
-    //        - display state
+    // Counts as a failed boot, after BOOT_SAFE_MODE_FAILURES in a row
+    // the base comes up in safe mode, see BootGuard.h
     DEBUG_SERIAL.println("WiFi Failed! Reboot in 10 s as AP!");
     delay(10000);
+    flushFlashWrites();
     ESP.restart();
   }
   DEBUG_SERIAL.println();
 
-  if (!MDNS.begin(deviceName)) {
+  if (!startDiscovery(deviceName)) {
       DEBUG_SERIAL.println("Error starting mDNS, use local IP instead!");
   } else {
     DEBUG_SERIAL.print(F("Starting mDNS, find me under <http://www."));
@@ -43,35 +60,56 @@ void RTKBaseManager::setupAPMode(const char* apSsid, const char* apPassword) {
 bool RTKBaseManager::savedNetworkAvailable(const String& ssid) {
   if (ssid.isEmpty()) return false;
 
-  uint8_t nNetworks = (uint8_t) WiFi.scanNetworks();
-  DEBUG_SERIAL.print(nNetworks);  DEBUG_SERIAL.println(F(" networks found."));
-    for (uint8_t i=0; i<nNetworks; i++) {
-    if (ssid.equals(String(WiFi.SSID(i)))) {
-      DEBUG_SERIAL.print(F("A known network with SSID found: ")); 
-      DEBUG_SERIAL.print(WiFi.SSID(i));
-      DEBUG_SERIAL.print(F(" (")); 
-      DEBUG_SERIAL.print(WiFi.RSSI(i)); 
-      DEBUG_SERIAL.println(F(" dB), connecting..."));
-      return true;
-    }
+  // The survey table of the last boot saves the scan after a software reboot
+  network_entry_t network;
+  bool found = findNetwork(ssid.c_str(), &network);
+  if (!found) {
+    surveyNetworks();
+    found = findNetwork(ssid.c_str(), &network);
+  }
+  if (found) {
+    DEBUG_SERIAL.print(F("A known network with SSID found: ")); 
+    DEBUG_SERIAL.print(network.ssid);
+    DEBUG_SERIAL.print(F(" (")); 
+    DEBUG_SERIAL.print(network.rssi); 
+    DEBUG_SERIAL.println(F(" dB), connecting..."));
   }
-  return false;
+  return found;
 }
 
 /********************************************************************************
 *                             Web server
 * ******************************************************************************/
 
-void RTKBaseManager::startServer(AsyncWebServer *server) {
-  server->on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
-    request->send_P(200, "text/html", INDEX_HTML, processor);
-  });
+static RTKBaseManager::page_cache_t indexPage = { INDEX_HTML };
 
-  server->on("/actionUpdateData", HTTP_POST, actionUpdateData);
-  server->on("/actionWipeData", HTTP_POST, actionWipeData);
-  server->on("/actionRebootESP32", HTTP_POST, actionRebootESP32);
-
-  server->onNotFound(notFound);
+void RTKBaseManager::startServer(AsyncWebServer *server) {
+  // Pages of the assets partition replace the built in ones, see Assets.h
+  mountAssets();
+  indexPage.html = assetPage(ASSET_INDEX, INDEX_HTML);
+
+  // Every handler is accounted and admitted, see AllocTracker.h and AdmissionControl.h
+  server->on("/", HTTP_GET, accounted(admitted([](AsyncWebServerRequest *request) {
+    sendCachedPage(request, &indexPage);
+  })));
+
+  server->on("/actionUpdateData", HTTP_POST, accounted(admitted(actionUpdateData)), nullptr, accountedBody(actionUpdateDataBody));
+  server->on("/actionWipeData", HTTP_POST, accounted(admitted(actionWipeData)));
+  server->on("/actionRebootESP32", HTTP_POST, accounted(admitted(actionRebootESP32)));
+  server->on("/api/status", HTTP_GET, accounted(admitted(actionStatus)));
+  server->on("/assets", HTTP_GET, accounted(admitted(actionAsset)));
+  server->on("/api/networks", HTTP_GET, accounted(admitted(actionNetworks)));
+  server->on("/api/config", HTTP_GET, accounted(admitted(actionConfig)));
+  server->on("/api/tasks", HTTP_GET, accounted(admitted(actionTasks)));
+  server->on("/api/casters", HTTP_GET, accounted(admitted(actionCasters)));
+  server->on("/api/local_caster", HTTP_GET, accounted(admitted(actionLocalCaster)));
+  server->on("/api/recording", HTTP_GET, accounted(admitted(actionRecording)));
+  server->on("/api/recorder", HTTP_GET, accounted(admitted(actionRecorder)));
+  server->on("/api/series", HTTP_GET, accounted(admitted(actionSeries)));
+  server->on("/api/boot", HTTP_GET, accounted(admitted(actionBoot)));
+  server->on("/api/flash", HTTP_GET, accounted(admitted(actionFlash)));
+
+  server->onNotFound(accounted(admitted(notFound)));
   server->begin();
 }
   
@@ -81,8 +119,10 @@ void RTKBaseManager::notFound(AsyncWebServerRequest *request) {
 
 void RTKBaseManager::actionRebootESP32(AsyncWebServerRequest *request) {
   DEBUG_SERIAL.println("ACTION actionRebootESP32!");
-  request->send_P(200, "text/html", REBOOT_HTML, RTKBaseManager::processor);
+  request->send_P(200, "text/html", assetPage(ASSET_REBOOT, REBOOT_HTML), RTKBaseManager::processor);
   delay(3000);
+  flushFlashWrites();
+  clearBootFailures();
   ESP.restart();
 }
 
@@ -99,95 +139,74 @@ void RTKBaseManager::actionWipeData(AsyncWebServerRequest *request) {
     if (strcmp(p->name().c_str(), "wipe_button") == 0) {
       if (p->value().length() > 0) {
         DEBUG_SERIAL.printf("wipe command received: %s",p->value().c_str());
-        wipeSpiffsFiles();
+        wipeStorage();
       } 
      }
     } 
 
-  DEBUG_SERIAL.print(F("Data in SPIFFS was wiped out!"));
-  request->send_P(200, "text/html", INDEX_HTML, processor);
+  loadConfig();
+  DEBUG_SERIAL.print(F("Stored data was wiped out!"));
+  sendCachedPage(request, &indexPage);
 }
 
 void RTKBaseManager::actionUpdateData(AsyncWebServerRequest *request) {
   DEBUG_SERIAL.println("ACTION: actionUpdateData!");
 
-  int params = request->params();
-  for (int i = 0; i < params; i++) {
-    AsyncWebParameter* p = request->getParam(i);
-    DEBUG_SERIAL.printf("%d. POST[%s]: %s\n", i+1, p->name().c_str(), p->value().c_str());
-
-    if (strcmp(p->name().c_str(), PARAM_WIFI_SSID) == 0) {
-      if (p->value().length() > 0) {
-        writeFile(SPIFFS, PATH_WIFI_SSID, p->value().c_str());
-     } 
-    }
-
-    if (strcmp(p->name().c_str(), PARAM_WIFI_PASSWORD) == 0) {
-      if (p->value().length() > 0) {
-        writeFile(SPIFFS, PATH_WIFI_PASSWORD, p->value().c_str());
-     } 
-    }
-
-    if (strcmp(p->name().c_str(), PARAM_RTK_CASTER_HOST) == 0) {
-      if (p->value().length() > 0) {
-        writeFile(SPIFFS, PATH_RTK_CASTER_HOST, p->value().c_str());
-     } 
-    }
-
-    if (strcmp(p->name().c_str(), PARAM_RTK_CASTER_PORT) == 0) {
-      if (p->value().length() > 0) {
-        writeFile(SPIFFS, PATH_RTK_CASTER_PORT, p->value().c_str());
-     } 
-    }
-
-    if (strcmp(p->name().c_str(), PARAM_RTK_MOINT_POINT) == 0) {
-      if (p->value().length() > 0) {
-        writeFile(SPIFFS, PATH_RTK_MOINT_POINT, p->value().c_str());
-     } 
-    }
-
-    if (strcmp(p->name().c_str(), PARAM_RTK_MOINT_POINT_PW) == 0) {
-      if (p->value().length() > 0) {
-        writeFile(SPIFFS, PATH_RTK_MOINT_POINT_PW, p->value().c_str());
-     } 
+  form_parser_t* form = (form_parser_t*)request->_tempObject;
+  if (form == nullptr && request->contentType().startsWith(FORM_CONTENT_TYPE)) {
+    // The body handler dropped the body, it was over the admission limits
+    sendBusy(request);
+    return;
+  }
+  if (form == nullptr) {
+    // Plain url encoded post, the web server already parsed it into params
+    form = (form_parser_t*)malloc(sizeof(form_parser_t));
+    if (form == nullptr) {
+      request->send_P(500, "text/html", assetPage(ASSET_ERROR, ERROR_HTML));
+      return;
     }
-
-    if (strcmp(p->name().c_str(), PARAM_RTK_LOCATION_METHOD) == 0) {
-      if (p->value().length() > 0) {
-        writeFile(SPIFFS, PATH_RTK_LOCATION_METHOD, p->value().c_str());
-     } 
+    request->_tempObject = form;
+    beginForm(form);
+
+    int params = request->params();
+    for (int i = 0; i < params; i++) {
+      AsyncWebParameter* p = request->getParam(i);
+      DEBUG_SERIAL.printf("%d. POST[%s]: %s\n", i+1, p->name().c_str(), p->value().c_str());
+      putFormField(form, p->name().c_str(), p->value().c_str(), p->value().length());
     }
+  }
 
-    if (strcmp(p->name().c_str(), PARAM_RTK_LOCATION_SURVEY_ACCURACY) == 0) {
-      if (p->value().length() > 0) {
-        writeFile(SPIFFS, PATH_RTK_LOCATION_SURVEY_ACCURACY, p->value().c_str());
-     } 
-    }
+  // Nothing is written unless every posted value is valid
+  if (!endForm(form)) {
+    DEBUG_SERIAL.printf("Form rejected, %s: %s\n", 
+                        (form->errorField == FORM_NO_FIELD) ? "-" : PARAM_TABLE[form->errorField].name,
+                        formErrorText(form->error));
+    request->send_P(400, "text/html", assetPage(ASSET_ERROR, ERROR_HTML));
+    return;
+  }
+  commitForm(form);
+  loadConfig();
 
-    if (strcmp(p->name().c_str(), PARAM_RTK_LOCATION_LATITUDE) == 0) {
-      if (p->value().length() > 0) {
-        String deconstructedValAsCSV = getDeconstructedValAsCSV(p->value());
-        writeFile(SPIFFS, PATH_RTK_LOCATION_LATITUDE, deconstructedValAsCSV.c_str());
-     } 
-    }
+  DEBUG_SERIAL.println(F("Data saved!"));
+  sendCachedPage(request, &indexPage);
+}
 
-    if (strcmp(p->name().c_str(), PARAM_RTK_LOCATION_LONGITUDE) == 0) {
-      if (p->value().length() > 0) {
-        String deconstructedValAsCSV = getDeconstructedValAsCSV(p->value());
-        writeFile(SPIFFS, PATH_RTK_LOCATION_LONGITUDE, deconstructedValAsCSV.c_str());
-     } 
-    }
+void RTKBaseManager::actionUpdateDataBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (!request->contentType().startsWith(FORM_CONTENT_TYPE)) return;
 
-    if (strcmp(p->name().c_str(), PARAM_RTK_LOCATION_ALTITUDE) == 0) {
-      if (p->value().length() > 0) {
-        String deconstructedValAsCSV = getDeconstructedValAsCSV(p->value());
-        writeFile(SPIFFS, PATH_RTK_LOCATION_ALTITUDE, deconstructedValAsCSV.c_str());
-     } 
-    }
+  if (index == 0) {
+    // Hold the in-flight slot while the body arrives, not only in the final handler
+    if (!admitBody(request)) return;
+    // One buffer for all fields, freed by the destructor of the request
+    request->_tempObject = malloc(sizeof(form_parser_t));
+    if (request->_tempObject == nullptr) return;
+    beginForm((form_parser_t*)request->_tempObject);
   }
 
-  DEBUG_SERIAL.println(F("Data saved to SPIFFS!"));
-  request->send_P(200, "text/html", INDEX_HTML, RTKBaseManager::processor);
+  form_parser_t* form = (form_parser_t*)request->_tempObject;
+  if (form != nullptr) {
+    feedForm(form, data, len);
+  }
 }
 
 String RTKBaseManager::getDeconstructedValAsCSV(const String& doubleStr) {
@@ -198,91 +217,116 @@ String RTKBaseManager::getDeconstructedValAsCSV(const String& doubleStr) {
     return deconstructedCSV;
 }
 
+String RTKBaseManager::getAltitudeAsCSV(const char* meters) {
+  // Fixed point, 520.1234 must not come back as 520.1233
+  const char* p = meters;
+  bool negative = *p == '-';
+  if (*p == '-' || *p == '+') p++;
+  int64_t units = 0;    // 1e-4 m
+  for (; isdigit((unsigned char)*p); p++) units = units * 10 + (*p - '0');
+  uint8_t decimals = 0;
+  if (*p == '.') {
+    for (p++; isdigit((unsigned char)*p) && decimals < 4; p++, decimals++) units = units * 10 + (*p - '0');
+  }
+  for (; decimals < 4; decimals++) units *= 10;
+  if (negative) units = -units;
+  return String((long)(units / 100)) + "," + String((int)(units % 100));
+}
+
 String RTKBaseManager::getDoubleStringFromCSV(const String& csvStr) { 
-  if (csvStr.isEmpty()) return String();
-  int32_t lowerPrec = (int32_t)getValueAsStringFromCSV(csvStr, ',', 0).toInt();
-  int8_t highPrec = (int8_t)getValueAsStringFromCSV(csvStr, ',', 1).toInt();
-  double reconstructedVal = getDoubleFromIntegerParts(lowerPrec, highPrec);
-  String reconstructedValStr = String(reconstructedVal, 9);
-  return reconstructedValStr;
+  char buf[CSV_NUMBER_MAX_LEN + 1];
+  formatCSVFixedPoint(csvStr.c_str(), 9, buf, sizeof(buf));
+  return String(buf);
+}
+
+size_t RTKBaseManager::formatCSVFixedPoint(const char* csv, uint8_t decimals, char* out, size_t outLen) {
+  if (outLen == 0) return 0;
+  out[0] = '\0';
+  if (csv[0] == '\0' || decimals > 9) return 0;
+
+  int32_t lowerPrec;
+  int8_t highPrec;
+  getIntPartsFromCSV(csv, &lowerPrec, &highPrec);
+  // Same sum as getDoubleFromIntegerParts(), in units of 1e-9
+  int64_t nano = (int64_t)lowerPrec * 100 + highPrec;
+  uint64_t absNano = (nano < 0) ? (uint64_t)(-nano) : (uint64_t)nano;
+
+  uint32_t scale = 1;
+  for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+  int len = snprintf(out, outLen, "%s%lu.%0*lu", (nano < 0) ? "-" : "",
+                     (unsigned long)(absNano / scale), (int)decimals, (unsigned long)(absNano % scale));
+  if (len < 0) return 0;
+  return ((size_t)len < outLen) ? (size_t)len : outLen - 1;
 }
 
 // Replaces placeholder with stored values
 String RTKBaseManager::processor(const String& var) 
 {
-  if (var == PARAM_WIFI_SSID) {
-    String savedSSID = readFile(SPIFFS, PATH_WIFI_SSID);
-    return (savedSSID.isEmpty() ? String(PARAM_WIFI_SSID) : savedSSID);
-  }
-  else if (var == PARAM_WIFI_PASSWORD) {
-    String savedPassword = readFile(SPIFFS, PATH_WIFI_PASSWORD);
-    return (savedPassword.isEmpty() ? String(PARAM_WIFI_PASSWORD) : "*******");
-  }
+  int8_t idx = findParam(var.c_str());
+  if (idx == PARAM_NONE) return String();
+
+  config_snapshot_t config;
+  char value[RENDER_VALUE_MAX_LEN + 1];
+  readConfig(&config);
+  renderParam(idx, &config, value, sizeof(value));
+  return String(value);
+}
 
-  else if (var == PARAM_RTK_CASTER_HOST) {
-    String savedCaster = readFile(SPIFFS, PATH_RTK_CASTER_HOST);
-    return (savedCaster.isEmpty() ? String(PARAM_RTK_CASTER_HOST) : savedCaster);
-  }
+int8_t RTKBaseManager::findParam(const char* name) {
+  uint8_t slot = PARAM_SLOTS.slot[PerfectHash::bucketOf(name, PARAM_SEED, PARAM_BUCKETS)];
+  if (slot == PerfectHash::NO_SLOT) return PARAM_NONE;
+  // One strcmp rejects unknown names hashing into a used bucket
+  return (strcmp(PARAM_TABLE[slot].name, name) == 0) ? (int8_t)slot : PARAM_NONE;
+}
 
-   else if (var == PARAM_RTK_CASTER_PORT) {
-    String savedPort = readFile(SPIFFS, PATH_RTK_CASTER_PORT);
-    return (savedPort.isEmpty() ? String(PARAM_RTK_CASTER_PORT) : savedPort);
-  }
+static size_t copyValue(const char* value, char* out, size_t outLen) {
+  size_t len = strlen(value);
+  if (len >= outLen) len = outLen - 1;
+  memcpy(out, value, len);
+  out[len] = '\0';
+  return len;
+}
 
-  else if (var == PARAM_RTK_MOINT_POINT) {
-    String savedMointPoint = readFile(SPIFFS, PATH_RTK_MOINT_POINT);
-    return (savedMointPoint.isEmpty() ? String(PARAM_RTK_MOINT_POINT) : savedMointPoint);
+size_t RTKBaseManager::renderParam(int8_t idx, const config_snapshot_t* config, char* out, size_t outLen) {
+  if (outLen == 0) return 0;
+  const param_entry_t* param = &PARAM_TABLE[idx];
+  const char* saved = config->values[idx];
+  if (saved[0] == '\0') return copyValue(param->placeholder, out, outLen);
+
+  switch (param->codec) {
+    case CODEC_SECRET:
+      return copyValue("*******", out, outLen);
+    case CODEC_CSV_COORD:
+      return formatCSVFixedPoint(saved, 9, out, outLen);
+    case CODEC_CSV_ALTITUDE:
+      // cm * 100 + 0.1 mm is the altitude in 1e-4 m
+      return formatCSVFixedPoint(saved, 4, out, outLen);
+    case CODEC_NEXT_ADDR:
+      if (config->values[findParam(PARAM_WIFI_PASSWORD)][0] == '\0') return copyValue(param->placeholder, out, outLen);
+      return copyValue(DEVICE_NAME ".local", out, outLen);
+    case CODEC_PLAIN:
+    default:
+      return copyValue(saved, out, outLen);
   }
+}
 
-  else if (var == PARAM_RTK_MOINT_POINT_PW) {
-    String savedMointPointPW = readFile(SPIFFS, PATH_RTK_MOINT_POINT_PW);
-    return (savedMointPointPW.isEmpty() ? String(PARAM_RTK_MOINT_POINT_PW) : "*******");
-  }
+bool RTKBaseManager::storeParam(const param_entry_t* param, const char* value) {
+  if (param->check == CHECK_NONE || value[0] == '\0') return false;
 
-  else if (var == PARAM_RTK_LOCATION_METHOD) {
-    String savedLocationMethod = readFile(SPIFFS, PATH_RTK_LOCATION_METHOD);
-    return (savedLocationMethod.isEmpty() ? String(PARAM_RTK_SURVEY_ENABLED) : savedLocationMethod);
-  }
-  else if (var == PARAM_RTK_LOCATION_SURVEY_ACCURACY) {
-    String savedSurveyAccuracy = readFile(SPIFFS, PATH_RTK_LOCATION_SURVEY_ACCURACY);
-    return (savedSurveyAccuracy.isEmpty() ? String(PARAM_RTK_LOCATION_SURVEY_ACCURACY) : savedSurveyAccuracy);
-  }
-  else if (var == PARAM_RTK_LOCATION_LATITUDE) {
-    String savedLatitude = readFile(SPIFFS, PATH_RTK_LOCATION_LATITUDE);
-    String savedLatitudeStr = getDoubleStringFromCSV(savedLatitude);
-    return (savedLatitude.isEmpty() ? String(PARAM_RTK_LOCATION_LATITUDE) : savedLatitudeStr);
-  }
-  else if (var == PARAM_RTK_LOCATION_LONGITUDE) {
-    String savedLongitude = readFile(SPIFFS, PATH_RTK_LOCATION_LONGITUDE);
-    String savedLongitudeStr = getDoubleStringFromCSV(savedLongitude);
-    return (savedLongitude.isEmpty() ? String(PARAM_RTK_LOCATION_LONGITUDE) : savedLongitudeStr);
-  }
-  else if (var == PARAM_RTK_LOCATION_ALTITUDE) {
-    String savedAlt = readFile(SPIFFS, PATH_RTK_LOCATION_ALTITUDE);
-    String altitudeDoubleStr = getDoubleStringFromCSV(savedAlt);
-    double d_alt = altitudeDoubleStr.toDouble() * 1e4;
-    return (altitudeDoubleStr.isEmpty() ? String(PARAM_RTK_LOCATION_ALTITUDE) : String(d_alt, 5));
-  }
-  else if (var == "next_addr") {
-    String savedSSID = readFile(SPIFFS, PATH_WIFI_SSID);
-    String savedPW = readFile(SPIFFS, PATH_WIFI_PASSWORD);
-    if (savedSSID.isEmpty() || savedPW.isEmpty()) {
-      return String(IP_AP);
-    } else {
-      String clientAddr = String(DEVICE_NAME);
-      clientAddr += ".local";
-      return clientAddr;
+  switch (param->codec) {
+    case CODEC_CSV_COORD: {
+      String deconstructedValAsCSV = getDeconstructedValAsCSV(String(value));
+      return writeStored(param->path, deconstructedValAsCSV.c_str());
     }
+    case CODEC_CSV_ALTITUDE:
+      return writeStored(param->path, getAltitudeAsCSV(value).c_str());
+    default:
+      return writeStored(param->path, value);
   }
-  else if (var == "next_ssid") {
-    String savedSSID = readFile(SPIFFS, PATH_WIFI_SSID);
-    return (savedSSID.isEmpty() ? String(AP_SSID) : savedSSID);
-  }
-  return String();
 }
 
 /********************************************************************************
-*                             SPIFFS
+*                             File system
 * ******************************************************************************/
 
 bool RTKBaseManager::setupSPIFFS(bool format) {
@@ -353,55 +397,33 @@ bool RTKBaseManager::writeFile(fs::FS &fs, const char* path, const char* message
 }
 
 void RTKBaseManager::listFiles() {
-  File root = SPIFFS.open("/");
-  File file = root.openNextFile();
- 
-  while (file) {
-      DEBUG_SERIAL.print("FILE: ");
-      DEBUG_SERIAL.println(file.name());
-      file = root.openNextFile();
-  }
-  file.close();
-  root.close();
+  activeStorage()->list();
 }
 
-void RTKBaseManager::wipeSpiffsFiles() 
+void RTKBaseManager::wipeStorage() 
 {
-  File root = SPIFFS.open("/");
-  File file = root.openNextFile();
-
-  DEBUG_SERIAL.println(F("Wiping: "));
-
-  while (file) {
-    DEBUG_SERIAL.print("FILE: ");
-    DEBUG_SERIAL.println(file.path());
-    SPIFFS.remove(file.path());
-    file = root.openNextFile();
-  }
+  budgetedWipe();
 }
 
-bool RTKBaseManager::getIntLocationFromSPIFFS(location_int_t* location, const char* pathLat, const char* pathLon, const char* pathAlt) {
-  bool success = false;
-  String latStr = readFile(SPIFFS, pathLat);
-  String lonStr = readFile(SPIFFS, pathLon);
-  String altStr = readFile(SPIFFS, pathAlt);
-  if (!latStr.isEmpty() && !lonStr.isEmpty() && !altStr.isEmpty()) {
-    location->lat =  (int32_t)getValueAsStringFromCSV(latStr, SEP, LOW_PREC_IDX).toInt();
-    location->lat_hp = (int8_t)getValueAsStringFromCSV(latStr, SEP, HIGH_PREC_IDX).toInt();
-    location->lon =  (int32_t)getValueAsStringFromCSV(lonStr, SEP, LOW_PREC_IDX).toInt();
-    location->lon_hp = (int8_t)getValueAsStringFromCSV(lonStr, SEP, HIGH_PREC_IDX).toInt();
-    location->alt =  (int32_t)getValueAsStringFromCSV(altStr, SEP, LOW_PREC_IDX).toInt();
-    location->alt_hp = (int8_t)getValueAsStringFromCSV(altStr, SEP, HIGH_PREC_IDX).toInt();
-    success = true;
-  } 
-  
-  return success;
+bool RTKBaseManager::getIntLocationFromStorage(location_int_t* location, const char* pathLat, const char* pathLon, const char* pathAlt) {
+  char latStr[CONFIG_VALUE_MAX_LEN + 1];
+  char lonStr[CONFIG_VALUE_MAX_LEN + 1];
+  char altStr[CONFIG_VALUE_MAX_LEN + 1];
+  if (readStored(pathLat, latStr, sizeof(latStr)) == 0 ||
+      readStored(pathLon, lonStr, sizeof(lonStr)) == 0 ||
+      readStored(pathAlt, altStr, sizeof(altStr)) == 0) {
+    return false;
+  }
+  getIntPartsFromCSV(latStr, &location->lat, &location->lat_hp);
+  getIntPartsFromCSV(lonStr, &location->lon, &location->lon_hp);
+  getIntPartsFromCSV(altStr, &location->alt, &location->alt_hp);
+  return true;
 }
 
 void RTKBaseManager::printIntLocation(location_int_t* location) {
-  DEBUG_SERIAL.print(F("SPIFFS Lat: ")); DEBUG_SERIAL.print(location->lat, DEC); DEBUG_SERIAL.print(SEP); DEBUG_SERIAL.println(location->lat_hp, DEC);
-  DEBUG_SERIAL.print(F("SPIFFS Lon: ")); DEBUG_SERIAL.print(location->lon, DEC); DEBUG_SERIAL.print(SEP); DEBUG_SERIAL.println(location->lon_hp, DEC);
-  DEBUG_SERIAL.print(F("SPIFFS Alt: ")); DEBUG_SERIAL.print(location->alt, DEC); DEBUG_SERIAL.print(SEP); DEBUG_SERIAL.println(location->alt_hp, DEC);
+  DEBUG_SERIAL.print(F("Stored Lat: ")); DEBUG_SERIAL.print(location->lat, DEC); DEBUG_SERIAL.print(SEP); DEBUG_SERIAL.println(location->lat_hp, DEC);
+  DEBUG_SERIAL.print(F("Stored Lon: ")); DEBUG_SERIAL.print(location->lon, DEC); DEBUG_SERIAL.print(SEP); DEBUG_SERIAL.println(location->lon_hp, DEC);
+  DEBUG_SERIAL.print(F("Stored Alt: ")); DEBUG_SERIAL.print(location->alt, DEC); DEBUG_SERIAL.print(SEP); DEBUG_SERIAL.println(location->alt_hp, DEC);
 }
 /*** Help Functions ***/
 // TODO: make this privat
@@ -436,6 +458,12 @@ int8_t RTKBaseManager::getHighPrecisionPartFromDouble(double input)
   return output;
 }
 
+void RTKBaseManager::getIntPartsFromCSV(const char* csv, int32_t* val, int8_t* valHp) {
+  char* sep;
+  *val = (int32_t)strtol(csv, &sep, 10);
+  *valHp = (*sep == SEP) ? (int8_t)strtol(sep + 1, nullptr, 10) : 0;
+}
+
 double RTKBaseManager::getDoubleFromIntegerParts(int32_t val, int8_t valHp) 
 {
   double d_val;
@@ -7,11 +7,7 @@
  *          the realtime kinematics base station
  * <br>
  * @todo    - a simular version for the head tracker
- *          - a check for special characters in the form
- *          - a check of the number of decimal places in the input of the geo-coordinates 
- *            with regard to a suitable level of accuracy
- *          - upload html and (separated css and js) to SPIFFS 
- *          - refactor func getIntLocationFromSPIFFS (get ist not good)
+ *          - refactor func getIntLocationFromStorage (get ist not good)
  * 
  * @note    FYI: A good tutorial about how to transfer input data from a from and save them to SPIFFS
  *          https://medium.com/@adihendro/html-form-data-input-c942ba23224
@@ -27,6 +23,7 @@
 #include <error_html.h>
 #include <reboot_html.h>
 #include <ManagerConfig.h>
+#include <PerfectHash.h>
 
 #ifdef ESP32
   #include <WiFi.h>
@@ -46,36 +43,68 @@ namespace RTKBaseManager {
   #define DEVICE_NAME "rtkbase"
   #endif
   // WiFi credentials for AP mode
-  #define MAX_SSIDS 10 // Space to scan and remember SSIDs
-  const char AP_SSID[] PROGMEM = "RTK-Base";
-  const char AP_PASSWORD[] PROGMEM = "12345678";
-  const char IP_AP[] PROGMEM = "192.168.4.1";
+  #define MAX_SSIDS 10 // Space to scan and remember SSIDs, see NetworkSurvey.h
+  constexpr char AP_SSID[] PROGMEM = "RTK-Base";
+  constexpr char AP_PASSWORD[] PROGMEM = "12345678";
+  constexpr char IP_AP[] PROGMEM = "192.168.4.1";
   // Parameters for SPIFFS file management
-  const char PARAM_WIFI_SSID[] PROGMEM = "ssid"; 
-  const char PARAM_WIFI_PASSWORD[] PROGMEM = "password";
-  const char PARAM_RTK_CASTER_HOST[] PROGMEM = "caster_host";
-  const char PARAM_RTK_CASTER_PORT[] PROGMEM = "caster_port";
-  const char PARAM_RTK_MOINT_POINT[] PROGMEM = "mount_point";
-  const char PARAM_RTK_MOINT_POINT_PW[] PROGMEM = "mount_point_pw";
-  const char PARAM_RTK_LOCATION_METHOD[] PROGMEM = "location_method";
-  const char PARAM_RTK_SURVEY_ENABLED[] PROGMEM = "survey_enabled";
-  const char PARAM_RTK_COORDS_ENABLED[] PROGMEM = "coords_enabled";
-  const char PARAM_RTK_LOCATION_SURVEY_ACCURACY[] PROGMEM = "survey_accuracy";
-  const char PARAM_RTK_LOCATION_LONGITUDE[] PROGMEM = "longitude";
-  const char PARAM_RTK_LOCATION_LATITUDE[] PROGMEM = "latitude";
-  const char PARAM_RTK_LOCATION_ALTITUDE[] PROGMEM = "altitude";
+  constexpr char PARAM_WIFI_SSID[] PROGMEM = "ssid"; 
+  constexpr char PARAM_WIFI_PASSWORD[] PROGMEM = "password";
+  constexpr char PARAM_RTK_CASTER_HOST[] PROGMEM = "caster_host";
+  constexpr char PARAM_RTK_CASTER_PORT[] PROGMEM = "caster_port";
+  constexpr char PARAM_RTK_MOINT_POINT[] PROGMEM = "mount_point";
+  constexpr char PARAM_RTK_MOINT_POINT_PW[] PROGMEM = "mount_point_pw";
+  // More casters fed with the same stream, see CasterFanout.h
+  constexpr char PARAM_RTK_CASTER_HOST_2[] PROGMEM = "caster_host_2";
+  constexpr char PARAM_RTK_CASTER_PORT_2[] PROGMEM = "caster_port_2";
+  constexpr char PARAM_RTK_MOINT_POINT_2[] PROGMEM = "mount_point_2";
+  constexpr char PARAM_RTK_MOINT_POINT_PW_2[] PROGMEM = "mount_point_pw_2";
+  constexpr char PARAM_RTK_CASTER_HOST_3[] PROGMEM = "caster_host_3";
+  constexpr char PARAM_RTK_CASTER_PORT_3[] PROGMEM = "caster_port_3";
+  constexpr char PARAM_RTK_MOINT_POINT_3[] PROGMEM = "mount_point_3";
+  constexpr char PARAM_RTK_MOINT_POINT_PW_3[] PROGMEM = "mount_point_pw_3";
+  constexpr char PARAM_RTK_LOCATION_METHOD[] PROGMEM = "location_method";
+  constexpr char PARAM_RTK_SURVEY_ENABLED[] PROGMEM = "survey_enabled";
+  constexpr char PARAM_RTK_COORDS_ENABLED[] PROGMEM = "coords_enabled";
+  constexpr char PARAM_RTK_LOCATION_SURVEY_ACCURACY[] PROGMEM = "survey_accuracy";
+  constexpr char PARAM_RTK_LOCATION_LONGITUDE[] PROGMEM = "longitude";
+  constexpr char PARAM_RTK_LOCATION_LATITUDE[] PROGMEM = "latitude";
+  constexpr char PARAM_RTK_LOCATION_ALTITUDE[] PROGMEM = "altitude";
+  constexpr char PARAM_TASK_PROFILE[] PROGMEM = "task_profile";
+  constexpr char TASK_PROFILE_BALANCED[] PROGMEM = "balanced";
+  constexpr char TASK_PROFILE_ISOLATED[] PROGMEM = "isolated";
+  constexpr char TASK_PROFILE_SINGLE_CORE[] PROGMEM = "single_core";
+  constexpr char PARAM_CASTER_STANDBY[] PROGMEM = "caster_standby";
+  constexpr char SWITCH_ON[] PROGMEM = "on";
+  constexpr char SWITCH_OFF[] PROGMEM = "off";
+  constexpr char PARAM_RTCM_RATES[] PROGMEM = "rtcm_rates";
+  constexpr char RTCM_RATES_ALL[] PROGMEM = "all";
+  // Placeholders of the reboot page
+  constexpr char PARAM_NEXT_ADDR[] PROGMEM = "next_addr";
+  constexpr char PARAM_NEXT_SSID[] PROGMEM = "next_ssid";
   // Paths for SPIFFS file management
-  const char PATH_WIFI_SSID[] PROGMEM = "/ssid.txt";
-  const char PATH_WIFI_PASSWORD[] PROGMEM = "/password.txt";
-  const char PATH_RTK_CASTER_HOST[] PROGMEM = "/caster_host";
-  const char PATH_RTK_CASTER_PORT[] PROGMEM = "/caster_port";
-  const char PATH_RTK_MOINT_POINT[] PROGMEM = "/mount_point";
-  const char PATH_RTK_MOINT_POINT_PW[] PROGMEM = "/mount_point_pw";
-  const char PATH_RTK_LOCATION_METHOD[] PROGMEM = "/location_method.txt";
-  const char PATH_RTK_LOCATION_SURVEY_ACCURACY[] PROGMEM = "/survey_accuracy.txt";
-  const char PATH_RTK_LOCATION_LONGITUDE[] PROGMEM = "/longitude.txt";
-  const char PATH_RTK_LOCATION_LATITUDE[] PROGMEM = "/latitude.txt";
-  const char PATH_RTK_LOCATION_ALTITUDE[] PROGMEM = "/altitude.txt";
+  constexpr char PATH_WIFI_SSID[] PROGMEM = "/ssid.txt";
+  constexpr char PATH_WIFI_PASSWORD[] PROGMEM = "/password.txt";
+  constexpr char PATH_RTK_CASTER_HOST[] PROGMEM = "/caster_host";
+  constexpr char PATH_RTK_CASTER_PORT[] PROGMEM = "/caster_port";
+  constexpr char PATH_RTK_MOINT_POINT[] PROGMEM = "/mount_point";
+  constexpr char PATH_RTK_MOINT_POINT_PW[] PROGMEM = "/mount_point_pw";
+  constexpr char PATH_RTK_CASTER_HOST_2[] PROGMEM = "/caster_host_2";
+  constexpr char PATH_RTK_CASTER_PORT_2[] PROGMEM = "/caster_port_2";
+  constexpr char PATH_RTK_MOINT_POINT_2[] PROGMEM = "/mount_point_2";
+  constexpr char PATH_RTK_MOINT_POINT_PW_2[] PROGMEM = "/mount_point_pw_2";
+  constexpr char PATH_RTK_CASTER_HOST_3[] PROGMEM = "/caster_host_3";
+  constexpr char PATH_RTK_CASTER_PORT_3[] PROGMEM = "/caster_port_3";
+  constexpr char PATH_RTK_MOINT_POINT_3[] PROGMEM = "/mount_point_3";
+  constexpr char PATH_RTK_MOINT_POINT_PW_3[] PROGMEM = "/mount_point_pw_3";
+  constexpr char PATH_RTK_LOCATION_METHOD[] PROGMEM = "/location_method.txt";
+  constexpr char PATH_RTK_LOCATION_SURVEY_ACCURACY[] PROGMEM = "/survey_accuracy.txt";
+  constexpr char PATH_RTK_LOCATION_LONGITUDE[] PROGMEM = "/longitude.txt";
+  constexpr char PATH_RTK_LOCATION_LATITUDE[] PROGMEM = "/latitude.txt";
+  constexpr char PATH_RTK_LOCATION_ALTITUDE[] PROGMEM = "/altitude.txt";
+  constexpr char PATH_TASK_PROFILE[] PROGMEM = "/task_profile.txt";
+  constexpr char PATH_CASTER_STANDBY[] PROGMEM = "/caster_standby.txt";
+  constexpr char PATH_RTCM_RATES[] PROGMEM = "/rtcm_rates.txt";
   const char SEP = ',';
   const uint8_t LOW_PREC_IDX = 0;
   const uint8_t HIGH_PREC_IDX = 1;
@@ -92,10 +121,100 @@ typedef struct {
   int8_t  lat_hp;    // high precision extension latitude
   int32_t lon;       // 7 post comma digits longitude
   int8_t  lon_hp;    // high precision extension longitude
-  int32_t alt;       // 7 post comma digits height
-  int8_t  alt_hp;    // high precision extension height
+  int32_t alt;       // height in cm
+  int8_t  alt_hp;    // high precision extension height in 0.1 mm
 } location_int_t;
 
+  /*** Parameter table ***/
+
+typedef enum {
+  CODEC_PLAIN,        // stored and shown as entered
+  CODEC_SECRET,       // stored as entered, shown masked
+  CODEC_CSV_COORD,    // stored as <int32_t,int8_t> CSV, shown as double
+  CODEC_CSV_ALTITUDE, // stored as <cm,0.1 mm> CSV like the receiver's height, shown in m
+  CODEC_NEXT_ADDR     // address of the next boot, derived from the WiFi credentials
+} param_codec_t;
+
+typedef enum {
+  CHECK_NONE,         // read only, never accepted from a form
+  CHECK_TEXT,         // printable ASCII without HTML and template special characters
+  CHECK_SECRET,       // printable ASCII, never rendered
+  CHECK_HOST,         // host name or IPv4 address characters
+  CHECK_PORT,         // 1 .. 65535
+  CHECK_METHOD,       // survey_enabled or coords_enabled
+  CHECK_ACCURACY,     // positive decimal in m
+  CHECK_LATITUDE,     // +-90 deg with 7 to 9 post dot digits
+  CHECK_LONGITUDE,    // +-180 deg with 7 to 9 post dot digits
+  CHECK_ALTITUDE,     // ALTITUDE_MIN_M .. ALTITUDE_MAX_M with up to 4 post dot digits
+  CHECK_PROFILE,      // name of a task runtime profile, see TaskRuntime.h
+  CHECK_SWITCH,       // on or off
+  CHECK_RATES         // RTCM rate schedule, see RtcmScheduler.h
+} param_check_t;
+
+typedef struct {
+  const char*   name;         // form field and placeholder name
+  const char*   path;         // storage path of the stored value
+  param_codec_t codec;        // how to store and render the value
+  const char*   placeholder;  // shown if nothing is stored
+  param_check_t check;        // how to validate a posted value
+} param_entry_t;
+
+  // One line per form field or placeholder, order does not matter
+  constexpr param_entry_t PARAM_TABLE[] = {
+    { PARAM_WIFI_SSID,                    PATH_WIFI_SSID,                    CODEC_PLAIN,        PARAM_WIFI_SSID,                    CHECK_TEXT      },
+    { PARAM_WIFI_PASSWORD,                PATH_WIFI_PASSWORD,                CODEC_SECRET,       PARAM_WIFI_PASSWORD,                CHECK_SECRET    },
+    { PARAM_RTK_CASTER_HOST,              PATH_RTK_CASTER_HOST,              CODEC_PLAIN,        PARAM_RTK_CASTER_HOST,              CHECK_HOST      },
+    { PARAM_RTK_CASTER_PORT,              PATH_RTK_CASTER_PORT,              CODEC_PLAIN,        PARAM_RTK_CASTER_PORT,              CHECK_PORT      },
+    { PARAM_RTK_MOINT_POINT,              PATH_RTK_MOINT_POINT,              CODEC_PLAIN,        PARAM_RTK_MOINT_POINT,              CHECK_TEXT      },
+    { PARAM_RTK_MOINT_POINT_PW,           PATH_RTK_MOINT_POINT_PW,           CODEC_SECRET,       PARAM_RTK_MOINT_POINT_PW,           CHECK_SECRET    },
+    { PARAM_RTK_CASTER_HOST_2,            PATH_RTK_CASTER_HOST_2,            CODEC_PLAIN,        PARAM_RTK_CASTER_HOST,              CHECK_HOST      },
+    { PARAM_RTK_CASTER_PORT_2,            PATH_RTK_CASTER_PORT_2,            CODEC_PLAIN,        PARAM_RTK_CASTER_PORT,              CHECK_PORT      },
+    { PARAM_RTK_MOINT_POINT_2,            PATH_RTK_MOINT_POINT_2,            CODEC_PLAIN,        PARAM_RTK_MOINT_POINT,              CHECK_TEXT      },
+    { PARAM_RTK_MOINT_POINT_PW_2,         PATH_RTK_MOINT_POINT_PW_2,         CODEC_SECRET,       PARAM_RTK_MOINT_POINT_PW,           CHECK_SECRET    },
+    { PARAM_RTK_CASTER_HOST_3,            PATH_RTK_CASTER_HOST_3,            CODEC_PLAIN,        PARAM_RTK_CASTER_HOST,              CHECK_HOST      },
+    { PARAM_RTK_CASTER_PORT_3,            PATH_RTK_CASTER_PORT_3,            CODEC_PLAIN,        PARAM_RTK_CASTER_PORT,              CHECK_PORT      },
+    { PARAM_RTK_MOINT_POINT_3,            PATH_RTK_MOINT_POINT_3,            CODEC_PLAIN,        PARAM_RTK_MOINT_POINT,              CHECK_TEXT      },
+    { PARAM_RTK_MOINT_POINT_PW_3,         PATH_RTK_MOINT_POINT_PW_3,         CODEC_SECRET,       PARAM_RTK_MOINT_POINT_PW,           CHECK_SECRET    },
+    { PARAM_RTK_LOCATION_METHOD,          PATH_RTK_LOCATION_METHOD,          CODEC_PLAIN,        PARAM_RTK_SURVEY_ENABLED,           CHECK_METHOD    },
+    { PARAM_RTK_LOCATION_SURVEY_ACCURACY, PATH_RTK_LOCATION_SURVEY_ACCURACY, CODEC_PLAIN,        PARAM_RTK_LOCATION_SURVEY_ACCURACY, CHECK_ACCURACY  },
+    { PARAM_RTK_LOCATION_LATITUDE,        PATH_RTK_LOCATION_LATITUDE,        CODEC_CSV_COORD,    PARAM_RTK_LOCATION_LATITUDE,        CHECK_LATITUDE  },
+    { PARAM_RTK_LOCATION_LONGITUDE,       PATH_RTK_LOCATION_LONGITUDE,       CODEC_CSV_COORD,    PARAM_RTK_LOCATION_LONGITUDE,       CHECK_LONGITUDE },
+    { PARAM_RTK_LOCATION_ALTITUDE,        PATH_RTK_LOCATION_ALTITUDE,        CODEC_CSV_ALTITUDE, PARAM_RTK_LOCATION_ALTITUDE,        CHECK_ALTITUDE  },
+    { PARAM_TASK_PROFILE,                 PATH_TASK_PROFILE,                 CODEC_PLAIN,        TASK_PROFILE_BALANCED,              CHECK_PROFILE   },
+    { PARAM_CASTER_STANDBY,               PATH_CASTER_STANDBY,               CODEC_PLAIN,        SWITCH_OFF,                         CHECK_SWITCH    },
+    { PARAM_RTCM_RATES,                   PATH_RTCM_RATES,                   CODEC_PLAIN,        RTCM_RATES_ALL,                     CHECK_RATES     },
+    { PARAM_NEXT_ADDR,                    PATH_WIFI_SSID,                    CODEC_NEXT_ADDR,    IP_AP,                              CHECK_NONE      },
+    { PARAM_NEXT_SSID,                    PATH_WIFI_SSID,                    CODEC_PLAIN,        AP_SSID,                            CHECK_NONE      },
+  };
+  constexpr size_t PARAM_COUNT = sizeof(PARAM_TABLE) / sizeof(PARAM_TABLE[0]);
+  // The table is a copy per translation unit, so entries are passed around by index
+  const int8_t PARAM_NONE = -1;
+  // Four buckets per entry keep the compile time seed search short
+  constexpr size_t PARAM_BUCKETS = 4 * PARAM_COUNT;
+  constexpr uint32_t PARAM_SEED = PerfectHash::findSeed(PARAM_TABLE, 0, PARAM_BUCKETS);
+  static_assert(PARAM_COUNT < 128, "PARAM_TABLE too large for int8_t indices");
+  static_assert(PARAM_SEED < PerfectHash::MAX_SEED, "No perfect hash seed for PARAM_TABLE, increase PARAM_BUCKETS");
+  constexpr PerfectHash::SlotMap<PARAM_BUCKETS> PARAM_SLOTS = PerfectHash::makeSlotMap<PARAM_BUCKETS>(PARAM_TABLE, PARAM_SEED);
+
+  /*** Config snapshot ***/
+
+  // Longest stored value, CSV coordinates need 15 chars at most
+  const uint8_t CONFIG_VALUE_MAX_LEN = 31;
+  // Longest rendered placeholder value, a placeholder text or a stored value
+  const uint8_t RENDER_VALUE_MAX_LEN = 40;
+  // "-214.748364899" plus headroom for the int8_t part of hand edited files
+  const uint8_t CSV_NUMBER_MAX_LEN = 24;
+  // Altitudes a base can have, the stored cm fit an int32_t by far
+  const int16_t ALTITUDE_MIN_M = -500;
+  const int16_t ALTITUDE_MAX_M = 9000;
+
+typedef struct {
+  uint32_t        version;      // incremented by every publishConfig()
+  char            values[PARAM_COUNT][CONFIG_VALUE_MAX_LEN + 1]; // stored values, indexed like PARAM_TABLE
+  location_int_t  location;     // parsed from the stored coordinates
+  bool            hasLocation;  // false if a coordinate is missing
+} config_snapshot_t;
+
   /*** Wifi ***/
 
   /**
@@ -117,9 +236,10 @@ typedef struct {
   void setupAPMode(const char* apSsid, const char* apPassword);
 
   /**
-   * @brief Check possibility of connecting with an availbale network.
+   * @brief Check possibility of connecting with an availbale network, the survey
+   *        table is checked first, a scan is only done if the SSID is not in it.
    * 
-   * @param ssid        SSID of saved network in SPIFFS
+   * @param ssid        SSID of saved network
    * @return true       If the credentials are complete and the network is available.
    * @return false      If the credentials are incomplete or the network is not available.
    */
@@ -142,6 +262,36 @@ typedef struct {
    */
   String processor(const String& var);
 
+  /**
+   * @brief Find a form field or placeholder in the PARAM_TABLE in O(1)
+   * 
+   * @param name    Form field or placeholder name
+   * @return int8_t Index in PARAM_TABLE or PARAM_NONE if unknown
+   */
+  int8_t findParam(const char* name);
+
+  /**
+   * @brief Render the stored value of a table entry as placeholder text into
+   *        a buffer, without heap allocations
+   * 
+   * @param idx     Index in PARAM_TABLE
+   * @param config  Config snapshot to take the value from
+   * @param out     Buffer, zero terminated, truncated if too short
+   * @param outLen  Size of the buffer, RENDER_VALUE_MAX_LEN + 1 fits every value
+   * @return size_t Length of the text without the terminator
+   */
+  size_t renderParam(int8_t idx, const config_snapshot_t* config, char* out, size_t outLen);
+
+  /**
+   * @brief Encode and save a posted value of a table entry to the storage
+   * 
+   * @param param   Table entry
+   * @param value   Posted value, already validated
+   * @return true   If the value was saved
+   * @return false  If the entry is read only, the value empty or writing failed
+   */
+  bool storeParam(const param_entry_t* param, const char* value);
+
   /**
    * @brief Request not found handler
    * 
@@ -150,7 +300,7 @@ typedef struct {
   void notFound(AsyncWebServerRequest *request);
 
   /**
-   * @brief Action to handle wipe SPIFFS button
+   * @brief Action to handle wipe storage button
    * 
    * @param request Request
    */
@@ -170,11 +320,55 @@ typedef struct {
    */
   void actionUpdateData(AsyncWebServerRequest *request);
 
+  /**
+   * @brief Body handler of the Save button, decodes the form chunk by chunk
+   *        into the fixed field buffers of a form_parser_t (see FormParser.h)
+   * 
+   * @param request Request
+   * @param data    Chunk of the url encoded body
+   * @param len     Length of the chunk
+   * @param index   Offset of the chunk in the body
+   * @param total   Length of the body
+   */
+  void actionUpdateDataBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+
+
+  /*** Config snapshot ***/
+
+  /**
+   * @brief Read all PARAM_TABLE values from the storage and publish them as new
+   *        config snapshot. Call after setupStorage() and after every change
+   *        of the stored values.
+   */
+  void loadConfig(void);
+
+  /**
+   * @brief Publish a new config snapshot. Writers are serialized by a short
+   *        critical section, readers never block and never see a torn snapshot.
+   * 
+   * @param next  New snapshot, its version is set here
+   */
+  void publishConfig(config_snapshot_t* next);
+
+  /**
+   * @brief Get a consistent copy of the current config snapshot, lock free
+   *        (seqlock, retries only while a writer is copying)
+   * 
+   * @param config  Address of the snapshot to copy to
+   */
+  void readConfig(config_snapshot_t* config);
+
+  /**
+   * @brief Get the version of the current config snapshot
+   * 
+   * @return uint32_t Number of published snapshots
+   */
+  uint32_t configVersion(void);
 
-  /*** SPIFFS ***/
+  /*** Storage, see Storage.h for the backends ***/
 
   /**
-   * @brief Just init SPIFFS for ESP32 or ESP8266
+   * @brief Just init SPIFFS for ESP32 or ESP8266, begin() of the SPIFFS backend
    * 
    * @param format  True if SPIFFS should formated at start
    * @return true   If SPIFFS is successfully initialized
@@ -183,7 +377,7 @@ typedef struct {
   bool setupSPIFFS(bool format);
 
   /**
-   * @brief         Write data to SPIFFS
+   * @brief         Write data to a file system
    * 
    * @param fs      Address of file system
    * @param path    Path to file
@@ -194,7 +388,7 @@ typedef struct {
   bool writeFile(fs::FS &fs, const char* path, const char* message);
 
   /**
-   * @brief           Read data from SPIFFS
+   * @brief           Read data from a file system
    * 
    * @param fs        Address of file system
    * @param path      Path to file
@@ -203,36 +397,28 @@ typedef struct {
   String readFile(fs::FS &fs, const char* path);
 
   /**
-   * @brief List all saved SPIFFS files 
+   * @brief List all values of the active storage backend
    * 
    */
   void listFiles(void);
 
   /**
-   * @brief Delete all saved SPIFFS files 
+   * @brief Delete all values of the active storage backend
    * 
    */
-  void wipeSpiffsFiles(void);
-
-  // /**
-  //  * @brief Get the Location struct from SPIFFS
-  //  * 
-  //  * @param writeLocation Address of location struct to write to
-  //  * @return true  If saved location data exist
-  //  * @return false If reading location data failed or data not exist
-  //  */
+  void wipeStorage(void);
 
   /**
-   * @brief Get the int formated location from SPIFFS 
+   * @brief Get the int formated location from the active storage backend
    * 
    * @param location Address of location_int_t location struct to write to
    * @param pathLat Path to saved latitude
    * @param pathLon Path to saved longitude
    * @param pathAlt Path to saved altitude
-   * @return true 
-   * @return false 
+   * @return true  If all three values exist
+   * @return false If a value is missing
    */
-  bool getIntLocationFromSPIFFS(location_int_t* location, const char* pathLat, const char* pathLon, const char* pathAlt);
+  bool getIntLocationFromStorage(location_int_t* location, const char* pathLat, const char* pathLon, const char* pathAlt);
   
   /**
    * @brief Print content of location_int_t struct
@@ -270,6 +456,15 @@ typedef struct {
    */
   double getDoubleFromIntegerParts(int32_t val, int8_t valHp);
 
+  /**
+   * @brief Get the integer parts of a CSV integer object without heap allocations
+   * 
+   * @param csv   CSV String: <int32_t, int8_t>
+   * @param val   Address to write the 7 post dot digits part to
+   * @param valHp Address to write the high precision part to, 0 if missing
+   */
+  void getIntPartsFromCSV(const char* csv, int32_t* val, int8_t* valHp);
+
   /**
    * @brief Get the deconstructed double val as CSV integer object
    * 
@@ -278,6 +473,15 @@ typedef struct {
    */
   String getDeconstructedValAsCSV(const String& doubleStr);
 
+  /**
+   * @brief Get an altitude as CSV integer object in cm and 0.1 mm, the units
+   *        of the receiver's height, parsed without a double
+   *
+   * @param meters  Altitude in m, checked by CHECK_ALTITUDE
+   * @return String Altitude as CSV
+   */
+  String getAltitudeAsCSV(const char* meters);
+
   /**
    * @brief Get the reconstructed val from CSV object
    * 
@@ -286,6 +490,19 @@ typedef struct {
    */
   String getDoubleStringFromCSV(const String& csvStr);
 
+  /**
+   * @brief Format a CSV integer object as decimal number with integer math,
+   *        getDoubleStringFromCSV() without heap allocations
+   * 
+   * @param csv       CSV String: <int32_t, int8_t>
+   * @param decimals  Post dot digits of the 1e-9 units, 9 for the value itself,
+   *                  5 for the value times 1e4
+   * @param out       Buffer, zero terminated, CSV_NUMBER_MAX_LEN + 1 fits every value
+   * @param outLen    Size of the buffer
+   * @return size_t   Length of the text, 0 for an empty CSV String
+   */
+  size_t formatCSVFixedPoint(const char* csv, uint8_t decimals, char* out, size_t outLen);
+
   /**
    * @brief Get the Value from CSV object
    * 
@@ -0,0 +1,70 @@
+/**
+ * @file    RecordFormat.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Layout of the GNSS recording, shared by the firmware and the host
+ *          replay tool in tools/replay. Plain C types only. All numbers are
+ *          little endian, like the ESP32.
+ *
+ *          In the recorder partition, one segment every RECORD_SEGMENT_SIZE:
+ *            segment header | index[RECORD_INDEX_LEN] | records ... | 0xFF
+ *          Downloaded from /api/recording:
+ *            stream header | records ...
+ *
+ *          A record is a record header and the data, e.g. one RTCM frame.
+ *          Index entry i points to the first record at or behind
+ *          RECORD_DATA_OFFSET + i * RECORD_INDEX_STRIDE, a time window is
+ *          found with a binary search of the index instead of a scan.
+ */
+
+#ifndef RECORD_FORMAT_H
+#define RECORD_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RECORD_SEGMENT_MAGIC    0x524B5452u   // "RTKR"
+#define RECORD_STREAM_MAGIC     0x534B5452u   // "RTKS"
+#define RECORD_VERSION          1
+#define RECORD_SEGMENT_SIZE     0x10000       // multiple of the 4 kB flash sector
+#define RECORD_INDEX_LEN        60
+#define RECORD_DATA_OFFSET      512           // segment header and index
+#define RECORD_INDEX_STRIDE     ((RECORD_SEGMENT_SIZE - RECORD_DATA_OFFSET) / RECORD_INDEX_LEN)
+#define RECORD_INDEX_UNUSED     0xFFFFFFFFu   // erased flash
+#define RECORD_END              0xFFFF        // length of the erased space behind the last record
+
+#define RECORD_KIND_RTCM        1             // RTCM 3 frame with header and CRC
+#define RECORD_KIND_UBX         2             // UBX frame with sync chars and checksum
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t indexLen;        // RECORD_INDEX_LEN
+  uint32_t sequence;        // counts up over all segments, the oldest has the lowest
+  uint32_t boot;            // random per boot, the times start over with a new one
+  uint32_t startMs;         // uptime at the first record
+  uint32_t reserved[3];
+} record_segment_header_t;
+
+typedef struct {
+  uint32_t timeMs;          // of the record at offset
+  uint32_t offset;          // from the segment start, RECORD_INDEX_UNUSED if not written yet
+} record_index_entry_t;
+
+typedef struct {
+  uint32_t timeMs;          // uptime at the arrival
+  uint16_t len;             // of the data behind the header, RECORD_END behind the last one
+  uint8_t  kind;            // RECORD_KIND_*
+  uint8_t  tag;             // low byte of the segment sequence, tells stale data from an older lap
+} record_header_t;
+
+typedef struct {
+  uint32_t magic;           // RECORD_STREAM_MAGIC
+  uint16_t version;
+  uint16_t flags;           // reserved, 0
+  uint32_t boot;            // of the base when downloaded
+  uint32_t uptimeMs;        // of the base when downloaded
+} record_stream_header_t;
+
+#endif /*** RECORD_FORMAT_H ***/
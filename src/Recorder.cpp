@@ -0,0 +1,384 @@
+#include <Recorder.h>
+#include <TaskRuntime.h>
+#include <esp_partition.h>
+#include <freertos/message_buffer.h>
+
+using RTKBaseManager::recorder_stats_t;
+using RTKBaseManager::recording_reader_t;
+
+const uint32_t RECORD_SECTOR_SIZE = 4096;
+const size_t   RECORD_MAX_LEN = sizeof(record_header_t) + RTKBaseManager::RTCM_FRAME_MAX_LEN;
+
+typedef struct {
+  bool     valid;
+  uint32_t sequence;
+  uint32_t boot;
+  uint32_t startMs;
+} segment_info_t;
+
+static const esp_partition_t* partition = nullptr;
+static uint8_t segmentCount = 0;
+static uint32_t boot = 0;
+static MessageBufferHandle_t buffer = nullptr;
+
+// Shared with the HTTP handlers
+static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+static segment_info_t segments[RTKBaseManager::RECORD_MAX_SEGMENTS];
+static int16_t activeSegment = -1;
+static uint32_t committed = 0;                // end of the last complete record of the active segment
+
+// Owned by the recorder task
+static bool segmentOpen = false;
+static uint32_t writeSequence = 0;
+static uint32_t nextSequence = 0;
+static uint8_t nextSegment = 0;
+static uint32_t writePos = 0;
+static uint32_t erasedTo = 0;
+static uint8_t indexCount = 0;
+static uint8_t writing[RECORD_MAX_LEN];
+
+static uint8_t staging[RECORD_MAX_LEN];       // owned by the ingest task
+static recorder_stats_t stats;
+
+/********************************************************************************
+*                             Writer
+* ******************************************************************************/
+
+// Keeps the sector behind the last record erased, readers stop at its 0xFF
+// and never run into the data of an older lap
+static bool eraseThrough(uint32_t base, uint32_t end) {
+  uint32_t limit = ((end + RECORD_SECTOR_SIZE - 1) / RECORD_SECTOR_SIZE + 1) * RECORD_SECTOR_SIZE;
+  if (limit > RECORD_SEGMENT_SIZE) limit = RECORD_SEGMENT_SIZE;
+  while (erasedTo < limit) {
+    if (esp_partition_erase_range(partition, base + erasedTo, RECORD_SECTOR_SIZE) != ESP_OK) return false;
+    erasedTo += RECORD_SECTOR_SIZE;
+    stats.erases++;
+  }
+  return true;
+}
+
+static bool openSegment(uint32_t timeMs) {
+  uint8_t slot = nextSegment;
+  uint32_t base = slot * RECORD_SEGMENT_SIZE;
+  portENTER_CRITICAL(&mux);
+  segments[slot].valid = false;
+  activeSegment = slot;
+  committed = RECORD_DATA_OFFSET;
+  portEXIT_CRITICAL(&mux);
+
+  segmentOpen = false;
+  erasedTo = 0;
+  record_segment_header_t header;
+  memset(&header, 0, sizeof(header));
+  header.magic = RECORD_SEGMENT_MAGIC;
+  header.version = RECORD_VERSION;
+  header.indexLen = RECORD_INDEX_LEN;
+  header.sequence = nextSequence;
+  header.boot = boot;
+  header.startMs = timeMs;
+  if (!eraseThrough(base, RECORD_DATA_OFFSET) || esp_partition_write(partition, base, &header, sizeof(header)) != ESP_OK) {
+    stats.writeErrors++;
+    return false;
+  }
+
+  portENTER_CRITICAL(&mux);
+  segments[slot].valid = true;
+  segments[slot].sequence = header.sequence;
+  segments[slot].boot = boot;
+  segments[slot].startMs = timeMs;
+  portEXIT_CRITICAL(&mux);
+
+  segmentOpen = true;
+  writeSequence = nextSequence++;
+  nextSegment = (slot + 1) % segmentCount;
+  writePos = RECORD_DATA_OFFSET;
+  indexCount = 0;
+  return true;
+}
+
+static void appendRecord(uint8_t* data, size_t len) {
+  record_header_t* header = (record_header_t*)data;
+  if ((!segmentOpen || writePos + len > RECORD_SEGMENT_SIZE) && !openSegment(header->timeMs)) return;
+  header->tag = (uint8_t)writeSequence;
+  uint32_t base = activeSegment * RECORD_SEGMENT_SIZE;
+
+  bool written = eraseThrough(base, writePos + len);
+  if (written && indexCount < RECORD_INDEX_LEN && writePos >= RECORD_DATA_OFFSET + (uint32_t)indexCount * RECORD_INDEX_STRIDE) {
+    record_index_entry_t entry = { header->timeMs, writePos };
+    written = esp_partition_write(partition, base + sizeof(record_segment_header_t) + indexCount * sizeof(entry), &entry, sizeof(entry)) == ESP_OK;
+    indexCount++;
+  }
+  written = written && esp_partition_write(partition, base + writePos, data, len) == ESP_OK;
+  if (!written) {
+    // Continue in a fresh segment, this one ends at the last complete record
+    stats.writeErrors++;
+    segmentOpen = false;
+    return;
+  }
+
+  writePos += len;
+  stats.records++;
+  stats.bytes += len;
+  portENTER_CRITICAL(&mux);
+  committed = writePos;
+  portEXIT_CRITICAL(&mux);
+}
+
+static void recorderLoop(void* parameter) {
+  while (true) {
+    size_t len = xMessageBufferReceive(buffer, writing, sizeof(writing), portMAX_DELAY);
+    if (len >= sizeof(record_header_t)) appendRecord(writing, len);
+  }
+}
+
+bool RTKBaseManager::mountRecording() {
+  if (partition != nullptr) return true;
+
+  const esp_partition_t* found = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, RECORDER_PARTITION_LABEL);
+  if (found == nullptr) {
+    DEBUG_SERIAL.println(F("No recorder partition"));
+    return false;
+  }
+  uint32_t fit = found->size / RECORD_SEGMENT_SIZE;
+  segmentCount = (fit < RECORD_MAX_SEGMENTS) ? fit : RECORD_MAX_SEGMENTS;
+  if (segmentCount < 2) {
+    DEBUG_SERIAL.println(F("Recorder partition too small"));
+    return false;
+  }
+
+  // Continue behind the newest segment, the older ones stay readable
+  partition = found;
+  boot = esp_random();
+  bool newest = false;
+  for (uint8_t i = 0; i < segmentCount; i++) {
+    record_segment_header_t header;
+    if (esp_partition_read(partition, i * RECORD_SEGMENT_SIZE, &header, sizeof(header)) != ESP_OK) continue;
+    if (header.magic != RECORD_SEGMENT_MAGIC || header.version != RECORD_VERSION || header.indexLen != RECORD_INDEX_LEN) continue;
+    segments[i].valid = true;
+    segments[i].sequence = header.sequence;
+    segments[i].boot = header.boot;
+    segments[i].startMs = header.startMs;
+    if (!newest || header.sequence >= nextSequence) {
+      nextSequence = header.sequence + 1;
+      nextSegment = (i + 1) % segmentCount;
+      newest = true;
+    }
+  }
+  return true;
+}
+
+bool RTKBaseManager::startRecorder() {
+  if (buffer != nullptr) return true;
+  if (!mountRecording()) {
+    DEBUG_SERIAL.println(F("Not recording"));
+    return false;
+  }
+
+  buffer = xMessageBufferCreate(RECORDER_BUFFER_LEN);
+  if (buffer == nullptr || !spawnTask(TASK_ROLE_BACKGROUND, recorderLoop, "recorder", 3072, nullptr, nullptr)) {
+    DEBUG_SERIAL.println(F("Recorder not started, low memory"));
+    return false;
+  }
+  stats.active = true;
+  DEBUG_SERIAL.printf("Recorder: %u segments of %u bytes\r\n", segmentCount, RECORD_SEGMENT_SIZE);
+  return true;
+}
+
+void RTKBaseManager::recordFrame(const rtcm_frame_t* frame) {
+  if (buffer == nullptr) return;
+  record_header_t* header = (record_header_t*)staging;
+  header->timeMs = frame->receivedMs;
+  header->len = frame->len;
+  header->kind = RECORD_KIND_RTCM;
+  header->tag = 0;
+  memcpy(staging + sizeof(record_header_t), frame->data, frame->len);
+  // Never waits, a full buffer means the flash falls behind the receiver
+  if (xMessageBufferSend(buffer, staging, sizeof(record_header_t) + frame->len, 0) == 0) stats.dropped++;
+}
+
+/********************************************************************************
+*                             Reader
+* ******************************************************************************/
+
+uint32_t RTKBaseManager::seekRecordIndex(const record_index_entry_t* index, uint16_t len, uint32_t fromMs) {
+  // Entries are written in time order, the unused ones are at the end
+  uint16_t lo = 0, hi = len;
+  while (lo < hi) {
+    uint16_t mid = (lo + hi) / 2;
+    if (index[mid].offset != RECORD_INDEX_UNUSED && index[mid].timeMs <= fromMs) lo = mid + 1;
+    else hi = mid;
+  }
+  return (lo == 0) ? RECORD_DATA_OFFSET : index[lo - 1].offset;
+}
+
+void RTKBaseManager::beginRecordingRead(recording_reader_t* d, bool window, uint32_t fromMs, uint32_t toMs) {
+  d->window = window;
+  d->fromMs = fromMs;
+  d->toMs = toMs;
+  d->raw = false;
+
+  // Segments by sequence, in a window only the ones of this boot that reach into it
+  segment_info_t snapshot[RTKBaseManager::RECORD_MAX_SEGMENTS];
+  portENTER_CRITICAL(&mux);
+  memcpy(snapshot, segments, sizeof(snapshot));
+  portEXIT_CRITICAL(&mux);
+
+  d->count = 0;
+  for (uint8_t i = 0; i < segmentCount; i++) {
+    if (!snapshot[i].valid || (d->window && snapshot[i].boot != boot)) continue;
+    uint8_t j = d->count++;
+    for (; j > 0 && snapshot[d->order[j - 1]].sequence > snapshot[i].sequence; j--) d->order[j] = d->order[j - 1];
+    d->order[j] = i;
+  }
+
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < d->count; i++) {
+    const segment_info_t* s = &snapshot[d->order[i]];
+    if (d->window && s->startMs > d->toMs) break;
+    if (d->window && i + 1 < d->count && snapshot[d->order[i + 1]].startMs <= d->fromMs) continue;
+    d->sequences[kept] = s->sequence;
+    d->order[kept++] = d->order[i];
+  }
+  d->count = kept;
+  d->pos = 0;
+  d->offset = 0;
+  d->remaining = 0;
+}
+
+static bool nextRecord(recording_reader_t* d, int16_t active, uint32_t limit) {
+  while (d->pos < d->count) {
+    uint8_t slot = d->order[d->pos];
+    uint32_t base = slot * RECORD_SEGMENT_SIZE;
+    if (d->offset == 0) {
+      d->offset = RECORD_DATA_OFFSET;
+      record_index_entry_t index[RECORD_INDEX_LEN];
+      if (d->window && esp_partition_read(partition, base + sizeof(record_segment_header_t), index, sizeof(index)) == ESP_OK) {
+        d->offset = RTKBaseManager::seekRecordIndex(index, RECORD_INDEX_LEN, d->fromMs);
+      }
+    }
+
+    // The segment ends at erased flash, at a record of a newer lap or at the writer
+    record_header_t header;
+    if (d->offset + sizeof(header) <= RECORD_SEGMENT_SIZE && !(slot == active && d->offset >= limit) &&
+        esp_partition_read(partition, base + d->offset, &header, sizeof(header)) == ESP_OK &&
+        header.len != RECORD_END && header.tag == (uint8_t)d->sequences[d->pos] &&
+        d->offset + sizeof(header) + header.len <= RECORD_SEGMENT_SIZE) {
+      uint32_t start = d->offset;
+      d->offset += sizeof(header) + header.len;
+      if (d->window && header.timeMs > d->toMs) break;
+      if (d->window && header.timeMs < d->fromMs) continue;
+      d->readPos = base + start + (d->raw ? sizeof(header) : 0);
+      d->remaining = header.len + (d->raw ? 0 : sizeof(header));
+      return true;
+    }
+    d->pos++;
+    d->offset = 0;
+  }
+  d->pos = d->count;
+  return false;
+}
+
+static void readerLimit(int16_t* active, uint32_t* limit) {
+  portENTER_CRITICAL(&mux);
+  *active = activeSegment;
+  *limit = committed;
+  portEXIT_CRITICAL(&mux);
+}
+
+bool RTKBaseManager::readRecord(recording_reader_t* reader, record_header_t* header, uint8_t* data, size_t size) {
+  int16_t active;
+  uint32_t limit;
+  readerLimit(&active, &limit);
+  reader->raw = false;
+  reader->remaining = 0;
+  if (partition == nullptr || !nextRecord(reader, active, limit)) return false;
+  if (esp_partition_read(partition, reader->readPos, header, sizeof(record_header_t)) != ESP_OK || header->len > size) return false;
+  return esp_partition_read(partition, reader->readPos + sizeof(record_header_t), data, header->len) == ESP_OK;
+}
+
+static size_t fillDownload(recording_reader_t* d, uint8_t* buf, size_t maxLen, size_t index) {
+  size_t len = 0;
+  if (index == 0 && !d->raw && maxLen >= sizeof(record_stream_header_t)) {
+    record_stream_header_t header = { RECORD_STREAM_MAGIC, RECORD_VERSION, 0, boot, (uint32_t)millis() };
+    memcpy(buf, &header, sizeof(header));
+    len = sizeof(header);
+  }
+
+  int16_t active;
+  uint32_t limit;
+  readerLimit(&active, &limit);
+  while (len < maxLen) {
+    if (d->remaining == 0 && !nextRecord(d, active, limit)) break;
+    size_t n = (d->remaining < maxLen - len) ? d->remaining : maxLen - len;
+    if (esp_partition_read(partition, d->readPos, buf + len, n) != ESP_OK) {
+      d->pos = d->count;
+      d->remaining = 0;
+      break;
+    }
+    d->readPos += n;
+    d->remaining -= n;
+    len += n;
+  }
+  return len;
+}
+
+void RTKBaseManager::actionRecording(AsyncWebServerRequest *request) {
+  if (!stats.active) {
+    request->send(404, "text/plain", "No recorder partition");
+    return;
+  }
+  request->_tempObject = malloc(sizeof(recording_reader_t));
+  if (request->_tempObject == nullptr) {
+    request->send(503, "text/plain", "Low memory");
+    return;
+  }
+  recording_reader_t* d = (recording_reader_t*)request->_tempObject;
+  beginRecordingRead(d, request->hasParam("from") || request->hasParam("to"),
+                     request->hasParam("from") ? strtoul(request->getParam("from")->value().c_str(), nullptr, 10) : 0,
+                     request->hasParam("to") ? strtoul(request->getParam("to")->value().c_str(), nullptr, 10) : UINT32_MAX);
+  d->raw = request->hasParam("format") && request->getParam("format")->value().equals("raw");
+
+  // Read from flash chunk by chunk, the recording is never held in RAM
+  AsyncWebServerResponse* response = request->beginChunkedResponse("application/octet-stream",
+      [request](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+    return fillDownload((recording_reader_t*)request->_tempObject, buffer, maxLen, index);
+  });
+  response->addHeader("Content-Disposition", d->raw ? "attachment; filename=\"recording.rtcm3\"" : "attachment; filename=\"recording.rtks\"");
+  request->send(response);
+}
+
+/********************************************************************************
+*                             Stats
+* ******************************************************************************/
+
+void RTKBaseManager::getRecorderStats(recorder_stats_t* out) {
+  memcpy(out, &stats, sizeof(recorder_stats_t));
+  out->segments = segmentCount;
+  out->sequence = writeSequence;
+  out->used = 0;
+  bool oldest = false;
+  portENTER_CRITICAL(&mux);
+  for (uint8_t i = 0; i < segmentCount; i++) {
+    if (!segments[i].valid) continue;
+    out->used++;
+    if (segments[i].boot == boot && (!oldest || segments[i].startMs < out->oldestMs)) {
+      out->oldestMs = segments[i].startMs;
+      oldest = true;
+    }
+  }
+  portEXIT_CRITICAL(&mux);
+}
+
+void RTKBaseManager::actionRecorder(AsyncWebServerRequest *request) {
+  recorder_stats_t s;
+  getRecorderStats(&s);
+
+  char json[320];
+  snprintf(json, sizeof(json),
+           "{\"active\":%s,\"segments\":%u,\"segment_size\":%u,\"used\":%u,\"sequence\":%u,\"oldest_ms\":%u,"
+           "\"records\":%u,\"bytes\":%u,\"dropped\":%u,\"erases\":%u,\"write_errors\":%u}",
+           s.active ? "true" : "false", s.segments, RECORD_SEGMENT_SIZE, s.used, (unsigned int)s.sequence,
+           (unsigned int)s.oldestMs, (unsigned int)s.records, (unsigned int)s.bytes, (unsigned int)s.dropped,
+           (unsigned int)s.erases, (unsigned int)s.writeErrors);
+  request->send(200, "application/json", json);
+}
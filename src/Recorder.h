@@ -0,0 +1,142 @@
+/**
+ * @file    Recorder.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Records the framed receiver stream into the recorder partition, to
+ *          see what the base sent when a rover had a bad fix. The partition
+ *          is a ring of fixed size segments in the layout of RecordFormat.h,
+ *          the oldest segment is overwritten when the ring is full. Frames
+ *          are copied into a message buffer on the ingest task and written to
+ *          flash by a background task, a slow erase never holds up the casters.
+ *
+ *          GET /api/recording                 -> the whole recording, oldest first
+ *          GET /api/recording?from=&to=       -> uptime window in ms of this boot
+ *          GET /api/recording?format=raw      -> frames only, e.g. for RTKLIB
+ *          GET /api/recorder                  -> counters as JSON
+ *
+ *          Without a recorder partition, see partitions_recorder.csv, nothing
+ *          is recorded.
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <RTKBaseManager.h>
+#include <RecordFormat.h>
+#include <Rtcm.h>
+
+namespace RTKBaseManager {
+  constexpr char RECORDER_PARTITION_LABEL[] PROGMEM = "recorder";
+  const uint8_t  RECORD_MAX_SEGMENTS = 64;
+
+typedef struct {
+  bool     active;            // partition found and task running
+  uint8_t  segments;          // in the partition
+  uint8_t  used;              // segments holding a recording
+  uint32_t sequence;          // of the segment being written
+  uint32_t oldestMs;          // start of the oldest segment of this boot
+  uint32_t records;
+  uint32_t bytes;             // written incl. record headers
+  uint32_t dropped;           // frames lost to a full message buffer
+  uint32_t erases;            // flash sectors erased
+  uint32_t writeErrors;
+} recorder_stats_t;
+
+typedef struct {
+  uint8_t  order[RECORD_MAX_SEGMENTS];       // segments to read, oldest first
+  uint32_t sequences[RECORD_MAX_SEGMENTS];
+  uint8_t  count;
+  uint8_t  pos;             // in order
+  uint32_t offset;          // of the next record in the segment, 0 before the segment was entered
+  uint32_t readPos;         // in the partition, of the rest of the current record
+  uint32_t remaining;
+  bool     window;
+  uint32_t fromMs;
+  uint32_t toMs;
+  bool     raw;             // data only, without the stream and record headers
+} recording_reader_t;
+
+  /**
+   * @brief Find the recorder partition, continue behind its newest segment
+   *        and start the writer task
+   *
+   * @return true   If recording
+   * @return false  If there is no recorder partition or no memory
+   */
+  bool startRecorder(void);
+
+  /**
+   * @brief Find the recorder partition and its segments for reading, called
+   *        by startRecorder()
+   *
+   * @return true   If there is a recorder partition
+   * @return false  If not
+   */
+  bool mountRecording(void);
+
+  /**
+   * @brief Append a frame to the recording, copies it, runs on the ingest task
+   *
+   * @param frame Complete frame
+   */
+  void recordFrame(const rtcm_frame_t* frame);
+
+  /**
+   * @brief Find where to start reading a segment for a time window
+   *
+   * @param index     Index of the segment
+   * @param len       Number of entries
+   * @param fromMs    Start of the window
+   * @return uint32_t Offset of the last indexed record at or before fromMs,
+   *                  RECORD_DATA_OFFSET if there is none
+   */
+  uint32_t seekRecordIndex(const record_index_entry_t* index, uint16_t len, uint32_t fromMs);
+
+  /**
+   * @brief Start reading the recording, oldest record first
+   *
+   * @param reader    Reader
+   * @param window    Only records of this boot from fromMs to toMs
+   * @param fromMs    Start of the window, uptime
+   * @param toMs      End of the window, uptime
+   */
+  void beginRecordingRead(recording_reader_t* reader, bool window, uint32_t fromMs, uint32_t toMs);
+
+  /**
+   * @brief Read the next record
+   *
+   * @param reader    Reader
+   * @param header    Address to write the record header to
+   * @param data      Buffer for the data
+   * @param size      Size of the buffer
+   * @return true     If a record was read
+   * @return false    At the end of the recording or if the data does not fit
+   */
+  bool readRecord(recording_reader_t* reader, record_header_t* header, uint8_t* data, size_t size);
+
+  /**
+   * @brief Get the counters of the recorder
+   *
+   * @param stats Address of the struct to write to
+   */
+  void getRecorderStats(recorder_stats_t* stats);
+
+  /**
+   * @brief Handler of /api/recording, streams the recording as a chunked response
+   *
+   * @param request Request
+   */
+  void actionRecording(AsyncWebServerRequest *request);
+
+  /**
+   * @brief Handler of /api/recorder, counters of the recorder as JSON
+   *
+   * @param request Request
+   */
+  void actionRecorder(AsyncWebServerRequest *request);
+}
+
+#endif /*** RECORDER_H ***/
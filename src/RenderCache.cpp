@@ -0,0 +1,141 @@
+#include <RenderCache.h>
+
+/********************************************************************************
+*                             Render cache
+* ******************************************************************************/
+
+static const uint8_t TEMPLATE_UNCACHEABLE = 0xFF;
+
+static std::atomic<uint32_t> cacheHits(0);
+static std::atomic<uint32_t> cacheMisses(0);
+static std::atomic<uint32_t> cacheUncacheable(0);
+
+static bool addSegment(RTKBaseManager::page_cache_t* page, size_t start, size_t len, int8_t param) {
+  if (page->count >= RTKBaseManager::TEMPLATE_MAX_SEGMENTS) return false;
+  RTKBaseManager::template_segment_t& segment = page->segments[page->count++];
+  segment.start = start;
+  segment.len = len;
+  segment.param = param;
+  return true;
+}
+
+// Splits like the template processing of the ESPAsyncWebServer: %name% is
+// replaced (unknown names by nothing), %% becomes %, an unclosed % stays
+static void splitTemplate(RTKBaseManager::page_cache_t* page) {
+  using namespace RTKBaseManager;
+  char name[TEMPLATE_PARAM_NAME_LENGTH + 1];
+  const char* html = page->html;
+  size_t len = strlen(html);
+  size_t literalStart = 0;
+  size_t i = 0;
+  bool success = len <= 0xFFFF;
+
+  page->htmlLen = len;
+  page->count = 0;
+  while (success && i < len) {
+    if (html[i] != '%') {
+      i++;
+      continue;
+    }
+    size_t j = i + 1;
+    while (j < len && j - i <= TEMPLATE_PARAM_NAME_LENGTH && html[j] != '%') j++;
+    if (j >= len || html[j] != '%') {
+      i++;
+      continue;
+    }
+    if (j == i + 1) {
+      success &= addSegment(page, literalStart, i + 1 - literalStart, PARAM_NONE);
+    } else {
+      memcpy(name, html + i + 1, j - i - 1);
+      name[j - i - 1] = '\0';
+      success &= addSegment(page, literalStart, i - literalStart, findParam(name));
+    }
+    literalStart = j + 1;
+    i = j + 1;
+  }
+  success &= addSegment(page, literalStart, len - literalStart, PARAM_NONE);
+
+  if (!success) page->count = TEMPLATE_UNCACHEABLE;
+}
+
+static std::shared_ptr<RTKBaseManager::rendered_values_t> renderValues(const RTKBaseManager::page_cache_t* page) {
+  using namespace RTKBaseManager;
+  std::shared_ptr<rendered_values_t> rendered = std::make_shared<rendered_values_t>();
+  config_snapshot_t config;
+  bool done[PARAM_COUNT] = { false };
+
+  // One snapshot for all placeholders, a page never mixes two versions
+  readConfig(&config);
+  rendered->version = config.version;
+  rendered->len = 0;
+  for (uint8_t s = 0; s < page->count; s++) {
+    const template_segment_t& segment = page->segments[s];
+    rendered->len += segment.len;
+    if (segment.param == PARAM_NONE) continue;
+    if (!done[segment.param]) {
+      // Rendered in place, no String per placeholder
+      rendered->valueLen[segment.param] = renderParam(segment.param, &config, rendered->values[segment.param],
+                                                      sizeof(rendered->values[segment.param]));
+      done[segment.param] = true;
+    }
+    rendered->len += rendered->valueLen[segment.param];
+  }
+  return rendered;
+}
+
+static size_t copyPart(uint8_t* buf, size_t maxLen, size_t index, size_t partStart, const char* part, size_t partLen, size_t written) {
+  size_t from = index + written;
+  if (from < partStart || from >= partStart + partLen) return 0;
+  size_t n = partStart + partLen - from;
+  if (n > maxLen - written) n = maxLen - written;
+  memcpy(buf + written, part + (from - partStart), n);
+  return n;
+}
+
+// Filler of the response, merges the template literals and the cached values
+static size_t fillPage(const RTKBaseManager::page_cache_t* page, const RTKBaseManager::rendered_values_t* rendered,
+                       uint8_t* buf, size_t maxLen, size_t index) {
+  size_t pos = 0;
+  size_t written = 0;
+
+  for (uint8_t s = 0; s < page->count && written < maxLen; s++) {
+    const RTKBaseManager::template_segment_t& segment = page->segments[s];
+    written += copyPart(buf, maxLen, index, pos, page->html + segment.start, segment.len, written);
+    pos += segment.len;
+    if (segment.param == RTKBaseManager::PARAM_NONE) continue;
+    uint8_t valueLen = rendered->valueLen[segment.param];
+    written += copyPart(buf, maxLen, index, pos, rendered->values[segment.param], valueLen, written);
+    pos += valueLen;
+  }
+  return written;
+}
+
+void RTKBaseManager::sendCachedPage(AsyncWebServerRequest *request, page_cache_t* page) {
+  if (page->count == 0) splitTemplate(page);
+  if (page->count == TEMPLATE_UNCACHEABLE) {
+    cacheUncacheable++;
+    request->send_P(200, "text/html", page->html, processor);
+    return;
+  }
+
+  // All handlers run on the async_tcp task, only counters are shared
+  if (!page->cached || page->cached->version != configVersion()) {
+    page->cached = renderValues(page);
+    cacheMisses++;
+  } else {
+    cacheHits++;
+  }
+
+  std::shared_ptr<rendered_values_t> rendered = page->cached;
+  const page_cache_t* tpl = page;
+  request->send(request->beginResponse("text/html", rendered->len,
+    [tpl, rendered](uint8_t* buf, size_t maxLen, size_t index) -> size_t {
+      return fillPage(tpl, rendered.get(), buf, maxLen, index);
+    }));
+}
+
+void RTKBaseManager::getRenderCacheStats(render_cache_stats_t* stats) {
+  stats->hits = cacheHits.load();
+  stats->misses = cacheMisses.load();
+  stats->uncacheable = cacheUncacheable.load();
+}
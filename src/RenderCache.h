@@ -0,0 +1,70 @@
+/**
+ * @file    RenderCache.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Render cache for HTML templates. The template is split once into
+ *          literal segments and placeholders, the placeholder values are rendered
+ *          once per config version. Responses are streamed from the template and
+ *          the cached values, so neither SPIFFS nor the processor is touched
+ *          again until the config changes.
+ */
+
+#ifndef RENDER_CACHE_H
+#define RENDER_CACHE_H
+
+#include <Arduino.h>
+#include <memory>
+#include <atomic>
+#include <RTKBaseManager.h>
+
+namespace RTKBaseManager {
+  const uint8_t TEMPLATE_MAX_SEGMENTS = 32;
+  // Same limit as the template processing of the ESPAsyncWebServer
+  const uint8_t TEMPLATE_PARAM_NAME_LENGTH = 32;
+
+typedef struct {
+  uint16_t start;   // offset of the literal text in the template
+  uint16_t len;     // length of the literal text
+  int8_t   param;   // PARAM_TABLE index of the following placeholder or PARAM_NONE
+} template_segment_t;
+
+typedef struct {
+  uint32_t version;                               // config version the values were rendered from
+  size_t   len;                                   // length of the whole page
+  uint8_t  valueLen[PARAM_COUNT];
+  char     values[PARAM_COUNT][RENDER_VALUE_MAX_LEN + 1];
+} rendered_values_t;
+
+typedef struct {
+  const char*                         html;       // template, zero terminated
+  size_t                              htmlLen;
+  uint8_t                             count;      // 0 until the template was split
+  template_segment_t                  segments[TEMPLATE_MAX_SEGMENTS];
+  std::shared_ptr<rendered_values_t>  cached;     // shared with running responses
+} page_cache_t;
+
+typedef struct {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t uncacheable;   // templates with too many placeholders, served by send_P
+} render_cache_stats_t;
+
+  /**
+   * @brief Send a cached page, render the placeholder values first if the
+   *        config version changed since the last render
+   *
+   * @param request Request
+   * @param page    Page cache of the template
+   */
+  void sendCachedPage(AsyncWebServerRequest *request, page_cache_t* page);
+
+  /**
+   * @brief Get the hit and miss counters of all page caches
+   *
+   * @param stats Address of the struct to write to
+   */
+  void getRenderCacheStats(render_cache_stats_t* stats);
+}
+
+#endif /*** RENDER_CACHE_H ***/
@@ -0,0 +1,189 @@
+#include <Rtcm.h>
+
+/********************************************************************************
+*                             Frame pool
+* ******************************************************************************/
+
+static RTKBaseManager::rtcm_frame_t framePool[RTCM_POOL_FRAMES];
+
+uint32_t RTKBaseManager::crc24q(const uint8_t* data, size_t len) {
+  uint32_t crc = 0;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint32_t)data[i] << 16;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc <<= 1;
+      if (crc & 0x1000000) crc ^= 0x1864CFB;
+    }
+  }
+  return crc & 0xFFFFFF;
+}
+
+RTKBaseManager::rtcm_frame_t* RTKBaseManager::acquireFrame() {
+  // Lock free, a frame is taken by whoever moves its count from 0 to 1
+  for (uint8_t i = 0; i < RTCM_POOL_FRAMES; i++) {
+    uint8_t free = 0;
+    if (framePool[i].refs.compare_exchange_strong(free, 1)) return &framePool[i];
+  }
+  return nullptr;
+}
+
+void RTKBaseManager::retainFrame(rtcm_frame_t* frame) {
+  frame->refs++;
+}
+
+void RTKBaseManager::releaseFrame(rtcm_frame_t* frame) {
+  frame->refs--;
+}
+
+uint8_t RTKBaseManager::freeFrames() {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < RTCM_POOL_FRAMES; i++) {
+    if (framePool[i].refs.load() == 0) count++;
+  }
+  return count;
+}
+
+/********************************************************************************
+*                             Framer
+* ******************************************************************************/
+
+void RTKBaseManager::beginFramer(rtcm_framer_t* framer) {
+  if (framer->frame != nullptr) releaseFrame(framer->frame);
+  memset(framer, 0, sizeof(rtcm_framer_t));
+}
+
+size_t RTKBaseManager::feedFramer(rtcm_framer_t* framer, const uint8_t* data, size_t len, rtcm_frame_t** frame) {
+  *frame = nullptr;
+  size_t i = 0;
+  while (i < len) {
+    if (framer->pos == 0) {
+      // Hunt for the preamble
+      if (data[i++] != RTCM_PREAMBLE) {
+        framer->skipped++;
+        continue;
+      }
+      if (framer->frame == nullptr) framer->frame = acquireFrame();
+      if (framer->frame == nullptr) {
+        framer->poolEmpty++;
+        continue;
+      }
+      framer->frame->data[0] = RTCM_PREAMBLE;
+      framer->pos = 1;
+      continue;
+    }
+
+    uint8_t* buf = framer->frame->data;
+    if (framer->pos == 1 && (data[i] & 0xFC) != 0) {
+      // Reserved bits set, the preamble was part of some payload, hunt again from this byte
+      framer->skipped++;
+      framer->pos = 0;
+      continue;
+    }
+    if (framer->pos < RTCM_HEADER_LEN) {
+      buf[framer->pos++] = data[i++];
+      if (framer->pos < RTCM_HEADER_LEN) continue;
+      framer->need = RTCM_HEADER_LEN + (((buf[1] & 0x03) << 8) | buf[2]) + RTCM_CRC_LEN;
+      continue;
+    }
+
+    size_t n = framer->need - framer->pos;
+    if (n > len - i) n = len - i;
+    memcpy(buf + framer->pos, data + i, n);
+    framer->pos += n;
+    i += n;
+    if (framer->pos < framer->need) continue;
+
+    framer->pos = 0;
+    uint16_t crcAt = framer->need - RTCM_CRC_LEN;
+    uint32_t crc = ((uint32_t)buf[crcAt] << 16) | ((uint32_t)buf[crcAt + 1] << 8) | buf[crcAt + 2];
+    if (crc24q(buf, crcAt) != crc) {
+      framer->crcErrors++;
+      continue;
+    }
+    rtcm_frame_t* done = framer->frame;
+    done->len = framer->need;
+    done->type = (framer->need > RTCM_HEADER_LEN + RTCM_CRC_LEN + 1) ? ((buf[3] << 4) | (buf[4] >> 4)) : 0;
+    done->receivedMs = millis();
+    framer->frame = nullptr;
+    framer->frames++;
+    *frame = done;
+    break;
+  }
+  return i;
+}
+
+/********************************************************************************
+*                             In flight window
+* ******************************************************************************/
+
+void RTKBaseManager::beginWindow(rtcm_window_t* window) {
+  memset(window, 0, sizeof(rtcm_window_t));
+  portMUX_TYPE unlocked = portMUX_INITIALIZER_UNLOCKED;
+  window->mux = unlocked;
+}
+
+void RTKBaseManager::openWindow(rtcm_window_t* window, uint32_t headerLen) {
+  portENTER_CRITICAL(&window->mux);
+  window->open = true;
+  window->headerUnacked = headerLen;
+  portEXIT_CRITICAL(&window->mux);
+}
+
+void RTKBaseManager::closeWindow(rtcm_window_t* window) {
+  rtcm_frame_t* done[RTCM_IN_FLIGHT_LEN];
+  uint8_t nDone = 0;
+  portENTER_CRITICAL(&window->mux);
+  window->open = false;
+  window->headerUnacked = 0;
+  while (window->count > 0) {
+    done[nDone++] = window->frames[window->head];
+    window->head = (window->head + 1) % RTCM_IN_FLIGHT_LEN;
+    window->count--;
+  }
+  portEXIT_CRITICAL(&window->mux);
+  for (uint8_t i = 0; i < nDone; i++) releaseFrame(done[i]);
+}
+
+bool RTKBaseManager::pushWindow(rtcm_window_t* window, rtcm_frame_t* frame) {
+  portENTER_CRITICAL(&window->mux);
+  // A closed window refuses, a frame must never outlive its connection in here
+  bool room = window->open && window->count < RTCM_IN_FLIGHT_LEN;
+  if (room) {
+    uint8_t idx = (window->head + window->count) % RTCM_IN_FLIGHT_LEN;
+    window->frames[idx] = frame;
+    window->unacked[idx] = frame->len;
+    window->count++;
+  }
+  portEXIT_CRITICAL(&window->mux);
+  return room;
+}
+
+uint32_t RTKBaseManager::ackWindow(rtcm_window_t* window, size_t len) {
+  rtcm_frame_t* done[RTCM_IN_FLIGHT_LEN];
+  uint8_t nDone = 0;
+  portENTER_CRITICAL(&window->mux);
+  size_t header = (len < window->headerUnacked) ? len : window->headerUnacked;
+  window->headerUnacked -= header;
+  len -= header;
+  uint32_t acked = len;
+  while (len > 0 && window->count > 0) {
+    uint8_t idx = window->head;
+    if (window->unacked[idx] > len) {
+      window->unacked[idx] -= len;
+      break;
+    }
+    len -= window->unacked[idx];
+    done[nDone++] = window->frames[idx];
+    window->head = (window->head + 1) % RTCM_IN_FLIGHT_LEN;
+    window->count--;
+  }
+  portEXIT_CRITICAL(&window->mux);
+
+  // TCP is done with the pool memory of these frames
+  for (uint8_t i = 0; i < nDone; i++) releaseFrame(done[i]);
+  return acked;
+}
+
+uint8_t RTKBaseManager::windowCount(const rtcm_window_t* window) {
+  return window->count;
+}
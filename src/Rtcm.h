@@ -0,0 +1,166 @@
+/**
+ * @file    Rtcm.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   RTCM 3 framing and a fixed pool of reference counted frames. The
+ *          framer cuts the receiver stream into CRC24Q checked frames and
+ *          writes them straight into a pool frame. Every consumer of a frame
+ *          holds a reference, the frame returns to the pool with the last
+ *          release, so one copy of a frame serves any number of casters.
+ *
+ *          0xD3 | 6 bit reserved, 10 bit length | payload | CRC24Q
+ */
+
+#ifndef RTCM_H
+#define RTCM_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <ManagerConfig.h>
+
+namespace RTKBaseManager {
+  const uint8_t  RTCM_PREAMBLE = 0xD3;
+  const uint8_t  RTCM_HEADER_LEN = 3;
+  const uint8_t  RTCM_CRC_LEN = 3;
+  const uint16_t RTCM_MAX_PAYLOAD_LEN = 1023;
+  const uint16_t RTCM_FRAME_MAX_LEN = RTCM_HEADER_LEN + RTCM_MAX_PAYLOAD_LEN + RTCM_CRC_LEN;
+
+typedef struct {
+  std::atomic<uint8_t> refs;        // 0 while in the pool
+  uint16_t             len;         // of the whole frame with header and CRC
+  uint16_t             type;        // message number, 0 for an empty payload
+  uint32_t             receivedMs;
+  uint8_t              data[RTCM_FRAME_MAX_LEN];
+} rtcm_frame_t;
+
+typedef struct {
+  rtcm_frame_t* frame;              // being filled, owned by the framer
+  uint16_t      pos;                // bytes of the frame so far
+  uint16_t      need;               // length of the frame, known after the header
+  uint32_t      frames;             // valid frames
+  uint32_t      crcErrors;
+  uint32_t      poolEmpty;          // frames lost because every pool frame was in use
+  uint32_t      skipped;            // bytes outside of frames
+} rtcm_framer_t;
+
+typedef struct {
+  portMUX_TYPE  mux;
+  bool          open;                           // between connect and disconnect
+  uint32_t      headerUnacked;                  // bytes sent before the frames, e.g. a reply
+  rtcm_frame_t* frames[RTCM_IN_FLIGHT_LEN];     // handed to TCP without a copy
+  uint16_t      unacked[RTCM_IN_FLIGHT_LEN];    // bytes of each not acknowledged yet
+  uint8_t       head;
+  uint8_t       count;
+} rtcm_window_t;
+
+  /**
+   * @brief CRC24Q of RTCM 3
+   *
+   * @param data      Data
+   * @param len       Length
+   * @return uint32_t CRC in the lower 24 bits
+   */
+  uint32_t crc24q(const uint8_t* data, size_t len);
+
+  /**
+   * @brief Take a free frame out of the pool, the caller holds one reference
+   *
+   * @return rtcm_frame_t* Frame or nullptr if the pool is empty
+   */
+  rtcm_frame_t* acquireFrame(void);
+
+  /**
+   * @brief Add a reference for another consumer
+   *
+   * @param frame Frame
+   */
+  void retainFrame(rtcm_frame_t* frame);
+
+  /**
+   * @brief Drop a reference, the frame goes back to the pool with the last one
+   *
+   * @param frame Frame
+   */
+  void releaseFrame(rtcm_frame_t* frame);
+
+  /**
+   * @brief Count the frames in the pool
+   *
+   * @return uint8_t Free frames of RTCM_POOL_FRAMES
+   */
+  uint8_t freeFrames(void);
+
+  /**
+   * @brief Reset a framer, a frame being filled goes back to the pool
+   *
+   * @param framer Framer
+   */
+  void beginFramer(rtcm_framer_t* framer);
+
+  /**
+   * @brief Feed receiver bytes, stops after the first complete frame
+   *
+   * @param framer  Framer
+   * @param data    Received bytes
+   * @param len     Number of bytes
+   * @param frame   Address to write a complete frame to, the caller owns
+   *                its reference, nullptr if none was completed
+   * @return size_t Bytes consumed, feed the rest again
+   */
+  size_t feedFramer(rtcm_framer_t* framer, const uint8_t* data, size_t len, rtcm_frame_t** frame);
+
+  /*** In flight window: frames sent on a connection, released when acknowledged ***/
+
+  /**
+   * @brief Init a closed window, call once
+   *
+   * @param window Window
+   */
+  void beginWindow(rtcm_window_t* window);
+
+  /**
+   * @brief Open a window for a new connection, from its connect callback
+   *
+   * @param window        Window
+   * @param headerLen     Bytes sent before the first frame, acknowledged first
+   */
+  void openWindow(rtcm_window_t* window, uint32_t headerLen);
+
+  /**
+   * @brief Close a window and release its frames, from the disconnect callback
+   *
+   * @param window Window
+   */
+  void closeWindow(rtcm_window_t* window);
+
+  /**
+   * @brief Put a frame into the window before it is handed to TCP, takes
+   *        over a reference
+   *
+   * @param window  Window
+   * @param frame   Frame
+   * @return true   If the frame is in the window
+   * @return false  If the window is closed or full, the reference stays with the caller
+   */
+  bool pushWindow(rtcm_window_t* window, rtcm_frame_t* frame);
+
+  /**
+   * @brief Release the frames covered by acknowledged bytes, from the ack callback
+   *
+   * @param window    Window
+   * @param len       Acknowledged bytes
+   * @return uint32_t Acknowledged bytes of frames, without the header
+   */
+  uint32_t ackWindow(rtcm_window_t* window, size_t len);
+
+  /**
+   * @brief Count the frames in the window
+   *
+   * @param window    Window
+   * @return uint8_t  Frames sent, not acknowledged
+   */
+  uint8_t windowCount(const rtcm_window_t* window);
+}
+
+#endif /*** RTCM_H ***/
@@ -0,0 +1,133 @@
+#include <RtcmScheduler.h>
+
+/********************************************************************************
+*                             Rules
+* ******************************************************************************/
+
+using RTKBaseManager::rate_rule_t;
+using RTKBaseManager::rate_schedule_t;
+
+// Reads len bits from bit pos, MSB first like RTCM
+static uint32_t getBits(const uint8_t* data, uint16_t pos, uint8_t len) {
+  uint32_t bits = 0;
+  for (uint8_t i = 0; i < len; i++, pos++) bits = (bits << 1) | ((data[pos / 8] >> (7 - pos % 8)) & 1);
+  return bits;
+}
+
+uint8_t RTKBaseManager::msmLevel(uint16_t type) {
+  // GPS 107x, GLONASS 108x, Galileo 109x, SBAS 110x, QZSS 111x, BeiDou 112x, NavIC 113x
+  if (type < 1071 || type > 1137) return 0;
+  uint8_t level = type % 10;
+  return (level >= 1 && level <= 7) ? level : 0;
+}
+
+uint8_t RTKBaseManager::msmSatellites(const rtcm_frame_t* frame) {
+  // Behind the 73 bits of the MSM header up to the smoothing interval: 64 bit satellite mask
+  if (msmLevel(frame->type) == 0 || frame->len < RTCM_HEADER_LEN + 18 + RTCM_CRC_LEN) return 0;
+  const uint8_t* payload = frame->data + RTCM_HEADER_LEN;
+  uint8_t satellites = 0;
+  for (uint16_t pos = 73; pos < 73 + 64; pos++) satellites += (payload[pos / 8] >> (7 - pos % 8)) & 1;
+  return satellites;
+}
+
+// Parses one <type>:<interval s> and moves p behind it
+static bool parseRule(const char** p, rate_rule_t* rule) {
+  const char* c = *p;
+  char* end;
+  if (strncmp(c, "msm", 3) == 0) {
+    c += 3;
+    rule->type = (*c >= '1' && *c <= '7') ? *c++ - '0' : RTKBaseManager::RATE_TYPE_MSM;
+  } else {
+    if (!isdigit(*c)) return false;
+    long type = strtol(c, &end, 10);
+    if (type < 1001 || type > 4095) return false;
+    rule->type = type;
+    c = end;
+  }
+  if (*c++ != ':' || !isdigit(*c)) return false;
+  unsigned long seconds = strtoul(c, &end, 10);
+  if (seconds > 3600) return false;
+  rule->intervalMs = seconds * 1000;
+  *p = end;
+  return true;
+}
+
+bool RTKBaseManager::parseRates(rate_schedule_t* schedule, const char* spec) {
+  memset(schedule, 0, sizeof(rate_schedule_t));
+  if (strcmp(spec, RTCM_RATES_ALL) == 0) return true;
+
+  const char* p = spec;
+  while (schedule->count < RATE_MAX_RULES && parseRule(&p, &schedule->rules[schedule->count])) {
+    schedule->count++;
+    if (*p == '\0') return true;
+    if (*p++ != ',') break;
+  }
+  memset(schedule, 0, sizeof(rate_schedule_t));
+  return false;
+}
+
+// Exact message number before the MSM level before all MSM
+static rate_rule_t* findRule(rate_schedule_t* schedule, uint16_t type, uint8_t level) {
+  rate_rule_t* found = nullptr;
+  for (uint8_t i = 0; i < schedule->count; i++) {
+    rate_rule_t* rule = &schedule->rules[i];
+    if (rule->type == type) return rule;
+    if (level != 0 && rule->type == level) found = rule;
+    if (level != 0 && rule->type == RTKBaseManager::RATE_TYPE_MSM && found == nullptr) found = rule;
+  }
+  return found;
+}
+
+static bool due(rate_rule_t* rule, uint32_t nowMs, uint32_t slackMs) {
+  if (rule->intervalMs == 0) return false;
+  // A wrapped epoch time (new GPS week or GLONASS day) is due as well
+  if (rule->seen && nowMs - rule->lastMs + slackMs < rule->intervalMs) return false;
+  rule->seen = true;
+  rule->lastMs = nowMs;
+  return true;
+}
+
+/********************************************************************************
+*                             Scheduling
+* ******************************************************************************/
+
+bool RTKBaseManager::scheduleFrame(rate_schedule_t* schedule, const rtcm_frame_t* frame) {
+  uint8_t level = msmLevel(frame->type);
+  rate_rule_t* rule = findRule(schedule, frame->type, level);
+  bool pass = true;
+
+  // MSM header: type 12, station 12, epoch time 30, multiple message 1 bit
+  if (level != 0 && frame->len >= RTCM_HEADER_LEN + 7 + RTCM_CRC_LEN) {
+    const uint8_t* payload = frame->data + RTCM_HEADER_LEN;
+    bool glonass = frame->type / 10 == 108;
+    // GLONASS: 3 bit day of week and the ms of the day
+    uint32_t epochMs = glonass ? getBits(payload, 27, 27) : getBits(payload, 24, 30);
+    bool more = getBits(payload, 54, 1) == 1;
+
+    // A lost last message leaves the epoch open, a new time of the same constellation closes it
+    bool sameSystem = schedule->epochSystem == frame->type / 10;
+    if (!schedule->epochOpen || (sameSystem && schedule->epochMs != epochMs)) {
+      // First message of the epoch, the MSM rules decide for all constellations at once
+      for (uint8_t i = 0; i < schedule->count; i++) {
+        rate_rule_t* r = &schedule->rules[i];
+        if (r->type <= 7 || msmLevel(r->type) != 0) r->epochPass = due(r, epochMs, 0);
+      }
+      schedule->epochSystem = frame->type / 10;
+      schedule->epochMs = epochMs;
+    }
+    schedule->epochOpen = more;
+    if (rule != nullptr) pass = rule->epochPass;
+  } else if (rule != nullptr) {
+    pass = due(rule, frame->receivedMs, RATE_SLACK_MS);
+  }
+
+  if (pass) {
+    schedule->bytesPassed += frame->len;
+    if (rule != nullptr) rule->passed++;
+  } else {
+    schedule->bytesDropped += frame->len;
+    rule->dropped++;
+    rule->bytesDropped += frame->len;
+  }
+  return pass;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file    RtcmScheduler.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Passes or decimates the RTCM messages for the casters by type,
+ *          configured by rtcm_rates, a comma separated list of
+ *          <type>:<interval s>, e.g. "1005:10,1230:10,msm7:1,msm4:0".
+ *          <type> is a message number, msm1 .. msm7 for a MSM level of all
+ *          constellations or msm for all MSM. An interval of 0 drops the
+ *          type, types without a rule pass, "all" passes every message.
+ *
+ *          MSM are decided once per epoch, at its first message, so the
+ *          constellations of a passed epoch are always complete. The time is
+ *          taken from the epoch time of the messages, not from the serial
+ *          arrival, other types use the arrival with RATE_SLACK_MS tolerance.
+ */
+
+#ifndef RTCM_SCHEDULER_H
+#define RTCM_SCHEDULER_H
+
+#include <Arduino.h>
+#include <RTKBaseManager.h>
+#include <Rtcm.h>
+
+namespace RTKBaseManager {
+  const uint8_t  RATE_MAX_RULES = 8;
+  const uint16_t RATE_TYPE_MSM = 0;           // rule for every MSM level
+  const uint32_t RATE_SLACK_MS = 250;         // serial jitter of non MSM messages
+
+typedef struct {
+  uint16_t type;            // message number, 1 .. 7 for a MSM level or RATE_TYPE_MSM
+  uint32_t intervalMs;      // 0 drops
+  bool     seen;            // passed once, lastMs is valid
+  uint32_t lastMs;          // epoch time of MSM or arrival of the last passed message
+  bool     epochPass;       // decision of the current MSM epoch
+  uint32_t passed;
+  uint32_t dropped;
+  uint32_t bytesDropped;
+} rate_rule_t;
+
+typedef struct {
+  rate_rule_t rules[RATE_MAX_RULES];
+  uint8_t     count;
+  bool        epochOpen;    // a MSM with the multiple message bit set was seen
+  uint16_t    epochSystem;  // constellation (type / 10) and epoch time of the open epoch
+  uint32_t    epochMs;
+  uint32_t    bytesPassed;
+  uint32_t    bytesDropped;
+} rate_schedule_t;
+
+  /**
+   * @brief Parse a rtcm_rates value into a schedule, resets the counters
+   *
+   * @param schedule  Schedule to write to
+   * @param spec      Value, "all" or a list of <type>:<interval s>
+   * @return true     If the value is valid
+   * @return false    If not, the schedule passes everything then
+   */
+  bool parseRates(rate_schedule_t* schedule, const char* spec);
+
+  /**
+   * @brief Decide whether a frame goes to the casters
+   *
+   * @param schedule  Schedule
+   * @param frame     Complete frame
+   * @return true     Pass
+   * @return false    Decimated
+   */
+  bool scheduleFrame(rate_schedule_t* schedule, const rtcm_frame_t* frame);
+
+  /**
+   * @brief Check if a message number is a MSM
+   *
+   * @param type      Message number
+   * @return uint8_t  MSM level 1 .. 7 or 0 if not a MSM
+   */
+  uint8_t msmLevel(uint16_t type);
+
+  /**
+   * @brief Count the satellites of a MSM, the bits of its satellite mask
+   *
+   * @param frame     Complete frame
+   * @return uint8_t  Satellites, 0 if not a MSM
+   */
+  uint8_t msmSatellites(const rtcm_frame_t* frame);
+}
+
+#endif /*** RTCM_SCHEDULER_H ***/
@@ -0,0 +1,70 @@
+/**
+ * @file    Seqlock.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Seqlock around a plain struct: writers are serialized by a short
+ *          critical section, readers never block and never see a torn copy.
+ *          The sequence is odd while a writer copies, readers retry until they
+ *          saw the same even sequence before and after their copy.
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <Arduino.h>
+#include <atomic>
+
+template <typename T> class Seqlock {
+public:
+  /**
+   * @brief Replace the value
+   *
+   * @param next    New value
+   * @param version Set to the number of writes including this one before the
+   *                copy, may point into next, nullptr if not needed
+   */
+  void write(const T* next, uint32_t* version) {
+    // Critical section: a reader of higher priority on the same core must
+    // never preempt a half done copy, it would spin forever
+    portENTER_CRITICAL(&writerMux);
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    if (version != nullptr) *version = seq / 2 + 1;
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&value, next, sizeof(T));
+    sequence.store(seq + 2, std::memory_order_release);
+    portEXIT_CRITICAL(&writerMux);
+  }
+
+  /**
+   * @brief Get a consistent copy of the value, lock free
+   *
+   * @param copy Address to copy to
+   */
+  void read(T* copy) const {
+    uint32_t begin, end;
+    do {
+      begin = sequence.load(std::memory_order_acquire);
+      memcpy(copy, &value, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      end = sequence.load(std::memory_order_relaxed);
+    } while ((begin & 1) || begin != end);
+  }
+
+  /**
+   * @brief Get the number of writes so far
+   *
+   * @return uint32_t Writes
+   */
+  uint32_t writes() const {
+    return sequence.load(std::memory_order_acquire) / 2;
+  }
+
+private:
+  T                     value;
+  std::atomic<uint32_t> sequence{0};
+  portMUX_TYPE          writerMux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif /*** SEQLOCK_H ***/
@@ -0,0 +1,657 @@
+#include <Simulation.h>
+#include <AsyncTCP.h>
+#include <CasterFanout.h>
+#include <FormParser.h>
+#include <Recorder.h>
+#include <RtcmScheduler.h>
+#include <TaskRuntime.h>
+#include <freertos/stream_buffer.h>
+
+using RTKBaseManager::rtcm_frame_t;
+using RTKBaseManager::sim_event_t;
+using RTKBaseManager::sim_timeline_t;
+
+/********************************************************************************
+*                             Timeline
+* ******************************************************************************/
+
+static bool parseCaster(const char* arg, uint8_t* caster) {
+  if (!isdigit(arg[0]) || arg[1] != '\0' || arg[0] - '0' >= RTKBaseManager::CASTER_MAX_TARGETS) return false;
+  *caster = arg[0] - '0';
+  return true;
+}
+
+static bool parseEvent(const char* line, size_t len, sim_event_t* event) {
+  using namespace RTKBaseManager;
+  char buf[SIM_FORM_MAX_LEN + 32];
+  if (len >= sizeof(buf) || !isdigit(line[0])) return false;
+  memcpy(buf, line, len);
+  buf[len] = '\0';
+
+  char* p;
+  event->atMs = strtoul(buf, &p, 10);
+  if (*p++ != ' ') return false;
+  char* arg = strchr(p, ' ');
+  if (arg != nullptr) *arg++ = '\0';
+
+  if (strcmp(p, "post") == 0) {
+    event->action = SIM_POST;
+    if (arg == nullptr || arg[0] == '\0' || strlen(arg) > SIM_FORM_MAX_LEN) return false;
+    strcpy(event->form, arg);
+    return true;
+  }
+  if (strcmp(p, "end") == 0) {
+    event->action = SIM_END;
+    return arg == nullptr;
+  }
+  if (strcmp(p, "drop") == 0) event->action = SIM_DROP;
+  else if (strcmp(p, "stall") == 0) event->action = SIM_STALL;
+  else if (strcmp(p, "resume") == 0) event->action = SIM_RESUME;
+  else return false;
+  return arg != nullptr && parseCaster(arg, &event->caster);
+}
+
+bool RTKBaseManager::parseTimeline(sim_timeline_t* timeline, const char* script) {
+  memset(timeline, 0, sizeof(sim_timeline_t));
+  bool ended = false;
+  const char* p = script;
+  while (*p != '\0') {
+    const char* lineEnd = strchr(p, '\n');
+    size_t len = (lineEnd != nullptr) ? lineEnd - p : strlen(p);
+    if (len > 0) {
+      sim_event_t* event = &timeline->events[timeline->count];
+      if (ended || timeline->count >= SIM_MAX_EVENTS || !parseEvent(p, len, event) ||
+          (timeline->count > 0 && event->atMs < timeline->events[timeline->count - 1].atMs)) {
+        memset(timeline, 0, sizeof(sim_timeline_t));
+        return false;
+      }
+      ended = event->action == SIM_END;
+      timeline->count++;
+    }
+    p += len;
+    if (*p == '\n') p++;
+  }
+  if (!ended) memset(timeline, 0, sizeof(sim_timeline_t));
+  return ended;
+}
+
+/********************************************************************************
+*                             Trace
+* ******************************************************************************/
+
+typedef struct {
+  uint32_t timeMs;          // release, trace time
+  uint16_t len;
+  uint8_t  data[RTKBaseManager::RTCM_FRAME_MAX_LEN];
+} trace_frame_t;
+
+// MSM7 of GPS, GLONASS, Galileo and BeiDou, 1005 and 1230 before every tenth epoch
+static const uint16_t EPOCH_TYPES[] = { 1005, 1230, 1077, 1087, 1097, 1127 };
+static const uint8_t EPOCH_STATION_TYPES = 2;
+static const uint8_t EPOCH_TYPE_COUNT = sizeof(EPOCH_TYPES) / sizeof(EPOCH_TYPES[0]);
+static const uint32_t OUTPUT_DELAY_MS = 20;         // receiver, from the epoch to the first byte
+
+static uint32_t seed = SIM_SEED;
+static uint32_t epochMs = 0;
+static uint8_t epochStep = 0;
+static uint32_t serialMs = 0;                       // the port is busy until then
+
+static bool fromRecording = false;
+static RTKBaseManager::recording_reader_t reader;
+static bool lapStart = true;
+static uint32_t lapBaseMs = 0;
+static uint32_t lapOffsetMs = 0;
+static uint32_t lastRecordMs = 0;
+
+static uint32_t nextRandom() {
+  // xorshift32, the same seed gives the same trace
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+static void putBits(uint8_t* data, uint16_t pos, uint8_t len, uint32_t value) {
+  for (uint8_t i = 0; i < len; i++, pos++) {
+    uint8_t mask = 0x80 >> (pos % 8);
+    if ((value >> (len - 1 - i)) & 1) data[pos / 8] |= mask;
+    else data[pos / 8] &= ~mask;
+  }
+}
+
+static void buildFrame(trace_frame_t* f, uint16_t type, uint16_t payloadLen, bool more) {
+  using namespace RTKBaseManager;
+  uint8_t* payload = f->data + RTCM_HEADER_LEN;
+  for (uint16_t i = 0; i < payloadLen; i++) payload[i] = nextRandom();
+  putBits(payload, 0, 12, type);
+  putBits(payload, 12, 12, 0);
+  if (msmLevel(type) != 0) {
+    // GLONASS: day of week and the ms of the day, the others the ms of the week
+    if (type / 10 == 108) {
+      putBits(payload, 24, 3, 0);
+      putBits(payload, 27, 27, epochMs % 86400000);
+    } else {
+      putBits(payload, 24, 30, epochMs % 604800000);
+    }
+    putBits(payload, 54, 1, more ? 1 : 0);
+  }
+  f->data[0] = RTCM_PREAMBLE;
+  f->data[1] = payloadLen >> 8;
+  f->data[2] = payloadLen & 0xFF;
+  uint32_t crc = crc24q(f->data, RTCM_HEADER_LEN + payloadLen);
+  f->data[RTCM_HEADER_LEN + payloadLen] = crc >> 16;
+  f->data[RTCM_HEADER_LEN + payloadLen + 1] = crc >> 8;
+  f->data[RTCM_HEADER_LEN + payloadLen + 2] = crc;
+  f->len = RTCM_HEADER_LEN + payloadLen + RTCM_CRC_LEN;
+}
+
+static bool nextSynthetic(trace_frame_t* f) {
+  if (epochStep == EPOCH_TYPE_COUNT) {
+    epochStep = 0;
+    epochMs += 1000;
+  }
+  if (epochStep == 0 && epochMs % 10000 != 0) epochStep = EPOCH_STATION_TYPES;
+
+  uint16_t type = EPOCH_TYPES[epochStep++];
+  uint16_t payloadLen = (type == 1005) ? 19 : (type == 1230) ? 8 : 250 + nextRandom() % 300;
+  buildFrame(f, type, payloadLen, epochStep < EPOCH_TYPE_COUNT);
+
+  // Released when the last byte is in, at the serial pace
+  uint32_t start = (serialMs > epochMs + OUTPUT_DELAY_MS) ? serialMs : epochMs + OUTPUT_DELAY_MS;
+  f->timeMs = start + (uint32_t)f->len * 10 * 1000 / GNSS_BAUD;
+  serialMs = f->timeMs;
+  return true;
+}
+
+// The recording in a loop, a reboot of the base or a new lap continues one second later
+static bool nextRecorded(trace_frame_t* f) {
+  record_header_t header;
+  for (uint8_t laps = 0; laps < 2; ) {
+    if (!RTKBaseManager::readRecord(&reader, &header, f->data, sizeof(f->data))) {
+      RTKBaseManager::beginRecordingRead(&reader, false, 0, 0);
+      lapStart = true;
+      laps++;
+      continue;
+    }
+    if (header.kind != RECORD_KIND_RTCM) continue;
+    if (lapStart || header.timeMs < lastRecordMs) {
+      lapOffsetMs = lapStart && lastRecordMs == 0 ? 0 : serialMs + 1000;
+      lapBaseMs = header.timeMs;
+      lapStart = false;
+    }
+    lastRecordMs = header.timeMs;
+    f->timeMs = lapOffsetMs + (header.timeMs - lapBaseMs);
+    f->len = header.len;
+    serialMs = f->timeMs;
+    return true;
+  }
+  return false;
+}
+
+static bool nextTraceFrame(trace_frame_t* f) {
+  return fromRecording ? nextRecorded(f) : nextSynthetic(f);
+}
+
+/********************************************************************************
+*                             Virtual receiver
+* ******************************************************************************/
+
+class SimulatedReceiver : public Stream {
+ public:
+  StreamBufferHandle_t port = nullptr;
+
+  int available() override {
+    return (port != nullptr) ? xStreamBufferBytesAvailable(port) + (peeked >= 0 ? 1 : 0) : 0;
+  }
+
+  int read() override {
+    if (peeked >= 0) {
+      int c = peeked;
+      peeked = -1;
+      return c;
+    }
+    uint8_t c;
+    return (port != nullptr && xStreamBufferReceive(port, &c, 1, 0) == 1) ? c : -1;
+  }
+
+  int peek() override {
+    if (peeked < 0) peeked = read();
+    return peeked;
+  }
+
+  using Stream::readBytes;
+  size_t readBytes(char* buffer, size_t length) {
+    size_t n = 0;
+    if (length > 0 && peeked >= 0) buffer[n++] = read();
+    if (port != nullptr) n += xStreamBufferReceive(port, buffer + n, length - n, 0);
+    return n;
+  }
+
+  // Commands to the receiver are dropped
+  size_t write(uint8_t c) override {
+    return 1;
+  }
+
+ private:
+  int peeked = -1;
+};
+
+static SimulatedReceiver receiver;
+
+Stream* RTKBaseManager::simulatedReceiver() {
+  if (receiver.port == nullptr) receiver.port = xStreamBufferCreate(SIM_SERIAL_BUFFER_LEN, 1);
+  return &receiver;
+}
+
+/********************************************************************************
+*                             Frame tracking
+* ******************************************************************************/
+
+typedef enum {
+  TRACK_FREE,
+  TRACK_RELEASED,           // on the virtual port
+  TRACK_PASSED,             // published, passed the rate schedule
+  TRACK_DECIMATED           // published, not for the casters
+} track_state_t;
+
+typedef struct {
+  uint32_t      key;
+  uint32_t      releasedMs;   // real time
+  track_state_t state;
+  uint8_t       expected;     // bit per virtual caster streaming at the publication
+  uint8_t       arrived;
+} sim_track_t;
+
+typedef struct {
+  uint16_t      port;
+  uint32_t      connects;
+  uint32_t      frames;
+  uint32_t      bytes;
+  uint32_t      lost;         // passed and expected, never arrived
+  uint32_t      unmatched;    // arrived, not released or twice
+  uint32_t      maxMs;
+  uint32_t      histogram[RTKBaseManager::SIM_LATENCY_BUCKETS + 1];   // last one for everything above
+} sim_results_t;
+
+static sim_track_t tracks[RTKBaseManager::SIM_TRACK_LEN];
+static uint16_t trackHead = 0;                      // oldest entry, the next one to reuse
+static portMUX_TYPE trackMux = portMUX_INITIALIZER_UNLOCKED;
+static sim_results_t results[RTKBaseManager::CASTER_MAX_TARGETS];
+static uint8_t streaming = 0;                       // bit per virtual caster with an accepted SOURCE
+static uint32_t released = 0;
+static uint32_t releasedBytes = 0;
+static uint32_t overrunBytes = 0;                   // did not fit into the virtual port
+static uint32_t passed = 0;
+static uint32_t decimated = 0;
+
+static uint32_t frameKey(const uint8_t* data, uint16_t len) {
+  return (((uint32_t)len & 0xFF) << 24) | ((uint32_t)data[len - 3] << 16) | ((uint32_t)data[len - 2] << 8) | data[len - 1];
+}
+
+// Under trackMux
+static void retireTrack(sim_track_t* t) {
+  if (t->state == TRACK_PASSED) {
+    for (uint8_t i = 0; i < RTKBaseManager::CASTER_MAX_TARGETS; i++) {
+      if ((t->expected & (1 << i)) && !(t->arrived & (1 << i))) results[i].lost++;
+    }
+  }
+  t->state = TRACK_FREE;
+}
+
+static void releaseTraceFrame(const trace_frame_t* f) {
+  portENTER_CRITICAL(&trackMux);
+  sim_track_t* t = &tracks[trackHead];
+  retireTrack(t);
+  t->key = frameKey(f->data, f->len);
+  t->releasedMs = millis();
+  t->state = TRACK_RELEASED;
+  t->expected = 0;
+  t->arrived = 0;
+  trackHead = (trackHead + 1) % RTKBaseManager::SIM_TRACK_LEN;
+  portEXIT_CRITICAL(&trackMux);
+
+  // A full port loses bytes like an UART overrun, the framer has to resync
+  size_t sent = xStreamBufferSend(receiver.port, f->data, f->len, 0);
+  overrunBytes += f->len - sent;
+  released++;
+  releasedBytes += f->len;
+}
+
+// Oldest first, the same frame can be in the trace twice
+static sim_track_t* findTrack(uint32_t key, track_state_t state, uint8_t notArrived) {
+  for (uint16_t n = 0; n < RTKBaseManager::SIM_TRACK_LEN; n++) {
+    sim_track_t* t = &tracks[(trackHead + n) % RTKBaseManager::SIM_TRACK_LEN];
+    if (t->state == state && t->key == key && !(t->arrived & notArrived)) return t;
+  }
+  return nullptr;
+}
+
+void RTKBaseManager::simFramePublished(const rtcm_frame_t* frame, bool uplink) {
+  portENTER_CRITICAL(&trackMux);
+  sim_track_t* t = findTrack(frameKey(frame->data, frame->len), TRACK_RELEASED, 0);
+  if (t != nullptr) {
+    t->state = uplink ? TRACK_PASSED : TRACK_DECIMATED;
+    t->expected = streaming;
+    uplink ? passed++ : decimated++;
+  }
+  portEXIT_CRITICAL(&trackMux);
+}
+
+static void frameArrived(uint8_t caster, const uint8_t* data, uint16_t len) {
+  sim_results_t* r = &results[caster];
+  r->frames++;
+  r->bytes += len;
+  portENTER_CRITICAL(&trackMux);
+  sim_track_t* t = findTrack(frameKey(data, len), TRACK_PASSED, 1 << caster);
+  if (t != nullptr) {
+    t->arrived |= 1 << caster;
+    uint32_t ms = millis() - t->releasedMs;
+    uint16_t bucket = ms / RTKBaseManager::SIM_BUCKET_MS;
+    r->histogram[(bucket < RTKBaseManager::SIM_LATENCY_BUCKETS) ? bucket : RTKBaseManager::SIM_LATENCY_BUCKETS]++;
+    if (ms > r->maxMs) r->maxMs = ms;
+  } else {
+    r->unmatched++;
+  }
+  portEXIT_CRITICAL(&trackMux);
+}
+
+/********************************************************************************
+*                             Virtual casters, run on async_tcp
+* ******************************************************************************/
+
+static const char ICY_OK[] PROGMEM = "ICY 200 OK\r\n\r\n";
+static const char ERROR_TAKEN[] PROGMEM = "ERROR - Mount Point Taken or Invalid\r\n";
+static const uint16_t SIM_REQUEST_MAX_LEN = 256;
+
+typedef struct {
+  uint8_t       index;
+  AsyncServer*  server;
+  AsyncClient*  client;                               // SOURCE connection of the base
+  volatile bool stall;
+  volatile bool dropRequested;
+  volatile bool resumeRequested;
+  size_t        unacked;                              // held back while stalled
+  char          request[SIM_REQUEST_MAX_LEN + 1];
+  uint16_t      requestLen;
+  uint8_t       frame[RTKBaseManager::RTCM_FRAME_MAX_LEN];
+  uint16_t      framePos;
+} sim_caster_t;
+
+static sim_caster_t casters[RTKBaseManager::CASTER_MAX_TARGETS];
+static QueueHandle_t closedClients = nullptr;       // deleted by the simulation task
+
+static void onClosed(void* arg, AsyncClient* client) {
+  sim_caster_t* c = (sim_caster_t*)arg;
+  if (c != nullptr && c->client == client) {
+    c->client = nullptr;
+    streaming &= ~(1 << c->index);
+  }
+  // Never deleted here, close() calls back before it returns
+  if (xQueueSend(closedClients, &client, 0) != pdTRUE) DEBUG_SERIAL.println(F("Simulation leaks a client"));
+}
+
+// Cuts the stream into frames, the base only sends whole and checked ones
+static void takeFrames(sim_caster_t* c, const uint8_t* data, size_t len) {
+  using namespace RTKBaseManager;
+  for (size_t i = 0; i < len; i++) {
+    if (c->framePos == 0 && data[i] != RTCM_PREAMBLE) continue;
+    c->frame[c->framePos++] = data[i];
+    if (c->framePos < RTCM_HEADER_LEN) continue;
+    uint16_t need = RTCM_HEADER_LEN + (((c->frame[1] & 0x03) << 8) | c->frame[2]) + RTCM_CRC_LEN;
+    if (c->framePos == need) {
+      frameArrived(c->index, c->frame, need);
+      c->framePos = 0;
+    }
+  }
+}
+
+static bool applyRequests(sim_caster_t* c, AsyncClient* client) {
+  if (c->dropRequested) {
+    c->dropRequested = false;
+    client->close();
+    return false;
+  }
+  if (c->resumeRequested) {
+    c->resumeRequested = false;
+    c->stall = false;
+    if (c->unacked > 0) client->ack(c->unacked);
+    c->unacked = 0;
+  }
+  return true;
+}
+
+static void onCasterData(void* arg, AsyncClient* client, void* data, size_t len) {
+  sim_caster_t* c = (sim_caster_t*)arg;
+  if (!applyRequests(c, client)) return;
+  if (c->stall) {
+    // Not acknowledged, the receive window closes and the base backs up
+    client->ackLater();
+    c->unacked += len;
+  }
+
+  const uint8_t* bytes = (const uint8_t*)data;
+  if (!(streaming & (1 << c->index))) {
+    size_t room = SIM_REQUEST_MAX_LEN - c->requestLen;
+    size_t take = (len < room) ? len : room;
+    memcpy(c->request + c->requestLen, bytes, take);
+    c->requestLen += take;
+    c->request[c->requestLen] = '\0';
+    char* end = strstr(c->request, "\r\n\r\n");
+    if (end == nullptr) {
+      if (c->requestLen == SIM_REQUEST_MAX_LEN) client->close();
+      return;
+    }
+    if (strncmp(c->request, "SOURCE ", 7) != 0) {
+      client->write(ERROR_TAKEN);
+      client->close();
+      return;
+    }
+    client->write(ICY_OK);
+    streaming |= 1 << c->index;
+    results[c->index].connects++;
+    size_t used = (end + 4 - c->request) - (c->requestLen - take);
+    bytes += used;
+    len -= used;
+  }
+  takeFrames(c, bytes, len);
+}
+
+static void onCasterPoll(void* arg, AsyncClient* client) {
+  applyRequests((sim_caster_t*)arg, client);
+}
+
+static void onCasterClient(void* arg, AsyncClient* client) {
+  sim_caster_t* c = (sim_caster_t*)arg;
+  if (c->client != nullptr) {
+    // One source per mount point, like a real caster
+    client->onDisconnect(onClosed, nullptr);
+    client->write(ERROR_TAKEN);
+    client->close();
+    return;
+  }
+  c->client = client;
+  c->requestLen = 0;
+  c->framePos = 0;
+  c->unacked = 0;
+  client->onData(onCasterData, c);
+  client->onPoll(onCasterPoll, c);
+  client->onDisconnect(onClosed, c);
+}
+
+/********************************************************************************
+*                             Config posts
+* ******************************************************************************/
+
+typedef struct {
+  volatile bool busy;
+  int           status;     // of the reply, 0 before the status line
+  uint32_t      startMs;
+  char          request[RTKBaseManager::SIM_FORM_MAX_LEN + 192];
+  uint32_t      sent;
+  uint32_t      ok;
+  uint32_t      failed;
+  uint32_t      maxMs;
+} sim_post_t;
+
+static sim_post_t post;
+
+static void onPostConnect(void* arg, AsyncClient* client) {
+  client->write(post.request);
+}
+
+static void onPostData(void* arg, AsyncClient* client, void* data, size_t len) {
+  if (post.status == 0 && len > 12 && strncmp((const char*)data, "HTTP/1.", 7) == 0) post.status = atoi((const char*)data + 9);
+}
+
+static void onPostClosed(void* arg, AsyncClient* client) {
+  uint32_t ms = millis() - post.startMs;
+  if (ms > post.maxMs) post.maxMs = ms;
+  (post.status == 200) ? post.ok++ : post.failed++;
+  post.busy = false;
+  onClosed(nullptr, client);
+}
+
+// Through the web server of the base like the config page, the real handler and store
+static bool startPost(const char* form) {
+  if (post.busy) return false;
+  snprintf(post.request, sizeof(post.request),
+           "POST /actionUpdateData HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: %s\r\n"
+           "Content-Length: %u\r\nConnection: close\r\n\r\n%s",
+           RTKBaseManager::FORM_CONTENT_TYPE, (unsigned int)strlen(form), form);
+  post.busy = true;
+  post.status = 0;
+  post.startMs = millis();
+  post.sent++;
+
+  AsyncClient* client = new AsyncClient();
+  client->onConnect(onPostConnect, nullptr);
+  client->onData(onPostData, nullptr);
+  client->onDisconnect(onPostClosed, nullptr);
+  if (!client->connect(IPAddress(127, 0, 0, 1), 80)) {
+    delete client;
+    post.failed++;
+    post.busy = false;
+  }
+  return true;
+}
+
+/********************************************************************************
+*                             Simulation task
+* ******************************************************************************/
+
+static sim_timeline_t timeline;
+
+// False if the event has to wait, a post for the one before
+static bool runEvent(const sim_event_t* event) {
+  sim_caster_t* c = &casters[event->caster];
+  switch (event->action) {
+    case RTKBaseManager::SIM_POST:   return startPost(event->form);
+    case RTKBaseManager::SIM_DROP:   c->dropRequested = true; break;
+    case RTKBaseManager::SIM_STALL:  c->stall = true; break;
+    case RTKBaseManager::SIM_RESUME: c->resumeRequested = true; break;
+    default:                         break;
+  }
+  return true;
+}
+
+static uint32_t percentile(const sim_results_t* r, uint32_t count, uint8_t p) {
+  if (count == 0) return 0;
+  uint32_t rank = (count * p + 99) / 100;
+  uint32_t seen = 0;
+  for (uint16_t b = 0; b <= RTKBaseManager::SIM_LATENCY_BUCKETS; b++) {
+    seen += r->histogram[b];
+    if (seen >= rank) return (b < RTKBaseManager::SIM_LATENCY_BUCKETS) ? (b + 1) * RTKBaseManager::SIM_BUCKET_MS : r->maxMs;
+  }
+  return r->maxMs;
+}
+
+static void printReport(uint32_t traceMs, uint32_t realMs) {
+  DEBUG_SERIAL.printf("{\"speed\":%u,\"seed\":%u,\"trace\":\"%s\",\"trace_ms\":%u,\"real_ms\":%u,"
+                      "\"released\":%u,\"bytes\":%u,\"overrun_bytes\":%u,\"passed\":%u,\"decimated\":%u,"
+                      "\"posts\":{\"sent\":%u,\"ok\":%u,\"failed\":%u,\"max_ms\":%u},\"casters\":[",
+                      SIM_SPEED, SIM_SEED, fromRecording ? "recording" : "synthetic", traceMs, realMs,
+                      released, releasedBytes, overrunBytes, passed, decimated,
+                      post.sent, post.ok, post.failed, post.maxMs);
+  for (uint8_t i = 0; i < RTKBaseManager::CASTER_MAX_TARGETS; i++) {
+    const sim_results_t* r = &results[i];
+    uint32_t matched = 0;
+    for (uint16_t b = 0; b <= RTKBaseManager::SIM_LATENCY_BUCKETS; b++) matched += r->histogram[b];
+    DEBUG_SERIAL.printf("%s{\"port\":%u,\"connects\":%u,\"frames\":%u,\"bytes\":%u,\"lost\":%u,\"unmatched\":%u,"
+                        "\"latency_ms\":{\"p50\":%u,\"p95\":%u,\"p99\":%u,\"max\":%u}}",
+                        (i == 0) ? "" : ",", r->port, r->connects, r->frames, r->bytes, r->lost, r->unmatched,
+                        percentile(r, matched, 50), percentile(r, matched, 95), percentile(r, matched, 99), r->maxMs);
+  }
+  DEBUG_SERIAL.println("]}");
+}
+
+static void deleteClosedClients() {
+  AsyncClient* client;
+  while (xQueueReceive(closedClients, &client, 0) == pdTRUE) delete client;
+}
+
+static void simulationLoop(void* parameter) {
+  trace_frame_t* frame = (trace_frame_t*)malloc(sizeof(trace_frame_t));
+  bool pending = frame != nullptr && nextTraceFrame(frame);
+  uint8_t next = 0;
+  uint32_t startMs = millis();
+  uint32_t endMs = 0;                               // real time of the end event
+  uint32_t traceMs = 0;
+
+  while (true) {
+    deleteClosedClients();
+    uint32_t now = millis();
+    if (endMs == 0) {
+      traceMs = (now - startMs) * SIM_SPEED;
+      while (next < timeline.count && timeline.events[next].atMs <= traceMs && runEvent(&timeline.events[next])) {
+        if (timeline.events[next++].action == RTKBaseManager::SIM_END) endMs = now;
+      }
+      while (endMs == 0 && pending && frame->timeMs <= traceMs) {
+        releaseTraceFrame(frame);
+        pending = nextTraceFrame(frame);
+      }
+    } else if (now - endMs >= RTKBaseManager::SIM_DRAIN_MS) {
+      break;
+    }
+    vTaskDelay(1);
+  }
+
+  // Frames still followed are done, the ones which did not arrive are lost
+  portENTER_CRITICAL(&trackMux);
+  for (uint16_t i = 0; i < RTKBaseManager::SIM_TRACK_LEN; i++) retireTrack(&tracks[i]);
+  portEXIT_CRITICAL(&trackMux);
+  printReport(traceMs, millis() - startMs);
+  free(frame);
+  vTaskDelete(nullptr);
+}
+
+bool RTKBaseManager::startSimulation() {
+  if (!parseTimeline(&timeline, SIM_TIMELINE)) {
+    DEBUG_SERIAL.println(F("Invalid simulation timeline"));
+    return false;
+  }
+  closedClients = xQueueCreate(2 * CASTER_MAX_TARGETS + 2, sizeof(AsyncClient*));
+  if (simulatedReceiver() == nullptr || receiver.port == nullptr || closedClients == nullptr) return false;
+
+  // A recording of the base is the better trace, else the synthetic stream
+  record_header_t header;
+  uint8_t probe[RTCM_FRAME_MAX_LEN];
+  if (mountRecording()) {
+    beginRecordingRead(&reader, false, 0, 0);
+    while (!fromRecording && readRecord(&reader, &header, probe, sizeof(probe))) {
+      fromRecording = header.kind == RECORD_KIND_RTCM;
+    }
+    beginRecordingRead(&reader, false, 0, 0);
+  }
+
+  for (uint8_t i = 0; i < CASTER_MAX_TARGETS; i++) {
+    sim_caster_t* c = &casters[i];
+    c->index = i;
+    results[i].port = SIM_CASTER_PORT + i;
+    c->server = new AsyncServer(SIM_CASTER_PORT + i);
+    c->server->onClient(onCasterClient, c);
+    c->server->begin();
+  }
+  DEBUG_SERIAL.printf("Simulation: %s trace, %u events, %ux real time\r\n",
+                      fromRecording ? "recorded" : "synthetic", timeline.count, SIM_SPEED);
+  return spawnTask(TASK_ROLE_GNSS_INGEST, simulationLoop, "simulation", 4096, nullptr, nullptr);
+}
@@ -0,0 +1,112 @@
+/**
+ * @file    Simulation.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   End to end simulation of the correction pipeline on the device,
+ *          built with RTK_SIMULATION (env featheresp32_sim). The receiver is
+ *          replaced by a virtual serial port fed from a trace, the casters by
+ *          virtual NTRIP casters on the loopback interface. Everything between
+ *          them is the firmware as it runs in the field: framer, rate schedule,
+ *          caster fan-out, web server and config store.
+ *
+ *          The trace is the recording of the recorder partition, or without
+ *          one a synthetic base stream from SIM_SEED: MSM7 of four
+ *          constellations every second, 1005 and 1230 every ten seconds, at
+ *          the serial pace of GNSS_BAUD. A timeline of events in trace time
+ *          drops or stalls the virtual casters and posts config forms to
+ *          /actionUpdateData mid-stream. Trace time runs SIM_SPEED times faster
+ *          than real time, the same seed and timeline give the same input.
+ *
+ *          At the end the latency from the release of every frame on the
+ *          virtual port to its arrival at each virtual caster and the frames
+ *          which passed the rate schedule but never arrived are printed as
+ *          JSON on DEBUG_SERIAL.
+ */
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <Arduino.h>
+#include <RTKBaseManager.h>
+#include <Rtcm.h>
+
+namespace RTKBaseManager {
+  const uint8_t  SIM_MAX_EVENTS = 16;
+  const uint16_t SIM_FORM_MAX_LEN = 255;
+  const uint16_t SIM_CASTER_PORT = 2102;      // virtual caster i listens on SIM_CASTER_PORT + i
+  const uint16_t SIM_TRACK_LEN = 256;         // frames followed from the release to the arrival
+  const uint16_t SIM_LATENCY_BUCKETS = 256;
+  const uint8_t  SIM_BUCKET_MS = 4;
+  const uint32_t SIM_DRAIN_MS = 2000;         // real time for the last frames after the end
+  const uint16_t SIM_SERIAL_BUFFER_LEN = 4096; // virtual port, overruns like the UART when full
+
+  // Two casters, one loses its connection twice, the other stalls for ten seconds
+  constexpr char SIM_TIMELINE[] PROGMEM =
+    "0 post caster_host=127.0.0.1&caster_port=2102&mount_point=SIM0&mount_point_pw=sim"
+    "&caster_host_2=127.0.0.1&caster_port_2=2103&mount_point_2=SIM1&mount_point_pw_2=sim&rtcm_rates=all\n"
+    "30000 drop 0\n"
+    "60000 stall 1\n"
+    "70000 resume 1\n"
+    "90000 post rtcm_rates=msm7:1,1005:10,1230:10\n"
+    "100000 drop 0\n"
+    "120000 end\n";
+
+typedef enum {
+  SIM_POST,             // post the form to /actionUpdateData
+  SIM_DROP,             // the virtual caster closes the connection
+  SIM_STALL,            // the virtual caster stops acknowledging, TCP backs up
+  SIM_RESUME,           // acknowledges again
+  SIM_END
+} sim_action_t;
+
+typedef struct {
+  uint32_t     atMs;                          // trace time
+  sim_action_t action;
+  uint8_t      caster;                        // drop, stall, resume
+  char         form[SIM_FORM_MAX_LEN + 1];    // post: url encoded
+} sim_event_t;
+
+typedef struct {
+  sim_event_t events[SIM_MAX_EVENTS];
+  uint8_t     count;
+} sim_timeline_t;
+
+  /**
+   * @brief Parse a timeline, one event per line: <trace ms> <action> [<arg>]
+   *        with post <form>, drop <caster>, stall <caster>, resume <caster>
+   *        and end. Times must not go back, the last event must be end.
+   *
+   * @param timeline  Timeline to write to
+   * @param script    Text of the timeline
+   * @return true     If valid
+   * @return false    If not, the timeline is empty then
+   */
+  bool parseTimeline(sim_timeline_t* timeline, const char* script);
+
+  /**
+   * @brief Get the virtual serial port of the receiver, for startCasters()
+   *
+   * @return Stream* Port, fed once startSimulation() runs
+   */
+  Stream* simulatedReceiver(void);
+
+  /**
+   * @brief Start the virtual casters and run SIM_TIMELINE on its own task,
+   *        call after startCasters() and startServer()
+   *
+   * @return true   If running
+   * @return false  If the timeline is invalid or out of memory
+   */
+  bool startSimulation(void);
+
+  /**
+   * @brief Follow a frame through the fan-out, called by publishFrame()
+   *
+   * @param frame   Frame
+   * @param uplink  Passed the rate schedule
+   */
+  void simFramePublished(const rtcm_frame_t* frame, bool uplink);
+}
+
+#endif /*** SIMULATION_H ***/
@@ -0,0 +1,304 @@
+#include <StatusApi.h>
+#include <Assets.h>
+
+/********************************************************************************
+*                             Snapshots
+* ******************************************************************************/
+
+void RTKBaseManager::getStatus(status_snapshot_t* status) {
+  memset(status, 0, sizeof(status_snapshot_t));
+  status->configVersion = configVersion();
+  status->uptimeMs = millis();
+  status->freeHeap = ESP.getFreeHeap();
+  status->maxAllocHeap = ESP.getMaxAllocHeap();
+  getRenderCacheStats(&status->cache);
+  getAdmissionStats(&status->admission);
+  status->assetsMounted = assetsMounted();
+  status->allocTracking = allocTrackingEnabled();
+  getAllocStats(&status->alloc);
+
+  // Newest first, the calling request is still open and not included
+  request_alloc_t requests[REQUEST_HISTORY_LEN];
+  uint8_t nRequests = getRequestAllocs(requests);
+  for (uint8_t i = 0; i < nRequests; i++) {
+    if (requests[i].request != nullptr) continue;
+    memcpy(&status->requests[status->requestCount++], &requests[i], sizeof(request_alloc_t));
+  }
+}
+
+// Secrets are never sent, derived entries are not config
+static bool exported(const RTKBaseManager::param_entry_t& param) {
+  return param.codec != RTKBaseManager::CODEC_SECRET && param.check != RTKBaseManager::CHECK_NONE;
+}
+
+/********************************************************************************
+*                             CBOR
+* ******************************************************************************/
+
+static void encodeKeyUint(RTKBaseManager::cbor_writer_t* writer, const char* key, uint32_t value) {
+  RTKBaseManager::cborText(writer, key);
+  RTKBaseManager::cborUint(writer, value);
+}
+
+static void encodeKeyInt(RTKBaseManager::cbor_writer_t* writer, const char* key, int32_t value) {
+  RTKBaseManager::cborText(writer, key);
+  RTKBaseManager::cborInt(writer, value);
+}
+
+// Like appendJsonString: strict decoders reject a text string that is not
+// UTF-8, so bytes outside printable ASCII become '?'
+static void encodeAsciiText(RTKBaseManager::cbor_writer_t* writer, const char* text) {
+  char ascii[RTKBaseManager::CONFIG_VALUE_MAX_LEN + 1];
+  size_t len = 0;
+  for (; text[len] != '\0' && len < sizeof(ascii) - 1; len++) {
+    char c = text[len];
+    ascii[len] = (c < 0x20 || c > 0x7E) ? '?' : c;
+  }
+  ascii[len] = '\0';
+  RTKBaseManager::cborText(writer, ascii);
+}
+
+void RTKBaseManager::encodeStatus(cbor_writer_t* writer, const status_snapshot_t* status) {
+  cborMap(writer, 9);
+  encodeKeyUint(writer, "config_version", status->configVersion);
+  encodeKeyUint(writer, "uptime_ms", status->uptimeMs);
+  encodeKeyUint(writer, "free_heap", status->freeHeap);
+  encodeKeyUint(writer, "max_alloc_heap", status->maxAllocHeap);
+
+  cborText(writer, "render_cache");
+  cborMap(writer, 3);
+  encodeKeyUint(writer, "hits", status->cache.hits);
+  encodeKeyUint(writer, "misses", status->cache.misses);
+  encodeKeyUint(writer, "uncacheable", status->cache.uncacheable);
+
+  cborText(writer, "admission");
+  cborMap(writer, 5);
+  encodeKeyUint(writer, "admitted", status->admission.admitted);
+  encodeKeyUint(writer, "rejected_busy", status->admission.rejectedBusy);
+  encodeKeyUint(writer, "rejected_low_heap", status->admission.rejectedLowHeap);
+  encodeKeyUint(writer, "in_flight", status->admission.inFlight);
+  encodeKeyUint(writer, "peak_in_flight", status->admission.peakInFlight);
+
+  cborText(writer, "assets_mounted");
+  cborBool(writer, status->assetsMounted);
+
+  cborText(writer, "alloc");
+  cborMap(writer, 5);
+  cborText(writer, "tracking");
+  cborBool(writer, status->allocTracking);
+  encodeKeyUint(writer, "allocs", status->alloc.allocs);
+  encodeKeyUint(writer, "frees", status->alloc.frees);
+  encodeKeyUint(writer, "bytes", status->alloc.bytes);
+  encodeKeyUint(writer, "failed", status->alloc.failed);
+
+  cborText(writer, "requests");
+  cborArray(writer, status->requestCount);
+  for (uint8_t i = 0; i < status->requestCount; i++) {
+    const request_alloc_t& r = status->requests[i];
+    cborMap(writer, 5);
+    cborText(writer, "url");
+    encodeAsciiText(writer, r.url);
+    encodeKeyUint(writer, "allocs", r.allocs);
+    encodeKeyUint(writer, "frees", r.frees);
+    encodeKeyUint(writer, "bytes", r.bytes);
+    encodeKeyUint(writer, "handler_us", r.handlerUs);
+  }
+}
+
+void RTKBaseManager::encodeConfig(cbor_writer_t* writer, const config_snapshot_t* config) {
+  cborMap(writer, 3);
+  encodeKeyUint(writer, "config_version", config->version);
+
+  uint8_t nValues = 0;
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    if (exported(PARAM_TABLE[i])) nValues++;
+  }
+  cborText(writer, "values");
+  cborMap(writer, nValues);
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    if (!exported(PARAM_TABLE[i])) continue;
+    cborText(writer, PARAM_TABLE[i].name);
+    encodeAsciiText(writer, config->values[i]);
+  }
+
+  cborText(writer, "location");
+  if (!config->hasLocation) {
+    cborNull(writer);
+    return;
+  }
+  const location_int_t& l = config->location;
+  cborMap(writer, 6);
+  encodeKeyInt(writer, "lat", l.lat);
+  encodeKeyInt(writer, "lat_hp", l.lat_hp);
+  encodeKeyInt(writer, "lon", l.lon);
+  encodeKeyInt(writer, "lon_hp", l.lon_hp);
+  encodeKeyInt(writer, "alt", l.alt);
+  encodeKeyInt(writer, "alt_hp", l.alt_hp);
+}
+
+typedef void (*cbor_encoder_t)(RTKBaseManager::cbor_writer_t* writer, const void* data);
+
+static void encodeStatusData(RTKBaseManager::cbor_writer_t* writer, const void* data) {
+  RTKBaseManager::encodeStatus(writer, (const RTKBaseManager::status_snapshot_t*)data);
+}
+
+static void encodeConfigData(RTKBaseManager::cbor_writer_t* writer, const void* data) {
+  RTKBaseManager::encodeConfig(writer, (const RTKBaseManager::config_snapshot_t*)data);
+}
+
+// The snapshot lives in _tempObject until the request is freed, every chunk
+// encodes it again and keeps only its window, so no encoded copy is held
+static void sendCbor(AsyncWebServerRequest *request, cbor_encoder_t encode, const void* data, size_t dataLen) {
+  request->_tempObject = malloc(dataLen);
+  if (request->_tempObject == nullptr) {
+    request->send(503, "text/plain", "Low memory");
+    return;
+  }
+  memcpy(request->_tempObject, data, dataLen);
+
+  RTKBaseManager::cbor_writer_t writer;
+  RTKBaseManager::cborBegin(&writer, nullptr, 0, 0);
+  encode(&writer, request->_tempObject);
+
+  AsyncWebServerResponse* response = request->beginResponse(RTKBaseManager::MIME_CBOR, writer.len,
+      [request, encode](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+    RTKBaseManager::cbor_writer_t window;
+    RTKBaseManager::cborBegin(&window, buffer, index, maxLen);
+    encode(&window, request->_tempObject);
+    return RTKBaseManager::cborWindowLength(&window);
+  });
+  request->send(response);
+}
+
+// "0.5" -> 500, at most three decimals like RFC 9110, anything else is 1000
+static uint16_t parseQuality(const char* q, const char* end) {
+  if (q >= end || (*q != '0' && *q != '1')) return 1000;
+  uint16_t value = (*q++ - '0') * 1000;
+  if (q < end && *q == '.') {
+    q++;
+    for (uint16_t scale = 100; scale > 0 && q < end && isdigit((unsigned char)*q); scale /= 10) value += (*q++ - '0') * scale;
+  }
+  return (value > 1000) ? 1000 : value;
+}
+
+uint16_t RTKBaseManager::acceptQuality(const char* accept, const char* type) {
+  size_t typeLen = strlen(type);
+  const char* range = accept;
+  while (*range != '\0') {
+    const char* end = strchr(range, ',');
+    if (end == nullptr) end = range + strlen(range);
+    while (range < end && *range == ' ') range++;
+    const char* params = (const char*)memchr(range, ';', end - range);
+    const char* typeEnd = (params != nullptr) ? params : end;
+    while (typeEnd > range && typeEnd[-1] == ' ') typeEnd--;
+
+    if ((size_t)(typeEnd - range) == typeLen && strncasecmp(range, type, typeLen) == 0) {
+      uint16_t quality = 1000;
+      for (const char* p = params; p != nullptr && p < end; p = (const char*)memchr(p + 1, ';', end - p - 1)) {
+        const char* param = p + 1;
+        while (param < end && *param == ' ') param++;
+        if (end - param >= 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+          const char* valueEnd = (const char*)memchr(param, ';', end - param);
+          quality = parseQuality(param + 2, (valueEnd != nullptr) ? valueEnd : end);
+        }
+      }
+      return quality;
+    }
+    range = (*end == ',') ? end + 1 : end;
+  }
+  return 0;
+}
+
+bool RTKBaseManager::acceptsCbor(AsyncWebServerRequest *request) {
+  AsyncWebHeader* accept = request->getHeader("Accept");
+  if (accept == nullptr) return false;
+  const char* value = accept->value().c_str();
+  uint16_t cbor = acceptQuality(value, MIME_CBOR);
+  return cbor > 0 && cbor >= acceptQuality(value, "application/json");
+}
+
+/********************************************************************************
+*                             JSON
+* ******************************************************************************/
+
+size_t RTKBaseManager::appendJsonString(char* json, size_t size, size_t len, const char* str) {
+  if (len + 1 >= size) return len;
+  json[len++] = '"';
+  for (; *str != '\0' && len + 3 < size; str++) {
+    char c = *str;
+    if (c == '"' || c == '\\') json[len++] = '\\';
+    json[len++] = (c < 0x20 || c > 0x7E) ? '?' : c;
+  }
+  json[len++] = '"';
+  json[len] = '\0';
+  return len;
+}
+
+void RTKBaseManager::actionStatus(AsyncWebServerRequest *request) {
+  status_snapshot_t status;
+  getStatus(&status);
+  if (acceptsCbor(request)) {
+    sendCbor(request, encodeStatusData, &status, sizeof(status));
+    return;
+  }
+
+  char json[1280];
+  int len = snprintf(json, sizeof(json),
+           "{\"config_version\":%u,\"uptime_ms\":%u,\"free_heap\":%u,\"max_alloc_heap\":%u,"
+           "\"render_cache\":{\"hits\":%u,\"misses\":%u,\"uncacheable\":%u},"
+           "\"admission\":{\"admitted\":%u,\"rejected_busy\":%u,\"rejected_low_heap\":%u,"
+           "\"in_flight\":%u,\"peak_in_flight\":%u},\"assets_mounted\":%s,"
+           "\"alloc\":{\"tracking\":%s,\"allocs\":%u,\"frees\":%u,\"bytes\":%u,\"failed\":%u},"
+           "\"requests\":[",
+           status.configVersion, status.uptimeMs, status.freeHeap, status.maxAllocHeap,
+           status.cache.hits, status.cache.misses, status.cache.uncacheable,
+           status.admission.admitted, status.admission.rejectedBusy, status.admission.rejectedLowHeap,
+           status.admission.inFlight, status.admission.peakInFlight, status.assetsMounted ? "true" : "false",
+           status.allocTracking ? "true" : "false",
+           status.alloc.allocs, status.alloc.frees, status.alloc.bytes, status.alloc.failed);
+  for (uint8_t i = 0; i < status.requestCount && len > 0 && (size_t)len < sizeof(json); i++) {
+    const request_alloc_t& r = status.requests[i];
+    // The URL comes from the client, escape it like the config values
+    len += snprintf(json + len, sizeof(json) - len, "%s{\"url\":", (i == 0) ? "" : ",");
+    if ((size_t)len >= sizeof(json)) break;
+    len = appendJsonString(json, sizeof(json), len, r.url);
+    len += snprintf(json + len, sizeof(json) - len, ",\"allocs\":%u,\"frees\":%u,\"bytes\":%u,\"handler_us\":%u}",
+                    r.allocs, r.frees, r.bytes, r.handlerUs);
+  }
+  if (len > 0 && (size_t)len < sizeof(json)) snprintf(json + len, sizeof(json) - len, "]}");
+  request->send(200, "application/json", json);
+}
+
+void RTKBaseManager::actionConfig(AsyncWebServerRequest *request) {
+  config_snapshot_t config;
+  readConfig(&config);
+  if (acceptsCbor(request)) {
+    sendCbor(request, encodeConfigData, &config, sizeof(config));
+    return;
+  }
+
+  // Values are escaped to twice their length at most
+  char json[PARAM_COUNT * (2 * CONFIG_VALUE_MAX_LEN + 24) + 160];
+  size_t len = snprintf(json, sizeof(json), "{\"config_version\":%u,\"values\":{", (unsigned int)config.version);
+  bool first = true;
+  for (uint8_t i = 0; i < PARAM_COUNT && len < sizeof(json); i++) {
+    if (!exported(PARAM_TABLE[i])) continue;
+    len += snprintf(json + len, sizeof(json) - len, "%s\"%s\":", first ? "" : ",", PARAM_TABLE[i].name);
+    len = appendJsonString(json, sizeof(json), len, config.values[i]);
+    first = false;
+  }
+  if (len >= sizeof(json)) {
+    // Cannot happen with the sizes above, never send a cut JSON
+    request->send(500, "text/plain", "Config too large");
+    return;
+  }
+  if (config.hasLocation) {
+    const location_int_t& l = config.location;
+    snprintf(json + len, sizeof(json) - len,
+             "},\"location\":{\"lat\":%d,\"lat_hp\":%d,\"lon\":%d,\"lon_hp\":%d,\"alt\":%d,\"alt_hp\":%d}}",
+             (int)l.lat, l.lat_hp, (int)l.lon, l.lon_hp, (int)l.alt, l.alt_hp);
+  } else {
+    snprintf(json + len, sizeof(json) - len, "},\"location\":null}");
+  }
+  request->send(200, "application/json", json);
+}
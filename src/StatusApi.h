@@ -0,0 +1,110 @@
+/**
+ * @file    StatusApi.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   /api/status and /api/config as JSON or, if the Accept header asks
+ *          for application/cbor, as CBOR. The CBOR variants carry the same
+ *          keys, the location as the raw integer parts of location_int_t,
+ *          and are streamed by the windowed encoder of Cbor.h.
+ */
+
+#ifndef STATUS_API_H
+#define STATUS_API_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <RTKBaseManager.h>
+#include <RenderCache.h>
+#include <AdmissionControl.h>
+#include <AllocTracker.h>
+#include <Cbor.h>
+
+namespace RTKBaseManager {
+  constexpr char MIME_CBOR[] PROGMEM = "application/cbor";
+
+typedef struct {
+  uint32_t              configVersion;
+  uint32_t              uptimeMs;
+  uint32_t              freeHeap;
+  uint32_t              maxAllocHeap;
+  render_cache_stats_t  cache;
+  admission_stats_t     admission;
+  bool                  assetsMounted;
+  bool                  allocTracking;
+  alloc_stats_t         alloc;
+  uint8_t               requestCount;
+  request_alloc_t       requests[REQUEST_HISTORY_LEN];  // closed requests, newest first
+} status_snapshot_t;
+
+  /**
+   * @brief Collect the telemetry of the base
+   *
+   * @param status  Address of the snapshot to write to
+   */
+  void getStatus(status_snapshot_t* status);
+
+  /**
+   * @brief Encode a status snapshot, same keys as the JSON of /api/status
+   *
+   * @param writer  Writer
+   * @param status  Snapshot
+   */
+  void encodeStatus(cbor_writer_t* writer, const status_snapshot_t* status);
+
+  /**
+   * @brief Encode a config snapshot without secrets and derived values,
+   *        the location as integer parts or null
+   *
+   * @param writer  Writer
+   * @param config  Snapshot
+   */
+  void encodeConfig(cbor_writer_t* writer, const config_snapshot_t* config);
+
+  /**
+   * @brief Quality of a media type in an Accept header, wildcards do not count
+   *
+   * @param accept    Value of the Accept header
+   * @param type      Media type, e.g. MIME_CBOR
+   * @return uint16_t q in thousandths, 1000 without q, 0 if not listed or q=0
+   */
+  uint16_t acceptQuality(const char* accept, const char* type);
+
+  /**
+   * @brief Check if a request accepts CBOR
+   *
+   * @param request Request
+   * @return true   If the Accept header lists application/cbor with q > 0
+   *                and not below application/json
+   */
+  bool acceptsCbor(AsyncWebServerRequest *request);
+
+  /**
+   * @brief Append a quoted JSON string, quote and backslash escaped, other
+   *        control and non ASCII bytes replaced by '?'
+   *
+   * @param json    Buffer
+   * @param size    Size of the buffer
+   * @param len     Length of the JSON in the buffer
+   * @param str     String to append
+   * @return size_t New length, unchanged if the buffer is full
+   */
+  size_t appendJsonString(char* json, size_t size, size_t len, const char* str);
+
+  /**
+   * @brief Telemetry of the base as JSON or CBOR: config version, uptime,
+   *        free heap, render cache, admission and allocation counters
+   *
+   * @param request Request
+   */
+  void actionStatus(AsyncWebServerRequest *request);
+
+  /**
+   * @brief Current config as JSON or CBOR, without secrets
+   *
+   * @param request Request
+   */
+  void actionConfig(AsyncWebServerRequest *request);
+}
+
+#endif /*** STATUS_API_H ***/
@@ -0,0 +1,338 @@
+#include <Storage.h>
+#include <FlashBudget.h>
+#include <LittleFS.h>
+#ifdef ESP32
+  #include <Preferences.h>
+  #include <esp_partition.h>
+#endif
+#include <atomic>
+
+/********************************************************************************
+*                             File system backends
+* ******************************************************************************/
+
+static size_t fsRead(fs::FS &fs, const char* path, char* out, size_t outLen) {
+  if (outLen == 0) return 0;
+  out[0] = '\0';
+  File file = fs.open(path, "r");
+  if (!file || file.isDirectory()) return 0;
+  size_t len = file.read((uint8_t*)out, outLen - 1);
+  out[len] = '\0';
+  file.close();
+  return len;
+}
+
+static bool fsRemove(fs::FS &fs, const char* path) {
+  return fs.exists(path) && fs.remove(path);
+}
+
+static void fsWipe(fs::FS &fs) {
+  File root = fs.open("/");
+  File file = root.openNextFile();
+
+  DEBUG_SERIAL.println(F("Wiping: "));
+  while (file) {
+    DEBUG_SERIAL.print("FILE: ");
+    DEBUG_SERIAL.println(file.path());
+    fs.remove(file.path());
+    file = root.openNextFile();
+  }
+  root.close();
+}
+
+static void fsList(fs::FS &fs) {
+  File root = fs.open("/");
+  File file = root.openNextFile();
+
+  while (file) {
+    DEBUG_SERIAL.print("FILE: ");
+    DEBUG_SERIAL.println(file.name());
+    file = root.openNextFile();
+  }
+  root.close();
+}
+
+static bool littleFSBegin(bool format) {
+  bool success = true;
+  #ifdef ESP32
+    success = LittleFS.begin(true);
+  #else
+    success = LittleFS.begin();
+  #endif
+  if (!success) {
+    DEBUG_SERIAL.println("An Error has occurred while mounting LittleFS");
+    return false;
+  }
+  if (format) {
+    DEBUG_SERIAL.println(F("formatting LittleFS, ..."));
+    success &= LittleFS.format();
+  }
+  return success;
+}
+
+static const RTKBaseManager::storage_backend_t SPIFFS_BACKEND = {
+  "spiffs",
+  RTKBaseManager::setupSPIFFS,
+  []() { SPIFFS.end(); },
+  [](const char* path, char* out, size_t outLen) { return fsRead(SPIFFS, path, out, outLen); },
+  [](const char* path, const char* value) { return RTKBaseManager::writeFile(SPIFFS, path, value); },
+  [](const char* path) { return fsRemove(SPIFFS, path); },
+  []() { fsWipe(SPIFFS); },
+  []() { fsList(SPIFFS); }
+};
+
+static const RTKBaseManager::storage_backend_t LITTLEFS_BACKEND = {
+  "littlefs",
+  littleFSBegin,
+  []() { LittleFS.end(); },
+  [](const char* path, char* out, size_t outLen) { return fsRead(LittleFS, path, out, outLen); },
+  [](const char* path, const char* value) { return RTKBaseManager::writeFile(LittleFS, path, value); },
+  [](const char* path) { return fsRemove(LittleFS, path); },
+  []() { fsWipe(LittleFS); },
+  []() { fsList(LittleFS); }
+};
+
+/********************************************************************************
+*                             NVS backend
+* ******************************************************************************/
+
+void RTKBaseManager::nvsKeyFromPath(const char* path, char* key) {
+  if (path[0] == '/') path++;
+  size_t len = strlen(path);
+  if (len >= 4 && strcmp(path + len - 4, ".txt") == 0) len -= 4;
+
+  if (len <= NVS_KEY_MAX_LEN) {
+    memcpy(key, path, len);
+    key[len] = '\0';
+    return;
+  }
+  // 6 chars of the name, '~' and 8 hex digits of the hash keep it unique
+  memcpy(key, path, 6);
+  snprintf(key + 6, NVS_KEY_MAX_LEN + 1 - 6, "~%08x", (unsigned int)PerfectHash::fnv1a(path, PerfectHash::FNV_OFFSET));
+}
+
+#ifdef ESP32
+static const char NVS_NAMESPACE[] = "rtkbase";
+static Preferences nvs;
+
+static bool nvsBegin(bool format) {
+  if (!nvs.begin(NVS_NAMESPACE, false)) {
+    DEBUG_SERIAL.println("An Error has occurred while opening NVS");
+    return false;
+  }
+  if (format) {
+    DEBUG_SERIAL.println(F("clearing NVS, ..."));
+    return nvs.clear();
+  }
+  return true;
+}
+
+static size_t nvsRead(const char* path, char* out, size_t outLen) {
+  char key[RTKBaseManager::NVS_KEY_MAX_LEN + 1];
+  if (outLen == 0) return 0;
+  out[0] = '\0';
+  RTKBaseManager::nvsKeyFromPath(path, key);
+  // isKey() first, a missing key would log an error
+  if (!nvs.isKey(key) || nvs.getString(key, out, outLen) == 0) {
+    out[0] = '\0';
+    return 0;
+  }
+  return strlen(out);
+}
+
+static bool nvsWrite(const char* path, const char* value) {
+  char key[RTKBaseManager::NVS_KEY_MAX_LEN + 1];
+  RTKBaseManager::nvsKeyFromPath(path, key);
+  DEBUG_SERIAL.printf("Writing key: %s\r\n", key);
+  // NVS skips the flash write if the stored value is the same
+  return nvs.putString(key, value) == strlen(value);
+}
+
+static bool nvsRemove(const char* path) {
+  char key[RTKBaseManager::NVS_KEY_MAX_LEN + 1];
+  RTKBaseManager::nvsKeyFromPath(path, key);
+  return nvs.isKey(key) && nvs.remove(key);
+}
+
+static void nvsList() {
+  using namespace RTKBaseManager;
+  char key[NVS_KEY_MAX_LEN + 1];
+  // Preferences can not iterate, the table holds all keys in use
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    if (PARAM_TABLE[i].check == CHECK_NONE) continue;
+    nvsKeyFromPath(PARAM_TABLE[i].path, key);
+    if (!nvs.isKey(key)) continue;
+    DEBUG_SERIAL.print("KEY: ");
+    DEBUG_SERIAL.println(key);
+  }
+}
+
+static const RTKBaseManager::storage_backend_t NVS_BACKEND = {
+  "nvs",
+  nvsBegin,
+  []() { nvs.end(); },
+  nvsRead,
+  nvsWrite,
+  nvsRemove,
+  []() { nvs.clear(); },
+  nvsList
+};
+
+// The backend of the last boot, kept apart from the values so it survives a wipe
+static const char MARKER_NAMESPACE[] = "rtkstorage";
+static const char MARKER_KEY[] = "backend";
+
+static uint8_t readBackendMarker() {
+  Preferences marker;
+  // Firmware before the storage backends kept everything in SPIFFS
+  if (!marker.begin(MARKER_NAMESPACE, true)) return STORAGE_SPIFFS;
+  uint8_t kind = (uint8_t)marker.getUInt(MARKER_KEY, STORAGE_SPIFFS);
+  marker.end();
+  return kind;
+}
+
+static void writeBackendMarker(uint8_t kind) {
+  Preferences marker;
+  if (!marker.begin(MARKER_NAMESPACE, false)) return;
+  if (marker.getUInt(MARKER_KEY, 0xFF) != kind) marker.putUInt(MARKER_KEY, kind);
+  marker.end();
+}
+#else
+static uint8_t readBackendMarker() { return STORAGE_BACKEND; }
+static void writeBackendMarker(uint8_t kind) {}
+#endif
+
+/********************************************************************************
+*                             Storage
+* ******************************************************************************/
+
+const RTKBaseManager::storage_backend_t* RTKBaseManager::getStorageBackend(uint8_t kind) {
+  switch (kind) {
+    case STORAGE_SPIFFS:    return &SPIFFS_BACKEND;
+    case STORAGE_LITTLEFS:  return &LITTLEFS_BACKEND;
+  #ifdef ESP32
+    case STORAGE_NVS:       return &NVS_BACKEND;
+  #endif
+    default:                return nullptr;
+  }
+}
+
+const RTKBaseManager::storage_backend_t* RTKBaseManager::activeStorage() {
+  static_assert(STORAGE_BACKEND < STORAGE_BACKEND_COUNT, "unknown STORAGE_BACKEND");
+  return getStorageBackend(STORAGE_BACKEND);
+}
+
+bool RTKBaseManager::setupStorage(bool format) {
+  uint8_t previous = readBackendMarker();
+  bool success;
+
+  if (!format && previous != STORAGE_BACKEND && getStorageBackend(previous) != nullptr) {
+    DEBUG_SERIAL.printf("Migrating storage from %s to %s\r\n", getStorageBackend(previous)->name, activeStorage()->name);
+    success = migrateStorage(previous, STORAGE_BACKEND);
+  } else {
+    success = activeStorage()->begin(format);
+  }
+  if (success) writeBackendMarker(STORAGE_BACKEND);
+  return success;
+}
+
+bool RTKBaseManager::migrateStorage(uint8_t from, uint8_t to) {
+  const storage_backend_t* source = getStorageBackend(from);
+  const storage_backend_t* target = getStorageBackend(to);
+  if (target == nullptr) return false;
+  if (source == nullptr || source == target) return target->begin(false);
+
+  // SPIFFS and LittleFS share the data partition, only one can be mounted
+  bool samePartition = from != STORAGE_NVS && to != STORAGE_NVS;
+  config_snapshot_t values;
+  memset(&values, 0, sizeof(values));
+
+  bool sourceMounted = source->begin(false);
+  if (sourceMounted) {
+    for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+      if (PARAM_TABLE[i].check == CHECK_NONE) continue;
+      source->read(PARAM_TABLE[i].path, values.values[i], sizeof(values.values[i]));
+    }
+    if (samePartition) source->end();
+  }
+
+  if (!target->begin(samePartition)) return false;
+  bool success = true;
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    if (values.values[i][0] == '\0') continue;
+    success &= target->write(PARAM_TABLE[i].path, values.values[i]);
+  }
+
+  // Wipe the source only if every value arrived, a later boot may retry
+  if (sourceMounted && !samePartition) {
+    if (success) source->wipe();
+    source->end();
+  }
+  return success;
+}
+
+size_t RTKBaseManager::readStored(const char* path, char* out, size_t outLen) {
+  // A write held over the flash budget is the current value
+  size_t len = readHeldWrite(path, out, outLen);
+  return (len > 0) ? len : activeStorage()->read(path, out, outLen);
+}
+
+String RTKBaseManager::readStoredString(const char* path) {
+  char value[CONFIG_VALUE_MAX_LEN + 1];
+  readStored(path, value, sizeof(value));
+  return String(value);
+}
+
+bool RTKBaseManager::writeStored(const char* path, const char* value) {
+  return budgetedWrite(path, value);
+}
+
+bool RTKBaseManager::removeStored(const char* path) {
+  return budgetedRemove(path);
+}
+
+/********************************************************************************
+*                             Flash wear counters
+* ******************************************************************************/
+
+static std::atomic<uint32_t> flashWrites(0);
+static std::atomic<uint32_t> flashBytesWritten(0);
+static std::atomic<uint32_t> flashErases(0);
+static std::atomic<uint32_t> flashBytesErased(0);
+
+#if defined(ESP32) && defined(RTK_FLASH_TRACKING)
+// SPIFFS, LittleFS and NVS all write through the partition API
+extern "C" {
+  esp_err_t __real_esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size);
+  esp_err_t __real_esp_partition_write_raw(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size);
+  esp_err_t __real_esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size);
+
+  static void countWrite(size_t size) {
+    flashWrites.fetch_add(1, std::memory_order_relaxed);
+    flashBytesWritten.fetch_add(size, std::memory_order_relaxed);
+  }
+
+  esp_err_t __wrap_esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size) {
+    countWrite(size);
+    return __real_esp_partition_write(partition, dst_offset, src, size);
+  }
+
+  esp_err_t __wrap_esp_partition_write_raw(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size) {
+    countWrite(size);
+    return __real_esp_partition_write_raw(partition, dst_offset, src, size);
+  }
+
+  esp_err_t __wrap_esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    flashErases.fetch_add(1, std::memory_order_relaxed);
+    flashBytesErased.fetch_add(size, std::memory_order_relaxed);
+    return __real_esp_partition_erase_range(partition, offset, size);
+  }
+}
+#endif
+
+void RTKBaseManager::getFlashStats(flash_stats_t* stats) {
+  stats->writes = flashWrites.load();
+  stats->bytesWritten = flashBytesWritten.load();
+  stats->erases = flashErases.load();
+  stats->bytesErased = flashBytesErased.load();
+}
@@ -0,0 +1,135 @@
+/**
+ * @file    Storage.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Storage backends of the config values: SPIFFS, LittleFS and NVS,
+ *          chosen at build time with STORAGE_BACKEND in ManagerConfig.h.
+ *          All backends take the same paths, NVS maps them to keys. The
+ *          backend of the last boot is remembered in NVS, so values move
+ *          over when the firmware comes with another backend.
+ */
+
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <Arduino.h>
+#include <RTKBaseManager.h>
+
+namespace RTKBaseManager {
+  const uint8_t STORAGE_BACKEND_COUNT = 3;
+  // NVS key length without terminator
+  const uint8_t NVS_KEY_MAX_LEN = 15;
+
+typedef struct {
+  const char* name;
+  bool   (*begin)(bool format);                                // mount, format first if true
+  void   (*end)(void);
+  size_t (*read)(const char* path, char* out, size_t outLen);  // 0 if missing
+  bool   (*write)(const char* path, const char* value);
+  bool   (*remove)(const char* path);
+  void   (*wipe)(void);                                        // remove all values
+  void   (*list)(void);                                        // print all values to DEBUG_SERIAL
+} storage_backend_t;
+
+typedef struct {
+  uint32_t writes;        // flash write calls of all partitions
+  uint32_t bytesWritten;
+  uint32_t erases;        // flash erase calls, each one wears the erased sectors
+  uint32_t bytesErased;
+} flash_stats_t;
+
+  /**
+   * @brief Get a storage backend
+   *
+   * @param kind  STORAGE_SPIFFS, STORAGE_LITTLEFS or STORAGE_NVS
+   * @return const storage_backend_t* Backend or nullptr if not available on this platform
+   */
+  const storage_backend_t* getStorageBackend(uint8_t kind);
+
+  /**
+   * @brief Get the backend chosen with STORAGE_BACKEND
+   *
+   * @return const storage_backend_t* Active backend
+   */
+  const storage_backend_t* activeStorage(void);
+
+  /**
+   * @brief Mount the active backend, migrate the values of the backend of the
+   *        last boot first if it was another one
+   *
+   * @param format  True to start with empty storage, nothing is migrated
+   * @return true   If the active backend is mounted
+   * @return false  If mounting failed
+   */
+  bool setupStorage(bool format);
+
+  /**
+   * @brief Copy all PARAM_TABLE values from one backend to another and wipe
+   *        them on the source. Backends on the same partition are handled:
+   *        the values are held in RAM while the partition is reformatted.
+   *
+   * @param from    Kind of the source backend
+   * @param to      Kind of the target backend, mounted afterwards
+   * @return true   If the target is mounted and all values were written
+   * @return false  If mounting the target or a write failed
+   */
+  bool migrateStorage(uint8_t from, uint8_t to);
+
+  /**
+   * @brief Read a value of the active backend without heap allocations
+   *
+   * @param path    Path of the value
+   * @param out     Buffer, zero terminated
+   * @param outLen  Size of the buffer
+   * @return size_t Length of the value, 0 if missing
+   */
+  size_t readStored(const char* path, char* out, size_t outLen);
+
+  /**
+   * @brief Read a value of the active backend as String
+   *
+   * @param path    Path of the value
+   * @return String Value, empty if missing
+   */
+  String readStoredString(const char* path);
+
+  /**
+   * @brief Write a value to the active backend within the flash budget, an
+   *        unchanged value is skipped, see FlashBudget.h
+   *
+   * @param path    Path of the value
+   * @param value   Value
+   * @return true   If succeed, also if held for the next hour
+   * @return false  If failed
+   */
+  bool writeStored(const char* path, const char* value);
+
+  /**
+   * @brief Remove a value of the active backend
+   *
+   * @param path    Path of the value
+   * @return true   If the value was removed
+   * @return false  If it did not exist
+   */
+  bool removeStored(const char* path);
+
+  /**
+   * @brief Map a path to a NVS key: without leading "/" and ".txt", longer
+   *        names are cut and get the hash of the path appended
+   *
+   * @param path  Path
+   * @param key   Buffer of at least NVS_KEY_MAX_LEN + 1 bytes
+   */
+  void nvsKeyFromPath(const char* path, char* key);
+
+  /**
+   * @brief Get the flash write and erase counters since boot
+   *
+   * @param stats Address of the struct to write to, all 0 unless built with
+   *              RTK_FLASH_TRACKING and the matching -Wl,--wrap flags
+   */
+  void getFlashStats(flash_stats_t* stats);
+}
+
+#endif /*** STORAGE_H ***/
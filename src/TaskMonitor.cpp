@@ -0,0 +1,157 @@
+#include <TaskMonitor.h>
+#include <StatusApi.h>
+#include <TaskRuntime.h>
+#include <esp_freertos_hooks.h>
+
+/********************************************************************************
+*                             Tick sampling
+* ******************************************************************************/
+
+typedef struct {
+  TaskHandle_t task;
+  uint32_t     samples;
+  uint32_t     switches;
+  uint8_t      cores;
+} task_sample_t;
+
+typedef struct {
+  uint8_t       count;
+  uint32_t      ticks;          // of core 0, the cores tick in step
+  uint32_t      unaccounted;
+  task_sample_t tasks[RTKBaseManager::TASK_MONITOR_MAX_TASKS];
+} sample_table_t;
+
+static const uint32_t INTERVAL_TICKS = pdMS_TO_TICKS(TASK_STATS_INTERVAL_MS);
+
+// Written by the tick hooks of both cores, read by getTaskStats()
+static sample_table_t currentSamples;
+static sample_table_t lastSamples;
+static TaskHandle_t previousTask[portNUM_PROCESSORS];
+static portMUX_TYPE monitorMux = portMUX_INITIALIZER_UNLOCKED;
+static bool monitorStarted = false;
+
+static task_sample_t* IRAM_ATTR findSample(TaskHandle_t task) {
+  for (uint8_t i = 0; i < currentSamples.count; i++) {
+    if (currentSamples.tasks[i].task == task) return &currentSamples.tasks[i];
+  }
+  if (currentSamples.count == RTKBaseManager::TASK_MONITOR_MAX_TASKS) return nullptr;
+  task_sample_t* sample = &currentSamples.tasks[currentSamples.count++];
+  memset(sample, 0, sizeof(task_sample_t));
+  sample->task = task;
+  return sample;
+}
+
+// Runs in the tick interrupt, keep it short and in IRAM
+static void IRAM_ATTR sampleCore(uint8_t core) {
+  TaskHandle_t task = xTaskGetCurrentTaskHandleForCPU(core);
+  portENTER_CRITICAL_ISR(&monitorMux);
+  task_sample_t* sample = findSample(task);
+  if (sample == nullptr) {
+    currentSamples.unaccounted++;
+  } else {
+    sample->samples++;
+    sample->cores |= 1 << core;
+    if (previousTask[core] != task) sample->switches++;
+  }
+  previousTask[core] = task;
+
+  if (core == 0 && ++currentSamples.ticks >= INTERVAL_TICKS) {
+    memcpy(&lastSamples, &currentSamples, sizeof(sample_table_t));
+    currentSamples.count = 0;
+    currentSamples.ticks = 0;
+    currentSamples.unaccounted = 0;
+  }
+  portEXIT_CRITICAL_ISR(&monitorMux);
+}
+
+static void IRAM_ATTR sampleCore0() {
+  sampleCore(0);
+}
+
+static void IRAM_ATTR sampleCore1() {
+  sampleCore(1);
+}
+
+bool RTKBaseManager::startTaskMonitor() {
+  if (monitorStarted) return true;
+  if (esp_register_freertos_tick_hook_for_cpu(sampleCore0, 0) != ESP_OK) return false;
+  if (portNUM_PROCESSORS > 1 && esp_register_freertos_tick_hook_for_cpu(sampleCore1, 1) != ESP_OK) {
+    esp_deregister_freertos_tick_hook_for_cpu(sampleCore0, 0);
+    return false;
+  }
+  monitorStarted = true;
+  return true;
+}
+
+/********************************************************************************
+*                             Stats
+* ******************************************************************************/
+
+static void sortByCpu(RTKBaseManager::task_stats_t* stats, uint8_t count) {
+  for (uint8_t i = 1; i < count; i++) {
+    RTKBaseManager::task_stats_t s = stats[i];
+    uint8_t j = i;
+    while (j > 0 && stats[j - 1].samples < s.samples) {
+      stats[j] = stats[j - 1];
+      j--;
+    }
+    stats[j] = s;
+  }
+}
+
+uint8_t RTKBaseManager::getTaskStats(task_stats_t* stats, task_interval_t* interval) {
+  sample_table_t samples;
+  portENTER_CRITICAL(&monitorMux);
+  memcpy(&samples, &lastSamples, sizeof(sample_table_t));
+  portEXIT_CRITICAL(&monitorMux);
+  interval->intervalMs = samples.ticks * portTICK_PERIOD_MS;
+  interval->ticks = samples.ticks;
+  interval->unaccounted = samples.unaccounted;
+
+  // Live tasks only, a sampled handle of a deleted task is never dereferenced
+  TaskStatus_t live[TASK_MONITOR_MAX_TASKS];
+  uint8_t count = uxTaskGetSystemState(live, TASK_MONITOR_MAX_TASKS, nullptr);
+  for (uint8_t i = 0; i < count; i++) {
+    task_stats_t& s = stats[i];
+    memset(&s, 0, sizeof(task_stats_t));
+    strncpy(s.name, live[i].pcTaskName, sizeof(s.name) - 1);
+    s.priority = live[i].uxCurrentPriority;
+    s.stackFree = live[i].usStackHighWaterMark;   // bytes on the ESP32 port
+    for (uint8_t j = 0; j < samples.count; j++) {
+      if (samples.tasks[j].task != live[i].xHandle) continue;
+      s.samples = samples.tasks[j].samples;
+      s.switches = samples.tasks[j].switches;
+      s.cores = samples.tasks[j].cores;
+      s.cpuPermille = (samples.ticks == 0) ? 0 : (uint16_t)(1000ull * s.samples / samples.ticks);
+      break;
+    }
+  }
+  sortByCpu(stats, count);
+  return count;
+}
+
+/********************************************************************************
+*                             API
+* ******************************************************************************/
+
+void RTKBaseManager::actionTasks(AsyncWebServerRequest *request) {
+  task_stats_t stats[TASK_MONITOR_MAX_TASKS];
+  task_interval_t interval;
+  uint8_t count = getTaskStats(stats, &interval);
+
+  char json[TASK_MONITOR_MAX_TASKS * 140 + 96];
+  size_t len = snprintf(json, sizeof(json), "{\"profile\":\"%s\",\"interval_ms\":%u,\"ticks\":%u,\"unaccounted\":%u,\"tasks\":[",
+                        activeRuntimeProfile()->name, (unsigned int)interval.intervalMs, (unsigned int)interval.ticks,
+                        (unsigned int)interval.unaccounted);
+  for (uint8_t i = 0; i < count && len < sizeof(json); i++) {
+    const task_stats_t& s = stats[i];
+    len += snprintf(json + len, sizeof(json) - len, "%s{\"name\":", (i == 0) ? "" : ",");
+    len = appendJsonString(json, sizeof(json), len, s.name);
+    len += snprintf(json + len, sizeof(json) - len,
+                    ",\"priority\":%u,\"cores\":%u,\"cpu_percent\":%u.%u,\"switches\":%u,\"stack_free\":%u}",
+                    s.priority, s.cores, s.cpuPermille / 10, s.cpuPermille % 10,
+                    (unsigned int)s.switches, (unsigned int)s.stackFree);
+  }
+  if (len < sizeof(json)) snprintf(json + len, sizeof(json) - len, "]}");
+  request->send(200, "application/json", json);
+}
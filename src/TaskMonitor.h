@@ -0,0 +1,67 @@
+/**
+ * @file    TaskMonitor.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Sampling CPU accounting per FreeRTOS task. A tick hook on each core
+ *          counts the task it interrupted, so a task running for n of the
+ *          ticks of an interval used about n / ticks of a core. Task changes
+ *          between two ticks of a core are counted as switches, switches
+ *          faster than the tick rate are not seen. Reported per interval of
+ *          TASK_STATS_INTERVAL_MS together with the stack high-water marks.
+ */
+
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <ManagerConfig.h>
+
+namespace RTKBaseManager {
+  const uint8_t TASK_MONITOR_MAX_TASKS = 24;
+
+typedef struct {
+  char     name[configMAX_TASK_NAME_LEN];
+  uint8_t  priority;
+  uint8_t  cores;         // bit n set if sampled on core n
+  uint16_t cpuPermille;   // of one core in the last interval
+  uint32_t samples;       // ticks the task was running in the last interval
+  uint32_t switches;      // times it was seen switched in
+  uint32_t stackFree;     // high-water mark, least free stack bytes since start
+} task_stats_t;
+
+typedef struct {
+  uint32_t intervalMs;    // length of the last interval, 0 before the first one ended
+  uint32_t ticks;         // ticks per core in the last interval
+  uint32_t unaccounted;   // samples of tasks beyond TASK_MONITOR_MAX_TASKS
+} task_interval_t;
+
+  /**
+   * @brief Register the tick hooks on both cores, call once at start
+   *
+   * @return true   If sampling runs
+   * @return false  If a hook could not be registered
+   */
+  bool startTaskMonitor(void);
+
+  /**
+   * @brief Get the stats of the last complete interval, busiest task first.
+   *        Tasks deleted since are left out.
+   *
+   * @param stats     Array of at least TASK_MONITOR_MAX_TASKS entries
+   * @param interval  Address to write the interval to
+   * @return uint8_t  Number of tasks written, 0 if more than
+   *                  TASK_MONITOR_MAX_TASKS tasks exist
+   */
+  uint8_t getTaskStats(task_stats_t* stats, task_interval_t* interval);
+
+  /**
+   * @brief Handler of /api/tasks, the stats as JSON
+   *
+   * @param request Request
+   */
+  void actionTasks(AsyncWebServerRequest *request);
+}
+
+#endif /*** TASK_MONITOR_H ***/
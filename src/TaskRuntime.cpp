@@ -0,0 +1,53 @@
+#include <TaskRuntime.h>
+
+/********************************************************************************
+*                             Profiles
+* ******************************************************************************/
+
+static const RTKBaseManager::runtime_profile_t* activeProfile = nullptr;
+
+const RTKBaseManager::runtime_profile_t* RTKBaseManager::findRuntimeProfile(const char* name) {
+  for (size_t i = 0; i < RUNTIME_PROFILE_COUNT; i++) {
+    if (strcmp(RUNTIME_PROFILES[i].name, name) == 0) return &RUNTIME_PROFILES[i];
+  }
+  return nullptr;
+}
+
+const RTKBaseManager::runtime_profile_t* RTKBaseManager::activeRuntimeProfile() {
+  if (activeProfile != nullptr) return activeProfile;
+
+  config_snapshot_t config;
+  readConfig(&config);
+  const runtime_profile_t* profile = findRuntimeProfile(config.values[findParam(PARAM_TASK_PROFILE)]);
+  activeProfile = (profile != nullptr) ? profile : &RUNTIME_PROFILES[0];
+  DEBUG_SERIAL.print(F("Task profile: ")); DEBUG_SERIAL.println(activeProfile->name);
+  return activeProfile;
+}
+
+/********************************************************************************
+*                             Tasks
+* ******************************************************************************/
+
+bool RTKBaseManager::spawnTask(task_role_t role, TaskFunction_t function, const char* name, uint32_t stackBytes, void* arg, TaskHandle_t* handle) {
+  const task_placement_t& placement = activeRuntimeProfile()->roles[role];
+  BaseType_t core = (placement.core == TASK_ANY_CORE) ? tskNO_AFFINITY : placement.core;
+  return xTaskCreatePinnedToCore(function, name, stackBytes, arg, placement.priority, handle, core) == pdPASS;
+}
+
+void RTKBaseManager::applyRuntimeProfile() {
+  const task_placement_t& http = activeRuntimeProfile()->roles[TASK_ROLE_HTTP];
+  TaskHandle_t asyncTcp = xTaskGetHandle("async_tcp");
+  if (asyncTcp == nullptr) {
+    DEBUG_SERIAL.println(F("No async_tcp task, start the server first"));
+    return;
+  }
+  vTaskPrioritySet(asyncTcp, http.priority);
+
+  // FreeRTOS cannot move a running task, AsyncTCP pins it when it creates it
+  BaseType_t affinity = xTaskGetAffinity(asyncTcp);
+  BaseType_t wanted = (http.core == TASK_ANY_CORE) ? tskNO_AFFINITY : http.core;
+  if (affinity != wanted) {
+    DEBUG_SERIAL.printf("async_tcp runs on core %d, the profile wants %d, build with -DCONFIG_ASYNC_TCP_RUNNING_CORE=%d\r\n",
+                        (int)affinity, (int)wanted, (int)http.core);
+  }
+}
@@ -0,0 +1,91 @@
+/**
+ * @file    TaskRuntime.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Core affinity and priority of the worker tasks by role. A profile
+ *          places every role, the profile is chosen with the task_profile
+ *          config value and applied at boot. Workers are started with
+ *          spawnTask() instead of xTaskCreatePinnedToCore(), so a profile
+ *          keeps correction forwarding away from bursts of UI traffic.
+ *
+ *          The async_tcp task of the web server is created by AsyncTCP: its
+ *          priority follows the profile, its core is fixed at build time by
+ *          CONFIG_ASYNC_TCP_RUNNING_CORE.
+ */
+
+#ifndef TASK_RUNTIME_H
+#define TASK_RUNTIME_H
+
+#include <Arduino.h>
+#include <RTKBaseManager.h>
+
+namespace RTKBaseManager {
+  const int8_t TASK_ANY_CORE = -1;
+
+typedef enum {
+  TASK_ROLE_GNSS_INGEST,        // reads the receiver
+  TASK_ROLE_CORRECTION_EGRESS,  // forwards RTCM to the casters
+  TASK_ROLE_HTTP,               // async_tcp, runs the web server handlers
+  TASK_ROLE_BACKGROUND,         // WiFi survey and other housekeeping
+  TASK_ROLE_COUNT
+} task_role_t;
+
+typedef struct {
+  int8_t  core;       // 0, 1 or TASK_ANY_CORE
+  uint8_t priority;   // FreeRTOS priority, loopTask runs at 1
+} task_placement_t;
+
+typedef struct {
+  const char*       name;
+  task_placement_t  roles[TASK_ROLE_COUNT];
+} runtime_profile_t;
+
+  constexpr runtime_profile_t RUNTIME_PROFILES[] = {
+    // GNSS and corrections next to loop() on core 1, the rest where it fits
+    { TASK_PROFILE_BALANCED,    { { 1, 4 }, { 1, 4 }, { TASK_ANY_CORE, 3 }, { 0, 1 } } },
+    // Core 1 for GNSS and corrections only, UI and housekeeping on core 0 below WiFi
+    { TASK_PROFILE_ISOLATED,    { { 1, 6 }, { 1, 5 }, { 0, 2 },             { 0, 1 } } },
+    // Everything on core 0 for single core chips, ordered by priority
+    { TASK_PROFILE_SINGLE_CORE, { { 0, 5 }, { 0, 4 }, { 0, 3 },             { 0, 1 } } },
+  };
+  constexpr size_t RUNTIME_PROFILE_COUNT = sizeof(RUNTIME_PROFILES) / sizeof(RUNTIME_PROFILES[0]);
+
+  /**
+   * @brief Find a profile by name
+   *
+   * @param name                      Profile name, e.g. TASK_PROFILE_ISOLATED
+   * @return const runtime_profile_t* Profile or nullptr if unknown
+   */
+  const runtime_profile_t* findRuntimeProfile(const char* name);
+
+  /**
+   * @brief Get the profile of this boot, read from the config at the first
+   *        call, a changed task_profile takes effect after a reboot
+   *
+   * @return const runtime_profile_t* Profile, the first one if none is saved
+   */
+  const runtime_profile_t* activeRuntimeProfile(void);
+
+  /**
+   * @brief Start a task placed by the active profile
+   *
+   * @param role        Role of the task
+   * @param function    Task function
+   * @param name        Task name
+   * @param stackBytes  Stack size
+   * @param arg         Argument of the task function
+   * @param handle      Address to write the handle to, may be nullptr
+   * @return true       If the task was created
+   * @return false      If out of memory
+   */
+  bool spawnTask(task_role_t role, TaskFunction_t function, const char* name, uint32_t stackBytes, void* arg, TaskHandle_t* handle);
+
+  /**
+   * @brief Apply the profile to tasks created by libraries, call after
+   *        startServer() created the async_tcp task
+   */
+  void applyRuntimeProfile(void);
+}
+
+#endif /*** TASK_RUNTIME_H ***/
@@ -3,6 +3,26 @@
 
 #include <AUnit.h>
 #include <RTKBaseManager.h>
+#include <FormParser.h>
+#include <Seqlock.h>
+#include <Storage.h>
+#include <Assets.h>
+#include <NetworkSurvey.h>
+#include <Discovery.h>
+#include <StatusApi.h>
+#include <TaskMonitor.h>
+#include <TaskRuntime.h>
+#include <Rtcm.h>
+#include <LocalCaster.h>
+#include <CasterFanout.h>
+#include <RtcmScheduler.h>
+#include <Recorder.h>
+#include <Simulation.h>
+#include <GnssUart.h>
+#include <TimeSeries.h>
+#include <BootGuard.h>
+#include <FlashBudget.h>
+#include <esp_system.h>
 
 using namespace aunit;
 using namespace RTKBaseManager;
@@ -54,6 +74,40 @@ test(getDoubleStringFromCSV) {
     assertTrue (testStr.equals(doubleStr));
 }
 
+test(formatCSVFixedPoint) {
+    bool success = true;
+    char buf[CSV_NUMBER_MAX_LEN + 1];
+    formatCSVFixedPoint("123456789,99", 9, buf, sizeof(buf));
+    success &= strcmp(buf, "12.345678999") == 0;
+    // Altitude: cm and 0.1 mm
+    formatCSVFixedPoint("123456,70", 4, buf, sizeof(buf));
+    success &= strcmp(buf, "1234.5670") == 0;
+    formatCSVFixedPoint("-1,0", 9, buf, sizeof(buf));
+    success &= strcmp(buf, "-0.000000100") == 0;
+    success &= formatCSVFixedPoint("", 9, buf, sizeof(buf)) == 0 && buf[0] == '\0';
+    assertTrue(success);
+}
+
+test(getAltitudeAsCSV) {
+    bool success = true;
+    char buf[CSV_NUMBER_MAX_LEN + 1];
+    const param_entry_t* param = &PARAM_TABLE[findParam(PARAM_RTK_LOCATION_ALTITUDE)];
+    success &= getAltitudeAsCSV("520.1234").equals("52012,34");
+    formatCSVFixedPoint("52012,34", 4, buf, sizeof(buf));
+    success &= strcmp(buf, "520.1234") == 0;
+    success &= getAltitudeAsCSV("-12.3456").equals("-1234,-56");
+    formatCSVFixedPoint("-1234,-56", 4, buf, sizeof(buf));
+    success &= strcmp(buf, "-12.3456") == 0;
+    success &= getAltitudeAsCSV("8848").equals("884800,0");
+    // One unit from the form to the receiver: m with up to 4 post dot digits
+    success &= checkParamValue(param, "520.1234", 8) == FORM_OK;
+    success &= checkParamValue(param, "-500", 4) == FORM_OK;
+    success &= checkParamValue(param, "9000.0000", 9) == FORM_OK;
+    success &= checkParamValue(param, "9000.1", 6) == FORM_ERR_RANGE;
+    success &= checkParamValue(param, "520.12345", 9) == FORM_ERR_FORMAT;
+    assertTrue(success);
+}
+
 test(getValueAsStringFromCSV) {
     bool result = true;
     String csv = "123456789,99";
@@ -62,7 +116,7 @@ test(getValueAsStringFromCSV) {
     assertTrue(result);
 }
 
-test(getIntLocationFromSPIFFS) {
+test(getIntLocationFromStorage) {
     bool success = true;
     location_int_t location;
     const int32_t lowerPrec = 123456789;
@@ -72,16 +126,16 @@ test(getIntLocationFromSPIFFS) {
     const char* testPathLon = "/testPathLon";
     const char* testPathAlt = "/testPathAlt";
 
-    if (SPIFFS.exists(testPathLat)) SPIFFS.remove(testPathLat);
-    if (SPIFFS.exists(testPathLon)) SPIFFS.remove(testPathLon);
-    if (SPIFFS.exists(testPathAlt)) SPIFFS.remove(testPathAlt);
+    removeStored(testPathLat);
+    removeStored(testPathLon);
+    removeStored(testPathAlt);
    
     String deconstructedValAsCSV = getDeconstructedValAsCSV(doubleValStr);
-    success &= writeFile(SPIFFS, testPathLat, deconstructedValAsCSV.c_str());
-    success &= writeFile(SPIFFS, testPathLon, deconstructedValAsCSV.c_str());
-    success &= writeFile(SPIFFS, testPathAlt, deconstructedValAsCSV.c_str());
+    success &= writeStored(testPathLat, deconstructedValAsCSV.c_str());
+    success &= writeStored(testPathLon, deconstructedValAsCSV.c_str());
+    success &= writeStored(testPathAlt, deconstructedValAsCSV.c_str());
 
-    success &= getIntLocationFromSPIFFS(&location, testPathLat, testPathLon, testPathAlt);
+    success &= getIntLocationFromStorage(&location, testPathLat, testPathLon, testPathAlt);
     success &= location.lat == lowerPrec;
     success &= location.lon == lowerPrec;
     success &= location.alt == lowerPrec;
@@ -89,6 +143,433 @@ test(getIntLocationFromSPIFFS) {
     success &= location.lon_hp == highPrec;
     success &= location.alt_hp == highPrec;
 
+    removeStored(testPathLat);
+    removeStored(testPathLon);
+    removeStored(testPathAlt);
+    assertTrue(success);
+}
+
+test(nvsKeyFromPath) {
+    bool success = true;
+    char key[NVS_KEY_MAX_LEN + 1];
+    nvsKeyFromPath(PATH_RTK_LOCATION_METHOD, key);
+    success &= strcmp(key, "location_method") == 0;
+    nvsKeyFromPath(PATH_RTK_CASTER_HOST, key);
+    success &= strcmp(key, "caster_host") == 0;
+    // Too long for NVS, cut and hashed
+    nvsKeyFromPath("/a_very_long_path_name.txt", key);
+    success &= strlen(key) == NVS_KEY_MAX_LEN && strncmp(key, "a_very~", 7) == 0;
+    assertTrue(success);
+}
+
+test(assetPage) {
+    bool success = true;
+    asset_t asset;
+    mountAssets();
+    if (assetsMounted() && findAsset(ASSET_INDEX, &asset)) {
+        // Templates are used as C strings in place
+        success &= asset.data[asset.len] == '\0';
+        success &= assetPage(ASSET_INDEX, INDEX_HTML) == (const char*)asset.data;
+    } else {
+        success &= assetPage(ASSET_INDEX, INDEX_HTML) == INDEX_HTML;
+    }
+    success &= !findAsset("missing.html", &asset);
+    assertTrue(success);
+}
+
+test(getNetworks_Sorted) {
+    bool success = true;
+    network_entry_t networks[MAX_SSIDS];
+    network_entry_t network;
+    uint8_t count = getNetworks(networks);
+    for (uint8_t i = 1; i < count; i++) {
+        success &= networks[i - 1].rssi >= networks[i].rssi;
+    }
+    // Hidden networks are not kept
+    success &= !findNetwork("", &network);
+    assertTrue(success);
+}
+
+test(surveyState) {
+    bool success = true;
+    config_snapshot_t config;
+    memset(&config, 0, sizeof(config));
+    success &= strcmp(surveyState(&config), SURVEY_STATE_NONE) == 0;
+    strcpy(config.values[findParam(PARAM_RTK_LOCATION_METHOD)], PARAM_RTK_SURVEY_ENABLED);
+    success &= strcmp(surveyState(&config), SURVEY_STATE_PENDING) == 0;
+    config.hasLocation = true;
+    success &= strcmp(surveyState(&config), SURVEY_STATE_DONE) == 0;
+    strcpy(config.values[findParam(PARAM_RTK_LOCATION_METHOD)], PARAM_RTK_COORDS_ENABLED);
+    success &= strcmp(surveyState(&config), SURVEY_STATE_FIXED) == 0;
+    assertTrue(success);
+}
+
+test(encodeConfig_Windowed) {
+    bool success = true;
+    config_snapshot_t config;
+    readConfig(&config);
+    cbor_writer_t writer;
+    uint8_t full[1024];
+    cborBegin(&writer, full, 0, sizeof(full));
+    encodeConfig(&writer, &config);
+    size_t total = writer.len;
+    success &= total <= sizeof(full) && full[0] == 0xA3;   // map of 3 pairs
+
+    // Odd window sizes cut through heads and strings, the result must not change
+    uint8_t chunked[1024];
+    size_t index = 0;
+    while (success && index < total) {
+        cborBegin(&writer, chunked + index, index, 7);
+        encodeConfig(&writer, &config);
+        size_t n = cborWindowLength(&writer);
+        success &= n > 0;
+        index += n;
+    }
+    success &= memcmp(full, chunked, total) == 0;
+    assertTrue(success);
+}
+
+test(encodeStatus_AsciiUrl) {
+    bool success = true;
+    status_snapshot_t status;
+    memset(&status, 0, sizeof(status));
+    status.requestCount = 1;
+    strcpy(status.requests[0].url, "/a\xC3\xA9\x01b");
+    cbor_writer_t writer;
+    uint8_t out[512];
+    cborBegin(&writer, out, 0, sizeof(out));
+    encodeStatus(&writer, &status);
+    success &= writer.len <= sizeof(out);
+    // Text string of 6 bytes, the UTF-8 pair and the control byte masked
+    const uint8_t expected[] = { 0x66, '/', 'a', '?', '?', '?', 'b' };
+    bool found = false;
+    for (size_t i = 0; success && i + sizeof(expected) <= writer.len; i++) {
+        found |= memcmp(out + i, expected, sizeof(expected)) == 0;
+    }
+    success &= found;
+    for (size_t i = 0; success && i < writer.len; i++) success &= out[i] != 0xC3;
+    assertTrue(success);
+}
+
+test(acceptQuality) {
+    bool success = true;
+    success &= acceptQuality("application/cbor", MIME_CBOR) == 1000;
+    success &= acceptQuality("text/html, application/CBOR;q=0.5", MIME_CBOR) == 500;
+    success &= acceptQuality("application/cbor;q=0", MIME_CBOR) == 0;
+    success &= acceptQuality("application/cbor; charset=x ;q=0.000", MIME_CBOR) == 0;
+    // Other types, longer names and wildcards do not count
+    success &= acceptQuality("application/cbor-seq, */*", MIME_CBOR) == 0;
+    success &= acceptQuality("application/json;q=0.9,application/cbor;q=0.8", "application/json") == 900;
+    success &= acceptQuality("", MIME_CBOR) == 0;
+    assertTrue(success);
+}
+
+test(getTaskStats_LoopTask) {
+    bool found = false;
+    task_stats_t stats[TASK_MONITOR_MAX_TASKS];
+    task_interval_t interval;
+    uint8_t count = getTaskStats(stats, &interval);
+    for (uint8_t i = 0; i < count; i++) {
+        // The tests run in the loop task
+        if (strcmp(stats[i].name, "loopTask") == 0) found = stats[i].stackFree > 0;
+        if (i > 0 && stats[i - 1].samples < stats[i].samples) found = false;
+    }
+    assertTrue(found);
+}
+
+test(checkParamValue_Profile) {
+    bool success = true;
+    const param_entry_t* param = &PARAM_TABLE[findParam(PARAM_TASK_PROFILE)];
+    for (size_t i = 0; i < RUNTIME_PROFILE_COUNT; i++) {
+        const char* name = RUNTIME_PROFILES[i].name;
+        success &= checkParamValue(param, name, strlen(name)) == FORM_OK;
+        success &= findRuntimeProfile(name) == &RUNTIME_PROFILES[i];
+    }
+    success &= checkParamValue(param, "fast", 4) == FORM_ERR_FORMAT;
+    success &= activeRuntimeProfile() != nullptr;
+    assertTrue(success);
+}
+
+test(feedFramer_Chunked) {
+    bool success = crc24q((const uint8_t*)"123456789", 9) == 0xCDE703;
+
+    // 1005 frame with a 19 byte payload
+    uint8_t frame[25] = { RTCM_PREAMBLE, 0, 19, 1005 >> 4, (1005 & 0x0F) << 4 };
+    for (uint8_t i = 5; i < 22; i++) frame[i] = i;
+    uint32_t crc = crc24q(frame, 22);
+    frame[22] = crc >> 16; frame[23] = crc >> 8; frame[24] = crc;
+
+    // Noise with a false preamble, a valid, a damaged and a valid frame
+    uint8_t stream[3 + 3 * sizeof(frame)] = { 0x11, RTCM_PREAMBLE, 0xFF };
+    for (uint8_t i = 0; i < 3; i++) memcpy(stream + 3 + i * sizeof(frame), frame, sizeof(frame));
+    stream[3 + sizeof(frame) + 10] ^= 0x01;
+
+    rtcm_framer_t framer;
+    memset(&framer, 0, sizeof(framer));
+    uint8_t found = 0;
+    for (size_t pos = 0; pos < sizeof(stream); pos += 7) {
+        size_t len = (sizeof(stream) - pos < 7) ? sizeof(stream) - pos : 7;
+        size_t used = 0;
+        while (used < len) {
+            rtcm_frame_t* out;
+            used += feedFramer(&framer, stream + pos + used, len - used, &out);
+            if (out == nullptr) continue;
+            success &= out->type == 1005 && out->len == sizeof(frame) && memcmp(out->data, frame, sizeof(frame)) == 0;
+            releaseFrame(out);
+            found++;
+        }
+    }
+    success &= found == 2 && framer.crcErrors == 1;
+    beginFramer(&framer);
+    assertTrue(success);
+}
+
+test(backoffDelayMs) {
+    bool success = true;
+    uint32_t step = CASTER_BACKOFF_MIN_MS;
+    for (uint8_t failures = 1; failures < 20; failures++) {
+        // Lowest and highest jitter stay within half and all of the step
+        success &= backoffDelayMs(failures, 0) == step / 2;
+        success &= backoffDelayMs(failures, step / 2) == step;
+        success &= backoffDelayMs(failures, esp_random()) <= CASTER_BACKOFF_MAX_MS;
+        step = (2 * step < CASTER_BACKOFF_MAX_MS) ? 2 * step : CASTER_BACKOFF_MAX_MS;
+    }
+    success &= backoffDelayMs(UINT8_MAX, 0) == CASTER_BACKOFF_MAX_MS / 2;
+    assertTrue(success);
+}
+
+static rtcm_frame_t scheduledFrame;
+
+// MSM header only: type, station 0, epoch time and the multiple message bit
+static const rtcm_frame_t* msmFrame(uint16_t type, uint32_t epochMs, bool more) {
+    uint8_t* payload = scheduledFrame.data + RTCM_HEADER_LEN;
+    memset(payload, 0, 8);
+    payload[0] = type >> 4;
+    payload[1] = (type & 0x0F) << 4;
+    payload[3] = epochMs >> 22;
+    payload[4] = epochMs >> 14;
+    payload[5] = epochMs >> 6;
+    payload[6] = ((epochMs & 0x3F) << 2) | (more ? 0x02 : 0);
+    scheduledFrame.type = type;
+    scheduledFrame.len = RTCM_HEADER_LEN + 8 + RTCM_CRC_LEN;
+    return &scheduledFrame;
+}
+
+test(scheduleFrame_EpochConsistent) {
+    bool success = true;
+    rate_schedule_t schedule;
+    success &= parseRates(&schedule, RTCM_RATES_ALL) && schedule.count == 0;
+    success &= !parseRates(&schedule, "1005:") && !parseRates(&schedule, "1005:1,") && !parseRates(&schedule, "msm9:1");
+    success &= parseRates(&schedule, "1005:10,msm7:2,msm4:0") && schedule.count == 3;
+
+    uint8_t gps = 0, glonass = 0, msm4 = 0, stations = 0;
+    for (uint32_t epoch = 0; epoch < 10; epoch++) {
+        uint32_t ms = 100000 + epoch * 1000;
+        gps += scheduleFrame(&schedule, msmFrame(1077, ms, true));
+        msm4 += scheduleFrame(&schedule, msmFrame(1074, ms, true));
+        // Last message of the epoch, GLONASS has its own time of day
+        glonass += scheduleFrame(&schedule, msmFrame(1087, ms + 10782000, false));
+        scheduledFrame.type = 1005;
+        scheduledFrame.receivedMs = ms + ((epoch % 2) ? 30 : -30);
+        stations += scheduleFrame(&schedule, &scheduledFrame);
+    }
+    success &= gps == 5 && glonass == 5 && msm4 == 0 && stations == 1;
+    success &= schedule.bytesDropped > schedule.bytesPassed;
+    assertTrue(success);
+}
+
+test(buildSourcetable) {
+    bool success = true;
+    config_snapshot_t config;
+    memset(&config, 0, sizeof(config));
+    success &= strcmp(localMountPoint(&config), DEVICE_NAME) == 0;
+    strcpy(config.values[findParam(PARAM_RTK_MOINT_POINT)], "BASE1");
+    success &= strcmp(localMountPoint(&config), "BASE1") == 0;
+    config.hasLocation = true;
+    config.location.lat = 521234567;
+    config.location.lon = -131234567;
+
+    char reply[SOURCETABLE_MAX_LEN + 160];
+    size_t len = buildSourcetable(reply, sizeof(reply), localMountPoint(&config), &config);
+    success &= len == strlen(reply);
+    success &= strncmp(reply, "SOURCETABLE 200 OK\r\n", 20) == 0;
+    success &= strstr(reply, "STR;BASE1;") != nullptr && strstr(reply, ";52.12;-13.12;") != nullptr;
+    success &= strcmp(reply + len - 16, "ENDSOURCETABLE\r\n") == 0;
+    // Content-Length covers the STR record and the end line
+    const char* body = strstr(reply, "\r\n\r\n") + 4;
+    success &= atoi(strstr(reply, "Content-Length: ") + 16) == (int)strlen(body);
+    success &= buildSourcetable(reply, 64, "BASE1", &config) == 0;
+    assertTrue(success);
+}
+
+test(seekRecordIndex) {
+    bool success = true;
+    record_index_entry_t index[RECORD_INDEX_LEN];
+    memset(index, 0xFF, sizeof(index));
+    success &= seekRecordIndex(index, RECORD_INDEX_LEN, 5000) == RECORD_DATA_OFFSET;
+    // Ten entries, one per second, the rest still erased
+    for (uint8_t i = 0; i < 10; i++) {
+        index[i].timeMs = 10000 + i * 1000;
+        index[i].offset = RECORD_DATA_OFFSET + i * RECORD_INDEX_STRIDE;
+    }
+    success &= seekRecordIndex(index, RECORD_INDEX_LEN, 9999) == RECORD_DATA_OFFSET;
+    success &= seekRecordIndex(index, RECORD_INDEX_LEN, 10000) == index[0].offset;
+    success &= seekRecordIndex(index, RECORD_INDEX_LEN, 13500) == index[3].offset;
+    success &= seekRecordIndex(index, RECORD_INDEX_LEN, 14000) == index[4].offset;
+    success &= seekRecordIndex(index, RECORD_INDEX_LEN, 60000) == index[9].offset;
+    assertTrue(success);
+}
+
+test(seriesRollup) {
+    bool success = true;
+    series_accumulator_t acc;
+    series_rollup_t rollup;
+    memset(&acc, 0, sizeof(acc));
+    closeRollup(&acc, &rollup);
+    success &= rollup.min == SERIES_NO_VALUE && rollup.mean == SERIES_NO_VALUE && rollup.max == SERIES_NO_VALUE;
+    accumulateSample(&acc, -71);
+    accumulateSample(&acc, SERIES_NO_VALUE);
+    accumulateSample(&acc, -64);
+    accumulateSample(&acc, -80);
+    closeRollup(&acc, &rollup);
+    success &= rollup.min == -80 && rollup.mean == -72 && rollup.max == -64 && acc.count == 0;
+    // Cursor: new points only, the oldest still in the ring, a cursor of the last boot
+    uint32_t first;
+    success &= seriesWindow(10, 60, 0, &first) == 10 && first == 0;
+    success &= seriesWindow(10, 60, 10, &first) == 0 && first == 10;
+    success &= seriesWindow(100, 60, 7, &first) == SERIES_PAGE_POINTS && first == 40;
+    success &= seriesWindow(100, 60, 95, &first) == 5 && first == 95;
+    success &= seriesWindow(100, 60, 500, &first) == SERIES_PAGE_POINTS && first == 40;
+    assertTrue(success);
+}
+
+test(needsSafeMode) {
+    bool success = true;
+    success &= !needsSafeMode(0, ESP_RST_PANIC);
+    success &= !needsSafeMode(BOOT_SAFE_MODE_FAILURES - 1, ESP_RST_TASK_WDT);
+    success &= needsSafeMode(BOOT_SAFE_MODE_FAILURES, ESP_RST_PANIC);
+    success &= needsSafeMode(BOOT_SAFE_MODE_FAILURES, ESP_RST_SW);
+    // A power cycle always boots normally
+    success &= !needsSafeMode(UINT8_MAX, ESP_RST_POWERON);
+    assertTrue(success);
+}
+
+test(flashBudget) {
+    bool success = true;
+    flash_hour_t hour;
+    memset(&hour, 0, sizeof(hour));
+    success &= flashWriteCost(10) == 10 + FLASH_WRITE_OVERHEAD;
+    success &= withinFlashBudget(&hour, FLASH_BUDGET_BYTES);
+    success &= !withinFlashBudget(&hour, FLASH_BUDGET_BYTES + 1);
+    hour.writes = FLASH_BUDGET_WRITES;
+    success &= !withinFlashBudget(&hour, 1);
+    // 5 sectors, 100 erases a day: 5e5 cycles last 5000 days
+    success &= flashLifetimeYears(5, 100, 24) == 13;
+    success &= flashLifetimeYears(5, 0, 24) == UINT32_MAX;
+    assertTrue(success);
+}
+
+test(countBurst) {
+    bool success = true;
+    uart_burst_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+    success &= burstBucket(0) == 0 && burstBucket(63) == 0 && burstBucket(64) == 1;
+    success &= burstBucket(4095) == UART_BURST_BUCKETS - 2 && burstBucket(100000) == UART_BURST_BUCKETS - 1;
+    countBurst(&stats, 1200, true);
+    countBurst(&stats, 4096, false);
+    countBurst(&stats, 300, true);
+    success &= stats.bursts == 3 && stats.bytes == 5596 && stats.splits == 1;
+    success &= stats.maxBurst == 4096 && stats.lastBurst == 300;
+    success &= stats.sizes[5] == 1 && stats.sizes[7] == 1 && stats.sizes[3] == 1;
+    assertTrue(success);
+}
+
+test(parseTimeline) {
+    bool success = true;
+    sim_timeline_t timeline;
+    success &= parseTimeline(&timeline, SIM_TIMELINE);
+    success &= timeline.count == 7 && timeline.events[6].action == SIM_END;
+    success &= timeline.events[2].action == SIM_STALL && timeline.events[2].caster == 1 && timeline.events[2].atMs == 60000;
+    success &= strcmp(timeline.events[4].form, "rtcm_rates=msm7:1,1005:10,1230:10") == 0;
+    // Unknown action, caster out of range, time going back, no end
+    success &= !parseTimeline(&timeline, "0 reboot\n10 end\n") && timeline.count == 0;
+    success &= !parseTimeline(&timeline, "0 drop 3\n10 end\n");
+    success &= !parseTimeline(&timeline, "10 drop 0\n5 end\n");
+    success &= !parseTimeline(&timeline, "0 drop 0\n");
+    success &= !parseTimeline(&timeline, "0 end\n10 drop 0\n");
+    assertTrue(success);
+}
+
+test(findParam) {
+    bool success = true;
+    for (size_t i = 0; i < PARAM_COUNT; i++) {
+        success &= findParam(PARAM_TABLE[i].name) == (int8_t)i;
+    }
+    success &= findParam("wipe_button") == PARAM_NONE;
+    success &= findParam("") == PARAM_NONE;
+    assertTrue(success);
+}
+
+test(feedForm_Chunked) {
+    bool success = true;
+    const char* body = "ssid=My+Net%21&latitude=52.1234567&save_button=Save";
+    form_parser_t form;
+    beginForm(&form);
+    // Split every 3 bytes, also inside the percent escape
+    size_t len = strlen(body);
+    for (size_t i = 0; i < len; i += 3) {
+        success &= feedForm(&form, (const uint8_t*)body + i, (len - i < 3) ? len - i : 3);
+    }
+    success &= endForm(&form);
+    success &= strcmp(form.values[findParam(PARAM_WIFI_SSID)], "My Net!") == 0;
+    success &= strcmp(form.values[findParam(PARAM_RTK_LOCATION_LATITUDE)], "52.1234567") == 0;
+    assertTrue(success);
+}
+
+test(endForm_RejectsInvalid) {
+    form_parser_t form;
+    const char* body = "latitude=52.12&caster_port=2101";
+    beginForm(&form);
+    feedForm(&form, (const uint8_t*)body, strlen(body));
+    assertFalse(endForm(&form));
+    assertEqual(form.error, FORM_ERR_FORMAT);
+    assertEqual(form.errorField, findParam(PARAM_RTK_LOCATION_LATITUDE));
+}
+
+static volatile bool seqlockStressRunning;
+// Not the live config, the casters and the page must never see the marks
+static Seqlock<config_snapshot_t> stressConfig;
+
+static void seqlockStressWriter(void* arg) {
+    config_snapshot_t next;
+    uint32_t n = 0;
+    while (seqlockStressRunning) {
+        // Every byte of a snapshot carries the same mark, a torn read mixes marks
+        memset(&next, 'a' + (n++ % 26), sizeof(next));
+        stressConfig.write(&next, &next.version);
+    }
+    vTaskDelete(NULL);
+}
+
+test(seqlock_NoTornReads) {
+    bool success = true;
+    config_snapshot_t config;
+    seqlockStressRunning = true;
+    // Writer on the other core, so reads and writes really overlap
+    xTaskCreatePinnedToCore(seqlockStressWriter, "seqStress", 4096, NULL, 1, NULL, 0);
+
+    uint32_t lastVersion = 0;
+    for (uint32_t i = 0; i < 20000; i++) {
+        stressConfig.read(&config);
+        char mark = config.values[0][0];
+        for (uint8_t p = 0; p < PARAM_COUNT; p++) {
+            success &= config.values[p][0] == mark && config.values[p][CONFIG_VALUE_MAX_LEN] == mark;
+        }
+        success &= config.version >= lastVersion;
+        lastVersion = config.version;
+    }
+    seqlockStressRunning = false;
+    delay(10);
     assertTrue(success);
 }
 
@@ -0,0 +1,199 @@
+#include <TimeSeries.h>
+#include <RtcmScheduler.h>
+#include <TaskRuntime.h>
+#include <WiFi.h>
+
+using RTKBaseManager::series_accumulator_t;
+using RTKBaseManager::series_rollup_t;
+
+/********************************************************************************
+*                             Rings
+* ******************************************************************************/
+
+static const char* const METRIC_NAMES[RTKBaseManager::SERIES_COUNT] = { "satellites", "rtcm_bps", "rssi" };
+static const char* const TIER_NAMES[RTKBaseManager::SERIES_TIER_COUNT] = { "raw", "1m", "10m" };
+static const uint32_t TIER_INTERVAL_MS[RTKBaseManager::SERIES_TIER_COUNT] = { SERIES_RAW_INTERVAL_MS, 60000, 600000 };
+static const uint16_t TIER_LEN[RTKBaseManager::SERIES_TIER_COUNT] = { SERIES_RAW_LEN, SERIES_MINUTE_LEN, SERIES_TEN_MINUTE_LEN };
+static const uint16_t RAW_PER_MINUTE = 60000 / SERIES_RAW_INTERVAL_MS;
+static const uint16_t RAW_PER_TEN_MINUTES = 10 * RAW_PER_MINUTE;
+
+static int16_t raw[RTKBaseManager::SERIES_COUNT][SERIES_RAW_LEN];
+static series_rollup_t minutes[RTKBaseManager::SERIES_COUNT][SERIES_MINUTE_LEN];
+static series_rollup_t tenMinutes[RTKBaseManager::SERIES_COUNT][SERIES_TEN_MINUTE_LEN];
+static uint32_t nextPoint[RTKBaseManager::SERIES_TIER_COUNT];     // sequence of the next point per tier
+static uint32_t startMs = 0;                                      // uptime the sequences count from
+static portMUX_TYPE seriesMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t seriesTask = nullptr;
+
+// Owned by the sampling task
+static series_accumulator_t minuteAcc[RTKBaseManager::SERIES_COUNT];
+static series_accumulator_t tenMinuteAcc[RTKBaseManager::SERIES_COUNT];
+static uint32_t seenEpochs = 0;
+static uint32_t seenBytes = 0;
+
+// Written by the ingest task
+static uint8_t epochSatellites = 0;
+static volatile uint8_t lastEpochSatellites = 0;
+static volatile uint32_t epochs = 0;
+static volatile uint32_t frameBytes = 0;
+
+void RTKBaseManager::accumulateSample(series_accumulator_t* acc, int16_t value) {
+  if (value == SERIES_NO_VALUE) return;
+  if (acc->count == 0 || value < acc->min) acc->min = value;
+  if (acc->count == 0 || value > acc->max) acc->max = value;
+  acc->sum += value;
+  acc->count++;
+}
+
+void RTKBaseManager::closeRollup(series_accumulator_t* acc, series_rollup_t* rollup) {
+  if (acc->count == 0) {
+    rollup->min = rollup->mean = rollup->max = SERIES_NO_VALUE;
+  } else {
+    rollup->min = acc->min;
+    rollup->mean = (acc->sum >= 0) ? (acc->sum + acc->count / 2) / acc->count : (acc->sum - acc->count / 2) / acc->count;
+    rollup->max = acc->max;
+  }
+  memset(acc, 0, sizeof(series_accumulator_t));
+}
+
+uint32_t RTKBaseManager::seriesWindow(uint32_t next, uint16_t len, uint32_t since, uint32_t* first) {
+  uint32_t oldest = (next > len) ? next - len : 0;
+  // A cursor ahead of the ring is from before a reboot, start over
+  *first = (since < oldest || since > next) ? oldest : since;
+  uint32_t count = next - *first;
+  return (count < SERIES_PAGE_POINTS) ? count : SERIES_PAGE_POINTS;
+}
+
+void RTKBaseManager::seriesFrame(const rtcm_frame_t* frame) {
+  frameBytes += frame->len;
+  if (msmLevel(frame->type) == 0 || frame->len < RTCM_HEADER_LEN + 7 + RTCM_CRC_LEN) return;
+  epochSatellites += msmSatellites(frame);
+  // Multiple message bit 54, the last MSM of the epoch closes it
+  if (((frame->data[RTCM_HEADER_LEN + 6] >> 1) & 1) == 0) {
+    lastEpochSatellites = epochSatellites;
+    epochs++;
+    epochSatellites = 0;
+  }
+}
+
+/********************************************************************************
+*                             Sampling task
+* ******************************************************************************/
+
+static void takeSample(int16_t* values) {
+  using namespace RTKBaseManager;
+  uint32_t e = epochs;
+  values[SERIES_SATELLITES] = (e != seenEpochs) ? lastEpochSatellites : SERIES_NO_VALUE;
+  seenEpochs = e;
+
+  uint32_t bytes = frameBytes;
+  uint32_t bps = (bytes - seenBytes) * 1000 / SERIES_RAW_INTERVAL_MS;
+  values[SERIES_RTCM_BPS] = (bps < INT16_MAX) ? bps : INT16_MAX;
+  seenBytes = bytes;
+
+  values[SERIES_RSSI] = (WiFi.status() == WL_CONNECTED) ? WiFi.RSSI() : SERIES_NO_VALUE;
+}
+
+static void appendSample(const int16_t* values) {
+  using namespace RTKBaseManager;
+  series_rollup_t minute[SERIES_COUNT];
+  series_rollup_t tenMinute[SERIES_COUNT];
+  uint32_t seq = nextPoint[SERIES_TIER_RAW];
+  bool closeMinute = (seq + 1) % RAW_PER_MINUTE == 0;
+  bool closeTenMinutes = (seq + 1) % RAW_PER_TEN_MINUTES == 0;
+  for (uint8_t m = 0; m < SERIES_COUNT; m++) {
+    accumulateSample(&minuteAcc[m], values[m]);
+    accumulateSample(&tenMinuteAcc[m], values[m]);
+    if (closeMinute) closeRollup(&minuteAcc[m], &minute[m]);
+    if (closeTenMinutes) closeRollup(&tenMinuteAcc[m], &tenMinute[m]);
+  }
+
+  portENTER_CRITICAL(&seriesMux);
+  for (uint8_t m = 0; m < SERIES_COUNT; m++) {
+    raw[m][seq % SERIES_RAW_LEN] = values[m];
+    if (closeMinute) minutes[m][nextPoint[SERIES_TIER_MINUTE] % SERIES_MINUTE_LEN] = minute[m];
+    if (closeTenMinutes) tenMinutes[m][nextPoint[SERIES_TIER_TEN_MINUTES] % SERIES_TEN_MINUTE_LEN] = tenMinute[m];
+  }
+  nextPoint[SERIES_TIER_RAW]++;
+  if (closeMinute) nextPoint[SERIES_TIER_MINUTE]++;
+  if (closeTenMinutes) nextPoint[SERIES_TIER_TEN_MINUTES]++;
+  portEXIT_CRITICAL(&seriesMux);
+}
+
+static void seriesLoop(void* parameter) {
+  TickType_t wake = xTaskGetTickCount();
+  while (true) {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(SERIES_RAW_INTERVAL_MS));
+    int16_t values[RTKBaseManager::SERIES_COUNT];
+    takeSample(values);
+    appendSample(values);
+  }
+}
+
+void RTKBaseManager::startTimeSeries() {
+  if (seriesTask != nullptr) return;
+  startMs = millis();
+  seenBytes = frameBytes;
+  spawnTask(TASK_ROLE_BACKGROUND, seriesLoop, "timeSeries", 3072, nullptr, &seriesTask);
+}
+
+/********************************************************************************
+*                             API
+* ******************************************************************************/
+
+static size_t appendValue(char* json, size_t size, size_t len, int16_t value) {
+  if (len >= size) return len;
+  if (value == RTKBaseManager::SERIES_NO_VALUE) return len + snprintf(json + len, size - len, "null");
+  return len + snprintf(json + len, size - len, "%d", value);
+}
+
+void RTKBaseManager::actionSeries(AsyncWebServerRequest *request) {
+  uint8_t tier = SERIES_TIER_MINUTE;
+  if (request->hasParam("tier")) {
+    String name = request->getParam("tier")->value();
+    for (tier = 0; tier < SERIES_TIER_COUNT && !name.equals(TIER_NAMES[tier]); tier++) {}
+    if (tier == SERIES_TIER_COUNT) {
+      request->send(400, "text/plain", "tier must be raw, 1m or 10m");
+      return;
+    }
+  }
+  uint32_t since = request->hasParam("since") ? strtoul(request->getParam("since")->value().c_str(), nullptr, 10) : 0;
+
+  // Copy the page out, the sampling task goes on meanwhile
+  series_rollup_t points[SERIES_COUNT][SERIES_PAGE_POINTS];
+  uint32_t first;
+  portENTER_CRITICAL(&seriesMux);
+  uint32_t next = nextPoint[tier];
+  uint32_t count = seriesWindow(next, TIER_LEN[tier], since, &first);
+  for (uint8_t m = 0; m < SERIES_COUNT; m++) {
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t seq = first + i;
+      if (tier == SERIES_TIER_RAW) points[m][i].mean = raw[m][seq % SERIES_RAW_LEN];
+      else if (tier == SERIES_TIER_MINUTE) points[m][i] = minutes[m][seq % SERIES_MINUTE_LEN];
+      else points[m][i] = tenMinutes[m][seq % SERIES_TEN_MINUTE_LEN];
+    }
+  }
+  portEXIT_CRITICAL(&seriesMux);
+
+  // Point i ends at start_ms + (first + i + 1) * interval_ms
+  char json[SERIES_COUNT * SERIES_PAGE_POINTS * 22 + 256];
+  size_t len = snprintf(json, sizeof(json),
+                        "{\"tier\":\"%s\",\"interval_ms\":%u,\"start_ms\":%u,\"uptime_ms\":%u,\"first\":%u,\"next\":%u,\"more\":%s,\"series\":{",
+                        TIER_NAMES[tier], (unsigned int)TIER_INTERVAL_MS[tier], (unsigned int)startMs, (unsigned int)millis(),
+                        (unsigned int)first, (unsigned int)(first + count), (first + count < next) ? "true" : "false");
+  for (uint8_t m = 0; m < SERIES_COUNT && len < sizeof(json); m++) {
+    len += snprintf(json + len, sizeof(json) - len, "%s\"%s\":[", (m == 0) ? "" : ",", METRIC_NAMES[m]);
+    for (uint32_t i = 0; i < count && len < sizeof(json); i++) {
+      const series_rollup_t& p = points[m][i];
+      if (i > 0) len += snprintf(json + len, sizeof(json) - len, ",");
+      if (tier == SERIES_TIER_RAW || p.mean == SERIES_NO_VALUE) {
+        len = appendValue(json, sizeof(json), len, p.mean);
+        continue;
+      }
+      len += snprintf(json + len, sizeof(json) - len, "[%d,%d,%d]", p.min, p.mean, p.max);
+    }
+    if (len < sizeof(json)) len += snprintf(json + len, sizeof(json) - len, "]");
+  }
+  if (len < sizeof(json)) snprintf(json + len, sizeof(json) - len, "}}");
+  request->send(200, "application/json", json);
+}
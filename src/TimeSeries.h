@@ -0,0 +1,109 @@
+/**
+ * @file    TimeSeries.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Charts of the base over the last hours in a fixed amount of RAM.
+ *          A background task samples every SERIES_RAW_INTERVAL_MS the
+ *          satellites of the last MSM epoch, the RTCM rate of the receiver
+ *          and the WiFi RSSI. The samples go into three rings of every
+ *          metric: the raw samples, min/mean/max per minute and min/mean/max
+ *          per ten minutes. The rings never grow, the memory is the same
+ *          after a day as after a minute.
+ *
+ *          Every point has a sequence number per tier, counting from the
+ *          start of the task. A client keeps the "next" of the answer and
+ *          asks with since=<next> for the new points only:
+ *
+ *          GET /api/series?tier=raw|1m|10m&since=<sequence>
+ */
+
+#ifndef TIME_SERIES_H
+#define TIME_SERIES_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <RTKBaseManager.h>
+#include <Rtcm.h>
+
+namespace RTKBaseManager {
+  const int16_t SERIES_NO_VALUE = INT16_MIN;    // not measured, e.g. the RSSI in AP mode
+  const uint8_t SERIES_PAGE_POINTS = 30;        // per answer, the rest with the next cursor
+
+typedef enum {
+  SERIES_SATELLITES,    // in the MSM of the last epoch, all constellations
+  SERIES_RTCM_BPS,      // bytes per second of valid frames from the receiver
+  SERIES_RSSI,          // dBm of the station connection
+  SERIES_COUNT
+} series_metric_t;
+
+typedef enum {
+  SERIES_TIER_RAW,
+  SERIES_TIER_MINUTE,
+  SERIES_TIER_TEN_MINUTES,
+  SERIES_TIER_COUNT
+} series_tier_t;
+
+typedef struct {
+  int16_t min;
+  int16_t mean;
+  int16_t max;
+} series_rollup_t;
+
+typedef struct {
+  int32_t  sum;
+  int16_t  min;
+  int16_t  max;
+  uint16_t count;       // samples with a value
+} series_accumulator_t;
+
+  /**
+   * @brief Start the sampling task
+   */
+  void startTimeSeries(void);
+
+  /**
+   * @brief Count a frame of the receiver, runs on the ingest task
+   *
+   * @param frame Complete frame
+   */
+  void seriesFrame(const rtcm_frame_t* frame);
+
+  /**
+   * @brief Add a sample to a rollup, SERIES_NO_VALUE is skipped
+   *
+   * @param acc     Accumulator
+   * @param value   Sample
+   */
+  void accumulateSample(series_accumulator_t* acc, int16_t value);
+
+  /**
+   * @brief Close a rollup and reset the accumulator
+   *
+   * @param acc     Accumulator
+   * @param rollup  Address to write min, mean and max to, SERIES_NO_VALUE
+   *                if there was no value
+   */
+  void closeRollup(series_accumulator_t* acc, series_rollup_t* rollup);
+
+  /**
+   * @brief Find the points of a ring to answer a cursor with
+   *
+   * @param next      Sequence of the next point to be written
+   * @param len       Length of the ring
+   * @param since     Cursor of the client, 0 for everything
+   * @param first     Address to write the sequence of the first point to,
+   *                  the oldest one still in the ring if since is older
+   * @return uint32_t Number of points from first on, at most SERIES_PAGE_POINTS
+   */
+  uint32_t seriesWindow(uint32_t next, uint16_t len, uint32_t since, uint32_t* first);
+
+  /**
+   * @brief Handler of /api/series
+   *
+   * @param request Request
+   */
+  void actionSeries(AsyncWebServerRequest *request);
+}
+
+#endif /*** TIME_SERIES_H ***/
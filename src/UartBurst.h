@@ -0,0 +1,47 @@
+/**
+ * @file    UartBurst.h
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Accounting of the bursts read from the receiver port, shared by the
+ *          firmware and the host tool in tools/uartbench. Plain C only.
+ *
+ *          A burst is everything the receiver sent until the line went idle,
+ *          usually the messages of one epoch. It ends early, as a split, when
+ *          the burst buffer is full or the input had to be flushed.
+ */
+
+#ifndef UART_BURST_H
+#define UART_BURST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define UART_BURST_BUCKETS      8             // < 64, < 128, ... < 4096, >= 4096 bytes
+#define UART_BURST_MIN_BUCKET   64
+
+typedef struct {
+  uint32_t bursts;
+  uint32_t bytes;
+  uint32_t lastBurst;       // bytes
+  uint32_t maxBurst;
+  uint32_t splits;          // ended by a full buffer or a flush, not by the idle line
+  uint32_t sizes[UART_BURST_BUCKETS];
+} uart_burst_stats_t;
+
+static inline uint8_t burstBucket(uint32_t len) {
+  uint8_t bucket = 0;
+  for (uint32_t limit = UART_BURST_MIN_BUCKET; len >= limit && bucket < UART_BURST_BUCKETS - 1; limit <<= 1) bucket++;
+  return bucket;
+}
+
+static inline void countBurst(uart_burst_stats_t* stats, uint32_t len, int idle) {
+  stats->bursts++;
+  stats->bytes += len;
+  stats->lastBurst = len;
+  if (len > stats->maxBurst) stats->maxBurst = len;
+  if (!idle) stats->splits++;
+  stats->sizes[burstBucket(len)]++;
+}
+
+#endif /*** UART_BURST_H ***/
@@ -76,14 +76,50 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
             document.getElementById("altitude").disabled = true;
         }
     }
+
+    // Post the form as body, the base decodes it chunk by chunk without buffering every field
+    function submitConfig(form) {
+        if (!confirm('Restart the ESP32 by pressing the Reboot button for your changes to take effect!')) {
+            return false;
+        }
+        fetch(form.getAttribute("action"), {
+            method: "POST",
+            headers: { "Content-Type": "application/x-rtkbase-form" },
+            body: new URLSearchParams(new FormData(form)).toString()
+        }).then(response => response.text()).then(html => {
+            document.open();
+            document.write(html);
+            document.close();
+        });
+        return false;
+    }
+
+    // SSID picker from the background survey of the base, no scan delay,
+    // refresh asks the base for a scan and reloads the list when it is done
+    function loadNetworks(refresh) {
+        fetch(refresh ? "/api/networks?refresh=1" : "/api/networks").then(response => response.json()).then(result => {
+            const list = document.getElementById("networks");
+            list.innerHTML = "";
+            result.networks.forEach(network => {
+                const option = document.createElement("option");
+                option.value = network.ssid;
+                option.label = network.ssid + " (" + network.rssi + " dBm, channel " + network.channel + ")";
+                list.appendChild(option);
+            });
+            document.getElementById("networks_age").innerHTML = result.scanning ? "scanning..." :
+                "scanned " + Math.round(result.age_ms / 1000) + " s ago";
+            if (result.scanning) setTimeout(() => loadNetworks(false), 6000);
+        }).catch(() => {});
+        return false;
+    }
 </script>
 
-<body onload="loadRadioState();enableLocationMethod();">
+<body onload="loadRadioState();enableLocationMethod();loadNetworks(false);">
 
-    <form id="Form1" onsubmit="return confirm('Restart the ESP32 by pressing the Reboot button for your changes to take effect!');" action='actionUpdateData' method='post' target="hidden-form"></form>
+    <form id="Form1" onsubmit="return submitConfig(this);" action='actionUpdateData' method='post' target="hidden-form"></form>
     <form id="Form2" onsubmit="return confirm('Are you sure? All saved SPIFFS files will be deleted (Wifi and RTK config)');" action='actionWipeData' method='post' target="hidden-form"></form>
     <form id="Form3" onsubmit="return confirm('Connection will be lost during reboot, please refresh this page after reconnecting!');" action='actionRebootESP32' method='post' target="hidden-form"></form>
-    <input form="Form1" type="hidden" id="radio_state" value=%location_method%>
+    <input form="Form1" type="hidden" id="radio_state" value="%location_method%">
     <p>
         <table class=center>
             <tr>
@@ -104,13 +140,15 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
             <tr>
                 <td style="text-align:left;">SSID:</td>
                 <td>
-                    <input class="text_field" form="Form1" type="text" maxlength="30" name="ssid" placeholder=%ssid% style="text-align:center;">
+                    <input class="text_field" form="Form1" type="text" maxlength="30" name="ssid" placeholder="%ssid%" list="networks" autocomplete="off" style="text-align:center;">
+                    <datalist id="networks"></datalist>
+                    <br><a href="#" onclick="return loadNetworks(true);">Scan</a> <span id="networks_age"></span>
                 </td>
             </tr>
             <tr>
                 <td style="text-align:left;">Password:</td>
                 <td>
-                    <input class="text_field" form="Form1" type="text" maxlength="30" name="password" placeholder=%password% style="text-align:center;">
+                    <input class="text_field" form="Form1" type="text" maxlength="30" name="password" placeholder="%password%" style="text-align:center;">
                 </td>
             </tr>
             <tr>
@@ -120,25 +158,73 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
                 <tr>
                     <td style="text-align:left;">Caster host:</td>
                     <td>
-                        <input class="text_field" form="Form1" type="text" maxlength="30" name="caster_host" placeholder=%caster_host% style="text-align:center;">
+                        <input class="text_field" form="Form1" type="text" maxlength="30" name="caster_host" placeholder="%caster_host%" style="text-align:center;">
                     </td>
                 </tr>
                 <tr>
                     <td style="text-align:left;">Caster port:</td>
                     <td>
-                        <input class="text_field" form="Form1" type="text" maxlength="30" name="caster_port" placeholder=%caster_port% style="text-align:center;">
+                        <input class="text_field" form="Form1" type="text" maxlength="30" name="caster_port" placeholder="%caster_port%" style="text-align:center;">
                     </td>
                 </tr>
                 <tr>
                     <td style="text-align:left;">Mount point:</td>
                     <td>
-                        <input class="text_field" form="Form1" type="text" maxlength="30" name="mount_point" placeholder=%mount_point% style="text-align:center;">
+                        <input class="text_field" form="Form1" type="text" maxlength="30" name="mount_point" placeholder="%mount_point%" style="text-align:center;">
                     </td>
                 </tr>
                 <tr>
                     <td style="text-align:left;">Mount point PW:</td>
                     <td>
-                        <input class="text_field" form="Form1" type="text" maxlength="30" name="mount_point_pw" placeholder=%mount_point_pw% style="text-align:center;">
+                        <input class="text_field" form="Form1" type="text" maxlength="30" name="mount_point_pw" placeholder="%mount_point_pw%" style="text-align:center;">
+                    </td>
+                </tr>
+                <tr>
+                    <td style="text-align:left;">Caster 2 host:</td>
+                    <td>
+                        <input class="text_field" form="Form1" type="text" maxlength="30" name="caster_host_2" placeholder="%caster_host_2%" style="text-align:center;">
+                    </td>
+                </tr>
+                <tr>
+                    <td style="text-align:left;">Caster 2 port:</td>
+                    <td>
+                        <input class="text_field" form="Form1" type="text" maxlength="30" name="caster_port_2" placeholder="%caster_port_2%" style="text-align:center;">
+                    </td>
+                </tr>
+                <tr>
+                    <td style="text-align:left;">Mount point 2:</td>
+                    <td>
+                        <input class="text_field" form="Form1" type="text" maxlength="30" name="mount_point_2" placeholder="%mount_point_2%" style="text-align:center;">
+                    </td>
+                </tr>
+                <tr>
+                    <td style="text-align:left;">Mount point 2 PW:</td>
+                    <td>
+                        <input class="text_field" form="Form1" type="text" maxlength="30" name="mount_point_pw_2" placeholder="%mount_point_pw_2%" style="text-align:center;">
+                    </td>
+                </tr>
+                <tr>
+                    <td style="text-align:left;">Caster 3 host:</td>
+                    <td>
+                        <input class="text_field" form="Form1" type="text" maxlength="30" name="caster_host_3" placeholder="%caster_host_3%" style="text-align:center;">
+                    </td>
+                </tr>
+                <tr>
+                    <td style="text-align:left;">Caster 3 port:</td>
+                    <td>
+                        <input class="text_field" form="Form1" type="text" maxlength="30" name="caster_port_3" placeholder="%caster_port_3%" style="text-align:center;">
+                    </td>
+                </tr>
+                <tr>
+                    <td style="text-align:left;">Mount point 3:</td>
+                    <td>
+                        <input class="text_field" form="Form1" type="text" maxlength="30" name="mount_point_3" placeholder="%mount_point_3%" style="text-align:center;">
+                    </td>
+                </tr>
+                <tr>
+                    <td style="text-align:left;">Mount point 3 PW:</td>
+                    <td>
+                        <input class="text_field" form="Form1" type="text" maxlength="30" name="mount_point_pw_3" placeholder="%mount_point_pw_3%" style="text-align:center;">
                     </td>
                 </tr>
                 <tr>
@@ -168,19 +254,33 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
                 <td colspan=2></td>
                 <tr>
                     <td style="text-align:left;"> min Accuracy, m: </td>
-                    <td><input title="The survey is carried out until the desired accuracy is achieved. After that, the location coordinates are stored in SPIFFS. 0.06 m is a useful value." class="text_field" form="Form1" type="text" maxlength="30" id="survey_accuracy" name="survey_accuracy" placeholder=%survey_accuracy%></td>
+                    <td><input title="The survey is carried out until the desired accuracy is achieved. After that, the location coordinates are stored in SPIFFS. 0.06 m is a useful value." class="text_field" form="Form1" type="text" maxlength="30" id="survey_accuracy" name="survey_accuracy" placeholder="%survey_accuracy%"></td>
                 </tr>
                 <tr>
                     <td style="text-align:left;"> Latitude, deg: </td>
-                    <td><input class="text_field" form="Form1" type="text" maxlength="30" id="latitude" name="latitude" placeholder=%latitude%></td>
+                    <td><input class="text_field" form="Form1" type="text" maxlength="30" id="latitude" name="latitude" placeholder="%latitude%"></td>
                 </tr>
                 <tr>
                     <td style="text-align:left;"> Longitude, deg: </td>
-                    <td><input class="text_field" form="Form1" type="text" maxlength="30" id="longitude" name="longitude" placeholder=%longitude%> </td>
+                    <td><input class="text_field" form="Form1" type="text" maxlength="30" id="longitude" name="longitude" placeholder="%longitude%"> </td>
                 </tr>
                 <tr>
                     <td style="text-align:left;"> Altitude, m: </td>
-                    <td><input title="Height over sea-level of the antenna is required (float)." class="text_field" form="Form1" type="text" maxlength="30" id="altitude" name="altitude" placeholder=%altitude%></td>
+                    <td><input title="Height over sea-level of the antenna is required (float)." class="text_field" form="Form1" type="text" maxlength="30" id="altitude" name="altitude" placeholder="%altitude%"></td>
+                </tr>
+                <tr>
+                    <td style="text-align:left;"> Task profile: </td>
+                    <td><input title="Cores and priorities of the GNSS, correction and web server tasks, applied after a reboot." class="text_field" form="Form1" type="text" maxlength="30" id="task_profile" name="task_profile" placeholder="%task_profile%" list="profiles" autocomplete="off">
+                    <datalist id="profiles"><option value="balanced"><option value="isolated"><option value="single_core"></datalist></td>
+                </tr>
+                <tr>
+                    <td style="text-align:left;"> Caster standby: </td>
+                    <td><input title="on keeps a second connection to every caster open to take over at once after a drop." class="text_field" form="Form1" type="text" maxlength="30" id="caster_standby" name="caster_standby" placeholder="%caster_standby%" list="switches" autocomplete="off">
+                    <datalist id="switches"><option value="on"><option value="off"></datalist></td>
+                </tr>
+                <tr>
+                    <td style="text-align:left;"> RTCM rates: </td>
+                    <td><input title="Interval in s per message type for the casters, e.g. 1005:10,1230:10,msm7:1 (0 drops a type, all passes everything)." class="text_field" form="Form1" type="text" maxlength="30" id="rtcm_rates" name="rtcm_rates" placeholder="%rtcm_rates%"></td>
                 </tr>
         </table>
     </p>
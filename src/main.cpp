@@ -1,14 +1,28 @@
 #include <Arduino.h>
-#include <SPIFFS.h>
 #include <RTKBaseManager.h>
+#include <Storage.h>
+#include <NetworkSurvey.h>
+#include <TaskMonitor.h>
+#include <TaskRuntime.h>
+#include <CasterFanout.h>
+#include <LocalCaster.h>
+#include <Recorder.h>
+#include <GnssUart.h>
+#include <TimeSeries.h>
+#include <BootGuard.h>
+#include <FlashBudget.h>
 #include <ManagerConfig.h>
+#ifdef RTK_SIMULATION
+#include <Simulation.h>
+#endif
 
-#ifdef DEBUGGING
+#if defined(RTK_BENCHMARK)
+#include <BenchmarksRTKBaseManager.h>
+#elif defined(DEBUGGING)
 #include <TestsRTKBaseManager.h>
 #endif
 
 AsyncWebServer server(80);
-String scannedSSIDs[MAX_SSIDS];
 
 void setup() {
   
@@ -16,40 +30,90 @@ void setup() {
   Serial.begin(BAUD);
   while (!Serial) {};
   #endif
+
+  // Reset reason and failed boots in a row, see /api/boot
+  bool safeMode = RTKBaseManager::beginBoot();
+
+  // CPU use per task from the first tick on, see /api/tasks
+  if (!RTKBaseManager::startTaskMonitor()) {
+    DEBUG_SERIAL.println(F("Task monitor not started"));
+  }
   
-  // Initialize SPIFFS, set true for formatting
+  // Initialize the storage backend, set true for formatting
   bool format = false;
-  if (!RTKBaseManager::setupSPIFFS(format)) {
-    DEBUG_SERIAL.println(F("setupSPIFFS failed, freezing"));
+  if (!RTKBaseManager::setupStorage(format)) {
+    DEBUG_SERIAL.println(F("setupStorage failed, freezing"));
     while (true) {};
   }
+  // Config writes are counted and limited per hour from here on, see /api/flash
+  RTKBaseManager::startFlashBudget();
+
+  if (safeMode) {
+    // The fast path after a reboot loop: only the AP and the safe mode page,
+    // nothing of what may have crashed the last boots
+    RTKBaseManager::setupAPMode(AP_SSID, AP_PASSWORD);
+    RTKBaseManager::startSafeServer(&server);
+    RTKBaseManager::endBootSetup();
+    return;
+  }
+  RTKBaseManager::loadConfig();
 
   DEBUG_SERIAL.print(F("Device name: "));DEBUG_SERIAL.println(DEVICE_NAME);
 
-  String locationMethod = readFile(SPIFFS, PATH_RTK_LOCATION_METHOD);
+  String locationMethod = RTKBaseManager::readStoredString(PATH_RTK_LOCATION_METHOD);
   DEBUG_SERIAL.print(F("Location method: ")); DEBUG_SERIAL.println(locationMethod);
   
   location_int_t lastLocation;
-  if (getIntLocationFromSPIFFS(&lastLocation, PATH_RTK_LOCATION_LATITUDE, PATH_RTK_LOCATION_LONGITUDE, PATH_RTK_LOCATION_ALTITUDE)) {
+  if (getIntLocationFromStorage(&lastLocation, PATH_RTK_LOCATION_LATITUDE, PATH_RTK_LOCATION_LONGITUDE, PATH_RTK_LOCATION_ALTITUDE)) {
     printIntLocation(&lastLocation);
   }
 
+#if defined(RTK_SIMULATION)
+  // Virtual receiver and casters on the loopback interface, the recording
+  // is the trace and is not written to
+  RTKBaseManager::setupAPMode(AP_SSID, AP_PASSWORD);
+  delay(500);
+  RTKBaseManager::startLocalCaster();
+  RTKBaseManager::startCasters(RTKBaseManager::simulatedReceiver(), true);
+  RTKBaseManager::startTimeSeries();
+  RTKBaseManager::startServer(&server);
+  RTKBaseManager::applyRuntimeProfile();
+  if (!RTKBaseManager::startSimulation()) {
+    DEBUG_SERIAL.println(F("Simulation not started"));
+  }
+#else
   // Check if we have credentials for a available network
-  String lastSSID = RTKBaseManager::readFile(SPIFFS, PATH_WIFI_SSID);
-  String lastPassword = RTKBaseManager::readFile(SPIFFS, PATH_WIFI_PASSWORD);
+  String lastSSID = RTKBaseManager::readStoredString(PATH_WIFI_SSID);
+  String lastPassword = RTKBaseManager::readStoredString(PATH_WIFI_PASSWORD);
 
-  if (!RTKBaseManager::savedNetworkAvailable(lastSSID) || lastPassword.isEmpty() ) {
+  bool uplink = RTKBaseManager::savedNetworkAvailable(lastSSID) && !lastPassword.isEmpty();
+  if (!uplink) {
     RTKBaseManager::setupAPMode(AP_SSID, AP_PASSWORD);
     delay(500);
   } else {
    RTKBaseManager::setupStationMode(lastSSID.c_str(), lastPassword.c_str(), DEVICE_NAME);
    delay(500);
  }
+  // Corrections of the receiver go to the rovers of the local network and,
+  // in station mode, to every configured caster
+  RTKBaseManager::startRecorder();
+  RTKBaseManager::startLocalCaster();
+  RTKBaseManager::startCasters(nullptr, uplink);
+  if (!RTKBaseManager::startGnssUart(RTKBaseManager::ingestBytes)) {
+    DEBUG_SERIAL.println(F("Receiver port not started"));
+  }
+  RTKBaseManager::startNetworkSurvey();
+  RTKBaseManager::startTimeSeries();
   RTKBaseManager::startServer(&server);
+  RTKBaseManager::applyRuntimeProfile();
+#endif
+  RTKBaseManager::endBootSetup();
 }
 
 void loop() {
+  RTKBaseManager::checkSafeModeTimeout();
   #ifdef DEBUGGING
-  aunit::TestRunner::run();
+  // The tests write to flash, a boot loop in safe mode must not
+  if (!RTKBaseManager::inSafeMode()) aunit::TestRunner::run();
   #endif
 }
\ No newline at end of file
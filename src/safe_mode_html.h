@@ -0,0 +1,77 @@
+#ifndef SAFE_MODE_HTML_H
+#define SAFE_MODE_HTML_H
+
+const char SAFE_MODE_HTML[] PROGMEM = R"rawliteral(
+<!DOCTYPE HTML>
+<html>
+
+<head>
+    <meta content="text/html" ; charset="UTF-8" ; http-equiv="content-type">
+    <meta name="viewport" content="width = device-width, initial-scale = 1.0, maximum-scale = 1.0, user-scalable=0">
+    <title>RTK base safe mode</title>
+    <style>
+        body {
+            background-color: #4180C8;
+            font-family: Lato, Helvetica, Roboto, sans-serif;
+            color: GhostWhite;
+            text-align: center;
+            border: 1em;
+        }
+
+        .center {
+            margin-left: auto;
+            margin-right: auto;
+        }
+
+        .button {
+            background-color: #F0A03C;
+            color: GhostWhite;
+            border: none;
+            padding: 0.5em 1em;
+            margin: 0.2em;
+        }
+    </style>
+
+    <script type="text/javascript">
+    // Reset reasons and run times of the last boots
+    function loadBoots() {
+        fetch("/api/boot").then(response => response.json()).then(result => {
+            const lines = result.history.map(boot =>
+                boot.reason + ", ran " + Math.round(boot.uptime_ms / 1000) + " s" + (boot.safe_mode ? ", safe mode" : ""));
+            document.getElementById("boots").textContent = lines.join("\n");
+        }).catch(() => {});
+    }
+    </script>
+</head>
+
+<body onload="loadBoots();">
+    <iframe name="hidden-form" style="display:none;"></iframe>
+    <form id="Form1" action='actionUpdateData' method='post' target="hidden-form"></form>
+    <form id="Form2" onsubmit="return confirm('Are you sure? All saved config values will be deleted (Wifi and RTK config)');" action='actionWipeData' method='post' target="hidden-form"></form>
+    <form id="Form3" action='actionRebootESP32' method='post' target="hidden-form"></form>
+    <h2>RTK Base Station: safe mode</h2>
+    <p>The base failed to boot several times in a row. Casters, recorder and WiFi scan are off.<br>
+       Fix the WiFi credentials or wipe the config, then reboot to start normally.</p>
+    <pre id="boots"></pre>
+    <table class=center>
+        <tr>
+            <td style="text-align:left;"> SSID: </td>
+            <td><input form="Form1" type="text" maxlength="30" name="ssid"></td>
+        </tr>
+        <tr>
+            <td style="text-align:left;"> Password: </td>
+            <td><input form="Form1" type="password" maxlength="30" name="password"></td>
+        </tr>
+    </table>
+    <br>
+    <div>
+        <input type="submit" form="Form1" class="button" value="Save" />
+        <input type="submit" form="Form3" class="button" value="Reboot" />
+        <input type="submit" form="Form2" class="button" value="Wipe" name="wipe_button" />
+    </div>
+</body>
+
+</html>
+)rawliteral";
+
+#endif /* SAFE_MODE_HTML_H */
@@ -0,0 +1,188 @@
+/**
+ * @file    assetbundle.cpp
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Builds the asset bundle for the assets partition, see AssetFormat.h.
+ *          The pages compiled into the firmware are the default content, files
+ *          of --dir are added or replace them by name. --verify maps a bundle
+ *          with mmap and checks it like the firmware does at boot.
+ * <br>
+ * @note    Host tool, build with:
+ *            g++ -std=c++11 -O2 -Isrc -o assetbundle tools/assets/assetbundle.cpp
+ *          Run:
+ *            ./assetbundle -o assets.bin --dir data/assets
+ *            ./assetbundle --verify assets.bin
+ *          Flash to the assets partition of partitions_assets.csv:
+ *            esptool.py write_flash 0x3C0000 assets.bin
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define PROGMEM
+#include <AssetFormat.h>
+#include <index_html.h>
+#include <reboot_html.h>
+#include <error_html.h>
+
+static const size_t DEFAULT_PARTITION_SIZE = 0x30000;
+
+static bool readFile(const std::string& path, std::string* content) {
+  std::ifstream file(path.c_str(), std::ios::binary);
+  if (!file) return false;
+  std::ostringstream data;
+  data << file.rdbuf();
+  *content = data.str();
+  return true;
+}
+
+static bool addDir(const std::string& dir, std::map<std::string, std::string>& assets) {
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) return false;
+  struct dirent* e;
+  bool success = true;
+  while ((e = readdir(d)) != nullptr) {
+    std::string name = e->d_name;
+    if (name[0] == '.') continue;
+    if (name.size() > ASSET_NAME_MAX_LEN) {
+      fprintf(stderr, "name too long: %s\n", name.c_str());
+      success = false;
+      continue;
+    }
+    success &= readFile(dir + "/" + name, &assets[name]);
+  }
+  closedir(d);
+  return success;
+}
+
+static std::string buildBundle(const std::map<std::string, std::string>& assets) {
+  size_t dataStart = sizeof(asset_bundle_header_t) + assets.size() * sizeof(asset_entry_t);
+  std::vector<asset_entry_t> entries;
+  std::string data;
+
+  for (std::map<std::string, std::string>::const_iterator it = assets.begin(); it != assets.end(); ++it) {
+    asset_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    strncpy(entry.name, it->first.c_str(), ASSET_NAME_MAX_LEN);
+    entry.offset = dataStart + data.size();
+    entry.length = it->second.size();
+    entry.hash = assetHash((const uint8_t*)it->second.data(), it->second.size());
+    entries.push_back(entry);
+    data += it->second;
+    // Zero terminated, templates are used as C strings, then 4 byte aligned
+    data.push_back('\0');
+    while (data.size() % 4) data.push_back('\0');
+  }
+
+  asset_bundle_header_t header;
+  header.magic = ASSET_BUNDLE_MAGIC;
+  header.version = ASSET_BUNDLE_VERSION;
+  header.count = entries.size();
+  header.size = dataStart + data.size();
+
+  std::string bundle((const char*)&header, sizeof(header));
+  if (!entries.empty()) bundle.append((const char*)&entries[0], entries.size() * sizeof(asset_entry_t));
+  return bundle + data;
+}
+
+// Same checks as mountAssets() and checkBundle() of the firmware
+static int verifyBundle(const char* path) {
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(asset_bundle_header_t)) {
+    fprintf(stderr, "can not read %s\n", path);
+    return 1;
+  }
+  const uint8_t* base = (const uint8_t*)mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) return 1;
+
+  const asset_bundle_header_t* header = (const asset_bundle_header_t*)base;
+  bool valid = header->magic == ASSET_BUNDLE_MAGIC && header->version == ASSET_BUNDLE_VERSION &&
+               header->count <= ASSET_MAX_COUNT && header->size <= (size_t)st.st_size &&
+               header->size >= sizeof(asset_bundle_header_t) + header->count * sizeof(asset_entry_t);
+  const asset_entry_t* entries = (const asset_entry_t*)(base + sizeof(asset_bundle_header_t));
+  size_t dataStart = sizeof(asset_bundle_header_t) + header->count * sizeof(asset_entry_t);
+
+  for (uint16_t i = 0; valid && i < header->count; i++) {
+    const asset_entry_t& entry = entries[i];
+    bool ok = memchr(entry.name, '\0', sizeof(entry.name)) != nullptr &&
+              entry.offset >= dataStart && entry.length < header->size &&
+              entry.offset <= header->size - entry.length - 1 &&
+              base[entry.offset + entry.length] == '\0' &&
+              assetHash(base + entry.offset, entry.length) == entry.hash;
+    printf("%-24s offset %6u length %6u hash %08x %s\n", ok ? entry.name : "?", entry.offset, entry.length, entry.hash, ok ? "ok" : "BROKEN");
+    valid &= ok;
+  }
+  munmap((void*)base, st.st_size);
+  printf("%s\n", valid ? "bundle ok" : "bundle invalid");
+  return valid ? 0 : 1;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: assetbundle -o assets.bin [--dir dir] [--partition-size bytes]\n"
+                  "       assetbundle --verify assets.bin\n");
+}
+
+int main(int argc, char** argv) {
+  std::string out, dir;
+  size_t partitionSize = DEFAULT_PARTITION_SIZE;
+
+  // Options come in pairs, a lone --help or a flag without its value is an error
+  if (argc % 2 == 0) {
+    usage();
+    return 2;
+  }
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i];
+    if (key == "--verify") return verifyBundle(argv[i + 1]);
+    else if (key == "-o") out = argv[i + 1];
+    else if (key == "--dir") dir = argv[i + 1];
+    else if (key == "--partition-size") partitionSize = strtoul(argv[i + 1], nullptr, 0);
+    else { usage(); return 2; }
+  }
+  if (out.empty()) {
+    usage();
+    return 2;
+  }
+
+  std::map<std::string, std::string> assets;
+  assets["index.html"] = INDEX_HTML;
+  assets["reboot.html"] = REBOOT_HTML;
+  assets["error.html"] = ERROR_HTML;
+  if (!dir.empty() && !addDir(dir, assets)) {
+    fprintf(stderr, "can not read %s\n", dir.c_str());
+    return 1;
+  }
+  if (assets.size() > ASSET_MAX_COUNT) {
+    fprintf(stderr, "too many assets: %zu, max %d\n", assets.size(), ASSET_MAX_COUNT);
+    return 1;
+  }
+
+  std::string bundle = buildBundle(assets);
+  if (bundle.size() > partitionSize) {
+    fprintf(stderr, "bundle of %zu bytes does not fit the partition of %zu bytes\n", bundle.size(), partitionSize);
+    return 1;
+  }
+  std::ofstream file(out.c_str(), std::ios::binary);
+  file.write(bundle.data(), bundle.size());
+  if (!file) {
+    fprintf(stderr, "can not write %s\n", out.c_str());
+    return 1;
+  }
+  printf("%zu assets, %zu bytes\n", assets.size(), bundle.size());
+  return 0;
+}
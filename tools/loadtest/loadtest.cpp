@@ -0,0 +1,296 @@
+/**
+ * @file    loadtest.cpp
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   HTTP load generator for the web server of a RTK base. Runs the
+ *          requests of a scenario file with a configurable number of concurrent
+ *          clients and prints throughput, p50/p95/p99 latency and, if the base
+ *          was built with the profiling env, heap allocations per request as JSON.
+ * <br>
+ * @note    Host tool, build with:
+ *            g++ -std=c++11 -O2 -pthread -o loadtest tools/loadtest/loadtest.cpp
+ *          Run:
+ *            ./loadtest --host rtkbase.local --scenario tools/loadtest/scenario.txt \
+ *                       --concurrency 8 --duration 30 > result.json
+ *          The exit code is 1 on connection errors or if --max-p95-ms is exceeded.
+ */
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef struct {
+  std::string name;
+  std::string method;       // GET, POST (urlencoded) or FORM (streamed form body)
+  std::string path;
+  unsigned    weight;
+  std::string body;
+} step_t;
+
+typedef struct {
+  std::vector<double> latenciesMs;
+  std::map<int, unsigned> statusCodes;
+  unsigned errors;
+} step_result_t;
+
+typedef struct {
+  std::string host;
+  std::string port;
+  std::string scenario;
+  unsigned    concurrency;
+  unsigned    duration;     // s, used if requests is 0
+  unsigned    requests;     // total number of requests
+  unsigned    timeoutMs;
+  double      maxP95Ms;     // fail if the total p95 is above, 0 = no limit
+} options_t;
+
+static bool loadScenario(const std::string& path, std::vector<step_t>& steps) {
+  std::ifstream file(path.c_str());
+  if (!file) return false;
+
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream fields(line);
+    step_t step;
+    step.weight = 0;
+    fields >> step.name >> step.method >> step.path >> step.weight >> step.body;
+    if (step.name.empty() || step.path.empty() || step.weight == 0) continue;
+    steps.push_back(step);
+  }
+  return !steps.empty();
+}
+
+static int connectTo(const options_t& opt) {
+  struct addrinfo hints, *res = nullptr;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(opt.host.c_str(), opt.port.c_str(), &hints, &res) != 0 || res == nullptr) return -1;
+
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if (fd >= 0) {
+    struct timeval tv;
+    tv.tv_sec = opt.timeoutMs / 1000;
+    tv.tv_usec = (opt.timeoutMs % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    if (connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(res);
+  return fd;
+}
+
+// Returns the status code or -1, the base closes every connection after the response
+static int httpRequest(const options_t& opt, const step_t& step, std::string* response) {
+  int fd = connectTo(opt);
+  if (fd < 0) return -1;
+
+  std::string method = (step.method == "GET") ? "GET" : "POST";
+  std::ostringstream req;
+  req << method << " " << step.path << " HTTP/1.1\r\n"
+      << "Host: " << opt.host << "\r\n"
+      << "Connection: close\r\n";
+  if (method == "POST") {
+    req << "Content-Type: " << ((step.method == "FORM") ? "application/x-rtkbase-form" : "application/x-www-form-urlencoded") << "\r\n"
+        << "Content-Length: " << step.body.size() << "\r\n";
+  }
+  req << "\r\n";
+  if (method == "POST") req << step.body;
+
+  std::string out = req.str();
+  if (send(fd, out.data(), out.size(), 0) != (ssize_t)out.size()) {
+    close(fd);
+    return -1;
+  }
+
+  std::string in;
+  char buf[2048];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) in.append(buf, n);
+  close(fd);
+
+  int status = -1;
+  if (in.compare(0, 5, "HTTP/") == 0) {
+    size_t sp = in.find(' ');
+    if (sp != std::string::npos) status = atoi(in.c_str() + sp + 1);
+  }
+  if (response != nullptr) {
+    size_t bodyStart = in.find("\r\n\r\n");
+    *response = (bodyStart == std::string::npos) ? std::string() : in.substr(bodyStart + 4);
+  }
+  return status;
+}
+
+// Reads a counter like "allocs":123 from the /api/status JSON, -1 if missing
+static long long jsonCounter(const std::string& json, const char* key) {
+  std::string pattern = std::string("\"") + key + "\":";
+  size_t pos = json.find(pattern);
+  return (pos == std::string::npos) ? -1 : atoll(json.c_str() + pos + pattern.size());
+}
+
+static bool allocsOfBase(const options_t& opt, long long* allocs) {
+  step_t status;
+  status.method = "GET";
+  status.path = "/api/status";
+  std::string json;
+  if (httpRequest(opt, status, &json) != 200) return false;
+  if (json.find("\"tracking\":true") == std::string::npos) return false;
+  *allocs = jsonCounter(json, "allocs");
+  return *allocs >= 0;
+}
+
+static double percentile(std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0.0;
+  size_t idx = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+static void printStats(const char* indent, const std::string& name, step_result_t& result, double seconds, bool last) {
+  std::vector<double>& lat = result.latenciesMs;
+  std::sort(lat.begin(), lat.end());
+  printf("%s\"%s\": {\"requests\": %zu, \"errors\": %u, \"throughput_rps\": %.2f, "
+         "\"p50_ms\": %.2f, \"p95_ms\": %.2f, \"p99_ms\": %.2f, \"status\": {",
+         indent, name.c_str(), lat.size(), result.errors, seconds > 0 ? lat.size() / seconds : 0.0,
+         percentile(lat, 50), percentile(lat, 95), percentile(lat, 99));
+  for (std::map<int, unsigned>::iterator it = result.statusCodes.begin(); it != result.statusCodes.end(); ++it) {
+    printf("%s\"%d\": %u", it == result.statusCodes.begin() ? "" : ", ", it->first, it->second);
+  }
+  printf("}}%s\n", last ? "" : ",");
+}
+
+static void usage() {
+  fprintf(stderr, "usage: loadtest --host <host> [--port 80] [--scenario scenario.txt]\n"
+                  "                [--concurrency 4] [--duration 10 | --requests n] [--timeout-ms 5000]\n"
+                  "                [--max-p95-ms limit]\n");
+}
+
+int main(int argc, char** argv) {
+  options_t opt;
+  opt.port = "80";
+  opt.scenario = "tools/loadtest/scenario.txt";
+  opt.concurrency = 4;
+  opt.duration = 10;
+  opt.requests = 0;
+  opt.timeoutMs = 5000;
+  opt.maxP95Ms = 0.0;
+
+  // Options come in pairs, a lone --help or a flag without its value is an error
+  if (argc % 2 == 0) {
+    usage();
+    return 2;
+  }
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i];
+    std::string val = argv[i + 1];
+    if (key == "--host") opt.host = val;
+    else if (key == "--port") opt.port = val;
+    else if (key == "--scenario") opt.scenario = val;
+    else if (key == "--concurrency") opt.concurrency = std::max(1, atoi(val.c_str()));
+    else if (key == "--duration") opt.duration = atoi(val.c_str());
+    else if (key == "--requests") opt.requests = atoi(val.c_str());
+    else if (key == "--timeout-ms") opt.timeoutMs = atoi(val.c_str());
+    else if (key == "--max-p95-ms") opt.maxP95Ms = atof(val.c_str());
+    else { usage(); return 2; }
+  }
+  std::vector<step_t> steps;
+  if (opt.host.empty() || !loadScenario(opt.scenario, steps)) {
+    usage();
+    return 2;
+  }
+
+  unsigned totalWeight = 0;
+  for (size_t i = 0; i < steps.size(); i++) totalWeight += steps[i].weight;
+
+  long long allocsBefore = 0, allocsAfter = 0;
+  bool allocs = allocsOfBase(opt, &allocsBefore);
+
+  std::vector<step_result_t> results(steps.size());
+  std::mutex resultsMutex;
+  std::atomic<unsigned> issued(0);
+  typedef std::chrono::steady_clock clock;
+  clock::time_point start = clock::now();
+  clock::time_point end = start + std::chrono::seconds(opt.duration);
+
+  std::vector<std::thread> clients;
+  for (unsigned c = 0; c < opt.concurrency; c++) {
+    clients.push_back(std::thread([&, c]() {
+      std::mt19937 rng(c + 1);
+      while (true) {
+        if (opt.requests > 0 ? issued++ >= opt.requests : clock::now() >= end) break;
+        // Weighted pick of the next step
+        unsigned pick = rng() % totalWeight;
+        size_t s = 0;
+        while (pick >= steps[s].weight) pick -= steps[s++].weight;
+
+        clock::time_point t0 = clock::now();
+        int status = httpRequest(opt, steps[s], nullptr);
+        double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+
+        std::lock_guard<std::mutex> lock(resultsMutex);
+        if (status < 0) {
+          results[s].errors++;
+        } else {
+          results[s].latenciesMs.push_back(ms);
+          results[s].statusCodes[status]++;
+        }
+      }
+    }));
+  }
+  for (size_t i = 0; i < clients.size(); i++) clients[i].join();
+  double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+  allocs = allocs && allocsOfBase(opt, &allocsAfter);
+
+  step_result_t total;
+  total.errors = 0;
+  for (size_t i = 0; i < results.size(); i++) {
+    total.latenciesMs.insert(total.latenciesMs.end(), results[i].latenciesMs.begin(), results[i].latenciesMs.end());
+    for (std::map<int, unsigned>::iterator it = results[i].statusCodes.begin(); it != results[i].statusCodes.end(); ++it) {
+      total.statusCodes[it->first] += it->second;
+    }
+    total.errors += results[i].errors;
+  }
+
+  printf("{\n  \"host\": \"%s\", \"concurrency\": %u, \"seconds\": %.2f,\n", opt.host.c_str(), opt.concurrency, seconds);
+  // The closing /api/status request itself is included in the delta
+  if (allocs && !total.latenciesMs.empty()) {
+    printf("  \"allocs_per_request\": %.2f,\n", (double)(allocsAfter - allocsBefore) / (total.latenciesMs.size() + 1));
+  } else {
+    printf("  \"allocs_per_request\": null,\n");
+  }
+  printStats("  ", "total", total, seconds, false);
+  printf("  \"steps\": {\n");
+  for (size_t i = 0; i < steps.size(); i++) {
+    printStats("    ", steps[i].name, results[i], seconds, i + 1 == steps.size());
+  }
+  printf("  }\n}\n");
+
+  // total.latenciesMs is sorted by printStats()
+  if (opt.maxP95Ms > 0.0 && percentile(total.latenciesMs, 95) > opt.maxP95Ms) {
+    fprintf(stderr, "p95 %.2f ms above limit %.2f ms\n", percentile(total.latenciesMs, 95), opt.maxP95Ms);
+    return 1;
+  }
+  return total.errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,282 @@
+/**
+ * @file    ntripclients.cpp
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Rover load generator for the local caster of a RTK base. Connects a
+ *          number of concurrent NTRIP 1 rovers to one mount point, cuts the
+ *          received streams into RTCM frames and prints per rover throughput
+ *          and the delivery latency as JSON. The latency of a frame is the
+ *          time a rover got it after the first rover got the same frame, the
+ *          spread the fan-out of the base adds on top of the receiver.
+ * <br>
+ * @note    Host tool, build with:
+ *            g++ -std=c++11 -O2 -pthread -o ntripclients tools/ntrip/ntripclients.cpp
+ *          Run:
+ *            ./ntripclients --host rtkbase.local --clients 16 --duration 30 > result.json
+ *          Without --mount the first mount point of the sourcetable is used.
+ *          The exit code is 1 if a rover was refused or lost its stream.
+ */
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock clock_type;
+
+typedef struct {
+  std::string host;
+  std::string port;
+  std::string mount;
+  unsigned    clients;
+  unsigned    duration;     // s
+  unsigned    timeoutMs;
+} options_t;
+
+typedef struct {
+  uint64_t key;             // length and CRC of the frame
+  double   ms;              // since the start of the run
+  unsigned client;
+} arrival_t;
+
+typedef struct {
+  bool        accepted;
+  bool        lost;         // closed by the base before the end, e.g. evicted
+  std::string reply;        // first line of the reply
+  uint64_t    bytes;
+  unsigned    frames;
+  double      firstMs;
+  double      lastMs;
+  std::vector<arrival_t> arrivals;
+} rover_t;
+
+static int connectTo(const options_t& opt) {
+  struct addrinfo hints, *res = nullptr;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(opt.host.c_str(), opt.port.c_str(), &hints, &res) != 0 || res == nullptr) return -1;
+
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if (fd >= 0) {
+    struct timeval tv;
+    tv.tv_sec = opt.timeoutMs / 1000;
+    tv.tv_usec = (opt.timeoutMs % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    if (connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(res);
+  return fd;
+}
+
+static bool sendRequest(int fd, const options_t& opt, const std::string& mount) {
+  std::string req = "GET /" + mount + " HTTP/1.0\r\nHost: " + opt.host +
+                    "\r\nUser-Agent: NTRIP ntripclients\r\n\r\n";
+  return send(fd, req.data(), req.size(), 0) == (ssize_t)req.size();
+}
+
+// First STR mount point of the sourcetable, empty if there is none
+static std::string firstMountPoint(const options_t& opt) {
+  int fd = connectTo(opt);
+  if (fd < 0 || !sendRequest(fd, opt, "")) {
+    if (fd >= 0) close(fd);
+    return std::string();
+  }
+  std::string in;
+  char buf[1024];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) in.append(buf, n);
+  close(fd);
+
+  size_t pos = in.find("STR;");
+  if (pos == std::string::npos) return std::string();
+  pos += 4;
+  return in.substr(pos, in.find(';', pos) - pos);
+}
+
+// Cuts a stream into RTCM 3 frames without a CRC check, the base only forwards checked frames
+static void takeFrames(std::string& pending, rover_t& rover, unsigned client, double ms) {
+  size_t pos = 0;
+  while (true) {
+    pos = pending.find('\xD3', pos);
+    if (pos == std::string::npos || pending.size() - pos < 3) break;
+    size_t len = 3 + ((((uint8_t)pending[pos + 1] & 0x03) << 8) | (uint8_t)pending[pos + 2]) + 3;
+    if (pending.size() - pos < len) break;
+    uint64_t key = ((uint64_t)len << 24) | ((uint64_t)(uint8_t)pending[pos + len - 3] << 16) |
+                   ((uint64_t)(uint8_t)pending[pos + len - 2] << 8) | (uint8_t)pending[pos + len - 1];
+    arrival_t a = { key, ms, client };
+    rover.arrivals.push_back(a);
+    rover.frames++;
+    pos += len;
+  }
+  pending.erase(0, (pos == std::string::npos) ? pending.size() : pos);
+}
+
+static void runRover(const options_t& opt, unsigned client, clock_type::time_point start, clock_type::time_point end, rover_t* rover) {
+  int fd = connectTo(opt);
+  if (fd < 0 || !sendRequest(fd, opt, opt.mount)) {
+    if (fd >= 0) close(fd);
+    return;
+  }
+
+  std::string header, pending;
+  char buf[2048];
+  while (clock_type::now() < end) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+    if (n <= 0) {
+      rover->lost = rover->accepted;
+      break;
+    }
+    double ms = std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+    if (!rover->accepted) {
+      header.append(buf, n);
+      size_t headerEnd = header.find("\r\n\r\n");
+      if (headerEnd == std::string::npos) continue;
+      rover->reply = header.substr(0, header.find("\r\n"));
+      if (rover->reply != "ICY 200 OK") break;
+      rover->accepted = true;
+      rover->firstMs = ms;
+      pending = header.substr(headerEnd + 4);
+      rover->bytes += pending.size();
+    } else {
+      pending.append(buf, n);
+      rover->bytes += n;
+    }
+    rover->lastMs = ms;
+    takeFrames(pending, *rover, client, ms);
+  }
+  close(fd);
+}
+
+static double percentile(std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0.0;
+  size_t idx = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+static bool byKeyAndTime(const arrival_t& a, const arrival_t& b) {
+  return (a.key != b.key) ? a.key < b.key : a.ms < b.ms;
+}
+
+// The receiver repeats some frames byte by byte (e.g. 1005), copies within
+// this window are one frame, repeats are seconds apart
+static const double SAME_FRAME_MS = 500.0;
+
+static void usage() {
+  fprintf(stderr, "usage: ntripclients --host <host> [--port 2101] [--mount name]\n"
+                  "                    [--clients 16] [--duration 10] [--timeout-ms 5000]\n");
+}
+
+int main(int argc, char** argv) {
+  options_t opt;
+  opt.port = "2101";
+  opt.clients = 16;
+  opt.duration = 10;
+  opt.timeoutMs = 5000;
+
+  // Options come in pairs, a lone --help or a flag without its value is an error
+  if (argc % 2 == 0) {
+    usage();
+    return 2;
+  }
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i];
+    std::string val = argv[i + 1];
+    if (key == "--host") opt.host = val;
+    else if (key == "--port") opt.port = val;
+    else if (key == "--mount") opt.mount = val;
+    else if (key == "--clients") opt.clients = std::max(1, atoi(val.c_str()));
+    else if (key == "--duration") opt.duration = atoi(val.c_str());
+    else if (key == "--timeout-ms") opt.timeoutMs = atoi(val.c_str());
+    else { usage(); return 2; }
+  }
+  if (opt.host.empty()) {
+    usage();
+    return 2;
+  }
+  if (opt.mount.empty()) opt.mount = firstMountPoint(opt);
+  if (opt.mount.empty()) {
+    fprintf(stderr, "no mount point in the sourcetable of %s:%s\n", opt.host.c_str(), opt.port.c_str());
+    return 1;
+  }
+
+  std::vector<rover_t> rovers(opt.clients);
+  for (size_t i = 0; i < rovers.size(); i++) {
+    rovers[i].accepted = false;
+    rovers[i].lost = false;
+    rovers[i].bytes = 0;
+    rovers[i].frames = 0;
+    rovers[i].firstMs = 0.0;
+    rovers[i].lastMs = 0.0;
+  }
+  clock_type::time_point start = clock_type::now();
+  clock_type::time_point end = start + std::chrono::seconds(opt.duration);
+
+  std::vector<std::thread> threads;
+  for (unsigned c = 0; c < opt.clients; c++) {
+    threads.push_back(std::thread(runRover, std::cref(opt), c, start, end, &rovers[c]));
+  }
+  for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+  double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+  // Latency: behind the first rover that got the same frame
+  std::vector<arrival_t> all;
+  for (size_t i = 0; i < rovers.size(); i++) all.insert(all.end(), rovers[i].arrivals.begin(), rovers[i].arrivals.end());
+  std::sort(all.begin(), all.end(), byKeyAndTime);
+  std::vector<double> latencies;
+  for (size_t i = 0, first = 0; i < all.size(); i++) {
+    if (all[i].key != all[first].key || all[i].ms - all[first].ms > SAME_FRAME_MS) first = i;
+    latencies.push_back(all[i].ms - all[first].ms);
+  }
+  std::sort(latencies.begin(), latencies.end());
+
+  unsigned accepted = 0, lost = 0, refused = 0;
+  uint64_t bytes = 0;
+  std::vector<double> rates;
+  for (size_t i = 0; i < rovers.size(); i++) {
+    const rover_t& r = rovers[i];
+    if (!r.accepted) refused++;
+    if (r.lost) lost++;
+    if (!r.accepted) continue;
+    accepted++;
+    bytes += r.bytes;
+    double active = (r.lastMs > r.firstMs) ? (r.lastMs - r.firstMs) / 1000.0 : 0.0;
+    rates.push_back(active > 0.0 ? r.bytes / active : 0.0);
+  }
+  std::sort(rates.begin(), rates.end());
+
+  printf("{\n  \"host\": \"%s\", \"mount\": \"%s\", \"clients\": %u, \"seconds\": %.2f,\n",
+         opt.host.c_str(), opt.mount.c_str(), opt.clients, seconds);
+  printf("  \"accepted\": %u, \"refused\": %u, \"lost\": %u, \"frames\": %zu, \"bytes\": %llu,\n",
+         accepted, refused, lost, all.size(), (unsigned long long)bytes);
+  printf("  \"throughput_bps\": {\"total\": %.1f, \"min_rover\": %.1f, \"p50_rover\": %.1f},\n",
+         seconds > 0 ? bytes / seconds : 0.0, rates.empty() ? 0.0 : rates.front(), percentile(rates, 50));
+  printf("  \"latency_ms\": {\"p50\": %.2f, \"p95\": %.2f, \"p99\": %.2f, \"max\": %.2f},\n",
+         percentile(latencies, 50), percentile(latencies, 95), percentile(latencies, 99),
+         latencies.empty() ? 0.0 : latencies.back());
+  printf("  \"rovers\": [\n");
+  for (size_t i = 0; i < rovers.size(); i++) {
+    const rover_t& r = rovers[i];
+    printf("    {\"reply\": \"%s\", \"frames\": %u, \"bytes\": %llu, \"lost\": %s}%s\n", r.reply.c_str(), r.frames,
+           (unsigned long long)r.bytes, r.lost ? "true" : "false", (i + 1 == rovers.size()) ? "" : ",");
+  }
+  printf("  ]\n}\n");
+  return (refused > 0 || lost > 0) ? 1 : 0;
+}
@@ -0,0 +1,258 @@
+/**
+ * @file    rtkreplay.cpp
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Replays a recording of /api/recording into the forwarding pipeline
+ *          of a base, at the recorded pace or as fast as possible. The frames
+ *          are written to a serial port wired to GNSS_RX_PIN in place of the
+ *          receiver, to a TCP port (e.g. a serial bridge) or to stdout. RTCM
+ *          frames are CRC checked, throughput and pacing are printed as JSON.
+ * <br>
+ * @note    Host tool, build with:
+ *            g++ -std=c++11 -O2 -Isrc -o rtkreplay tools/replay/rtkreplay.cpp
+ *          Run:
+ *            curl -o rec.rtks "http://rtkbase.local/api/recording?from=600000&to=660000"
+ *            ./rtkreplay --in rec.rtks --out /dev/ttyUSB0 --baud 115200 --speed 1
+ *            ./rtkreplay --in rec.rtks --out 192.168.1.20:4000 --speed max
+ *          The exit code is 1 if the recording is damaged.
+ */
+
+#include <RecordFormat.h>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock clock_type;
+
+typedef struct {
+  std::string in;
+  std::string out;
+  unsigned    baud;
+  double      speed;        // 0 as fast as possible
+} options_t;
+
+typedef struct {
+  unsigned records;
+  unsigned rtcm;
+  unsigned ubx;
+  unsigned crcErrors;
+  unsigned resets;          // the recorded time started over, a reboot of the base
+  uint64_t bytes;           // written to the output
+  double   recordedMs;      // span of the recording
+  double   maxLateMs;       // behind the recorded pace
+} replay_t;
+
+static uint32_t crc24q(const uint8_t* data, size_t len) {
+  uint32_t crc = 0;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint32_t)data[i] << 16;
+    for (int b = 0; b < 8; b++) {
+      crc <<= 1;
+      if (crc & 0x1000000) crc ^= 0x1864CFB;
+    }
+  }
+  return crc & 0xFFFFFF;
+}
+
+static bool rtcmValid(const uint8_t* data, size_t len) {
+  if (len < 6 || data[0] != 0xD3 || (size_t)(((data[1] & 0x03) << 8) | data[2]) + 6 != len) return false;
+  uint32_t crc = ((uint32_t)data[len - 3] << 16) | ((uint32_t)data[len - 2] << 8) | data[len - 1];
+  return crc24q(data, len - 3) == crc;
+}
+
+static speed_t baudConstant(unsigned baud) {
+  switch (baud) {
+    case 9600:   return B9600;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default:     return B115200;
+  }
+}
+
+// "-" stdout, "<host>:<port>" TCP, anything else a file or serial port
+static int openOutput(const options_t& opt) {
+  if (opt.out == "-") return STDOUT_FILENO;
+
+  size_t colon = opt.out.rfind(':');
+  if (opt.out[0] != '/' && colon != std::string::npos) {
+    struct addrinfo hints, *res = nullptr;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    std::string host = opt.out.substr(0, colon);
+    std::string port = opt.out.substr(colon + 1);
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0 || res == nullptr) return -1;
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+      close(fd);
+      fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+  }
+
+  int fd = open(opt.out.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, 0644);
+  struct termios tty;
+  if (fd >= 0 && isatty(fd) && tcgetattr(fd, &tty) == 0) {
+    cfmakeraw(&tty);
+    cfsetospeed(&tty, baudConstant(opt.baud));
+    cfsetispeed(&tty, baudConstant(opt.baud));
+    tcsetattr(fd, TCSANOW, &tty);
+  }
+  return fd;
+}
+
+static bool writeAll(int fd, const uint8_t* data, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, data, len);
+    if (n <= 0) return false;
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+static std::vector<uint8_t> readFile(const std::string& path) {
+  std::vector<uint8_t> data;
+  FILE* f = fopen(path.c_str(), "rb");
+  if (f == nullptr) return data;
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+  fclose(f);
+  return data;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: rtkreplay --in <recording.rtks> [--out -|<host>:<port>|<tty or file>]\n"
+                  "                 [--baud 115200] [--speed 1|<factor>|max]\n");
+}
+
+int main(int argc, char** argv) {
+  options_t opt;
+  opt.out = "-";
+  opt.baud = 115200;
+  opt.speed = 1.0;
+
+  // Options come in pairs, a lone --help or a flag without its value is an error
+  if (argc % 2 == 0) {
+    usage();
+    return 2;
+  }
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i];
+    std::string val = argv[i + 1];
+    if (key == "--in") opt.in = val;
+    else if (key == "--out") opt.out = val;
+    else if (key == "--baud") opt.baud = atoi(val.c_str());
+    else if (key == "--speed") opt.speed = (val == "max") ? 0.0 : atof(val.c_str());
+    else { usage(); return 2; }
+  }
+  if (opt.in.empty() || opt.speed < 0.0) {
+    usage();
+    return 2;
+  }
+
+  std::vector<uint8_t> rec = readFile(opt.in);
+  record_stream_header_t header;
+  if (rec.size() < sizeof(header)) {
+    fprintf(stderr, "%s is not a recording\n", opt.in.c_str());
+    return 1;
+  }
+  memcpy(&header, rec.data(), sizeof(header));
+  if (header.magic != RECORD_STREAM_MAGIC || header.version != RECORD_VERSION) {
+    fprintf(stderr, "%s is not a recording of version %u\n", opt.in.c_str(), RECORD_VERSION);
+    return 1;
+  }
+  int out = openOutput(opt);
+  if (out < 0) {
+    fprintf(stderr, "can not open %s\n", opt.out.c_str());
+    return 1;
+  }
+  // The report goes to stdout unless the frames do
+  FILE* report = (out == STDOUT_FILENO) ? stderr : stdout;
+
+  replay_t r;
+  memset(&r, 0, sizeof(r));
+  bool damaged = false;
+  clock_type::time_point start = clock_type::now();
+  clock_type::time_point base = start;
+  uint32_t firstMs = 0, lastMs = 0;
+
+  size_t pos = sizeof(header);
+  while (pos < rec.size()) {
+    record_header_t h;
+    if (rec.size() - pos < sizeof(h)) {
+      damaged = true;
+      break;
+    }
+    memcpy(&h, rec.data() + pos, sizeof(h));
+    const uint8_t* data = rec.data() + pos + sizeof(h);
+    if (rec.size() - pos - sizeof(h) < h.len) {
+      damaged = true;
+      break;
+    }
+    pos += sizeof(h) + h.len;
+
+    // A time before the last one is a reboot of the base, pace from there on
+    if (r.records == 0 || h.timeMs < lastMs) {
+      if (r.records > 0) {
+        r.resets++;
+        r.recordedMs += lastMs - firstMs;
+      }
+      firstMs = h.timeMs;
+      base = clock_type::now();
+    }
+    lastMs = h.timeMs;
+    r.records++;
+
+    if (h.kind == RECORD_KIND_RTCM) {
+      r.rtcm++;
+      if (!rtcmValid(data, h.len)) {
+        r.crcErrors++;
+        continue;
+      }
+    } else if (h.kind == RECORD_KIND_UBX) {
+      r.ubx++;
+    }
+
+    if (opt.speed > 0.0) {
+      clock_type::time_point due = base + std::chrono::microseconds((int64_t)((h.timeMs - firstMs) * 1000.0 / opt.speed));
+      clock_type::time_point now = clock_type::now();
+      if (due > now) std::this_thread::sleep_until(due);
+      else r.maxLateMs = std::max(r.maxLateMs, std::chrono::duration<double, std::milli>(now - due).count());
+    }
+    if (!writeAll(out, data, h.len)) {
+      fprintf(stderr, "writing to %s failed\n", opt.out.c_str());
+      return 1;
+    }
+    r.bytes += h.len;
+  }
+  if (r.records > 0) r.recordedMs += lastMs - firstMs;
+  if (out != STDOUT_FILENO) close(out);
+  double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+  fprintf(report, "{\n  \"in\": \"%s\", \"out\": \"%s\", \"speed\": %.2f, \"seconds\": %.3f, \"recorded_s\": %.3f,\n",
+          opt.in.c_str(), opt.out.c_str(), opt.speed, seconds, r.recordedMs / 1000.0);
+  fprintf(report, "  \"records\": %u, \"rtcm\": %u, \"ubx\": %u, \"crc_errors\": %u, \"resets\": %u, \"damaged\": %s,\n",
+          r.records, r.rtcm, r.ubx, r.crcErrors, r.resets, damaged ? "true" : "false");
+  fprintf(report, "  \"bytes\": %llu, \"throughput_bps\": %.1f, \"max_late_ms\": %.2f\n}\n",
+          (unsigned long long)r.bytes, seconds > 0 ? r.bytes / seconds : 0.0, r.maxLateMs);
+  return (damaged || r.crcErrors > 0) ? 1 : 0;
+}
@@ -0,0 +1,236 @@
+/**
+ * @file    uartbench.cpp
+ * @author  jangleboom
+ * @link    https://github.com/audio-communication-group/rwaht_esp_wifi_manager
+ * <br>
+ * @brief   Checks the burst batching of GnssUart.h against a pseudo terminal.
+ *          A writer thread sends epochs of RTCM frames to the master side at
+ *          the pace of --baud, in small chunks like a FIFO drained by the
+ *          interrupt, with --gap-ms of silence between the epochs. The reader
+ *          waits on the slave side and ends a burst after --idle-ms without a
+ *          byte, like the RX timeout of the UART driver, and counts with the
+ *          accounting of UartBurst.h. Every epoch has to come out as one whole
+ *          burst. With --tty the bursts of a real receiver are measured instead.
+ * <br>
+ * @note    Host tool, build with:
+ *            g++ -std=c++11 -O2 -pthread -Isrc -o uartbench tools/uartbench/uartbench.cpp
+ *          Run:
+ *            ./uartbench --baud 921600 --epochs 200 --gap-ms 100 --idle-ms 20
+ *            ./uartbench --tty /dev/ttyUSB0 --baud 921600 --seconds 30
+ *          The exit code is 1 if an epoch was not delivered as one burst.
+ */
+
+#include <UartBurst.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock clock_type;
+
+typedef struct {
+  std::string tty;          // empty: pseudo terminal with the writer thread
+  unsigned    baud;
+  unsigned    epochs;
+  unsigned    gapMs;        // silence between two epochs
+  unsigned    idleMs;       // ends a burst
+  unsigned    chunk;        // bytes per write
+  unsigned    burstLen;     // like GNSS_UART_BURST_LEN
+  unsigned    seconds;      // --tty only
+} options_t;
+
+static uint32_t crc24q(const uint8_t* data, size_t len) {
+  uint32_t crc = 0;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint32_t)data[i] << 16;
+    for (int b = 0; b < 8; b++) {
+      crc <<= 1;
+      if (crc & 0x1000000) crc ^= 0x1864CFB;
+    }
+  }
+  return crc & 0xFFFFFF;
+}
+
+static void appendFrame(std::vector<uint8_t>& out, uint16_t type, uint16_t payloadLen) {
+  size_t start = out.size();
+  out.push_back(0xD3);
+  out.push_back(payloadLen >> 8);
+  out.push_back(payloadLen & 0xFF);
+  out.push_back(type >> 4);
+  out.push_back((type & 0x0F) << 4);
+  for (uint16_t i = 2; i < payloadLen; i++) out.push_back((uint8_t)rand());
+  uint32_t crc = crc24q(out.data() + start, out.size() - start);
+  out.push_back(crc >> 16);
+  out.push_back(crc >> 8);
+  out.push_back(crc);
+}
+
+// MSM7 of four constellations, 1005 and 1230 every tenth epoch
+static std::vector<std::vector<uint8_t> > buildEpochs(unsigned count) {
+  std::vector<std::vector<uint8_t> > epochs(count);
+  srand(1);
+  for (unsigned e = 0; e < count; e++) {
+    if (e % 10 == 0) {
+      appendFrame(epochs[e], 1005, 19);
+      appendFrame(epochs[e], 1230, 8);
+    }
+    const uint16_t types[] = { 1077, 1087, 1097, 1127 };
+    for (uint16_t type : types) appendFrame(epochs[e], type, 250 + rand() % 300);
+  }
+  return epochs;
+}
+
+static speed_t baudConstant(unsigned baud) {
+  switch (baud) {
+    case 9600:   return B9600;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default:     return B115200;
+  }
+}
+
+static bool makeRaw(int fd, unsigned baud) {
+  struct termios tty;
+  if (tcgetattr(fd, &tty) != 0) return false;
+  cfmakeraw(&tty);
+  cfsetospeed(&tty, baudConstant(baud));
+  cfsetispeed(&tty, baudConstant(baud));
+  return tcsetattr(fd, TCSANOW, &tty) == 0;
+}
+
+// Chunks at the serial pace, 10 bits per byte
+static void writeEpochs(int fd, const std::vector<std::vector<uint8_t> >& epochs, const options_t& opt) {
+  clock_type::time_point due = clock_type::now();
+  for (const std::vector<uint8_t>& epoch : epochs) {
+    for (size_t pos = 0; pos < epoch.size(); ) {
+      size_t n = std::min<size_t>(opt.chunk, epoch.size() - pos);
+      std::this_thread::sleep_until(due);
+      ssize_t written = write(fd, epoch.data() + pos, n);
+      if (written <= 0) return;
+      pos += written;
+      due += std::chrono::microseconds((uint64_t)written * 10 * 1000000 / opt.baud);
+    }
+    due += std::chrono::milliseconds(opt.gapMs);
+  }
+}
+
+static void usage() {
+  fprintf(stderr, "usage: uartbench [--baud 921600] [--epochs 200] [--gap-ms 100] [--idle-ms 20]\n"
+                  "                 [--chunk 120] [--burst-len 4096] [--tty <port> --seconds 30]\n");
+}
+
+int main(int argc, char** argv) {
+  options_t opt;
+  opt.baud = 921600;
+  opt.epochs = 200;
+  opt.gapMs = 100;
+  opt.idleMs = 20;        // the sleeps of the host overshoot by milliseconds, the UART driver does not
+  opt.chunk = 120;
+  opt.burstLen = 4096;
+  opt.seconds = 30;
+
+  // Options come in pairs, a lone --help or a flag without its value is an error
+  if (argc % 2 == 0) {
+    usage();
+    return 2;
+  }
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i];
+    unsigned val = atoi(argv[i + 1]);
+    if (key == "--tty") opt.tty = argv[i + 1];
+    else if (key == "--baud") opt.baud = val;
+    else if (key == "--epochs") opt.epochs = val;
+    else if (key == "--gap-ms") opt.gapMs = val;
+    else if (key == "--idle-ms") opt.idleMs = val;
+    else if (key == "--chunk") opt.chunk = val;
+    else if (key == "--burst-len") opt.burstLen = val;
+    else if (key == "--seconds") opt.seconds = val;
+    else { usage(); return 2; }
+  }
+  if (opt.baud == 0 || opt.chunk == 0 || opt.burstLen == 0 || opt.idleMs == 0 || opt.idleMs >= opt.gapMs) {
+    usage();
+    return 2;
+  }
+
+  int master = -1, port = -1;
+  if (opt.tty.empty()) {
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+      fprintf(stderr, "no pseudo terminal\n");
+      return 1;
+    }
+    port = open(ptsname(master), O_RDONLY | O_NOCTTY);
+  } else {
+    port = open(opt.tty.c_str(), O_RDONLY | O_NOCTTY);
+  }
+  if (port < 0 || !makeRaw(port, opt.baud) || (master >= 0 && !makeRaw(master, opt.baud))) {
+    fprintf(stderr, "can not open the port\n");
+    return 1;
+  }
+
+  std::vector<std::vector<uint8_t> > epochs;
+  std::thread writer;
+  if (master >= 0) {
+    epochs = buildEpochs(opt.epochs);
+    writer = std::thread(writeEpochs, master, std::cref(epochs), std::cref(opt));
+  }
+
+  uart_burst_stats_t stats;
+  memset(&stats, 0, sizeof(stats));
+  std::vector<uint8_t> burst;
+  burst.reserve(opt.burstLen);
+  unsigned whole = 0, mismatched = 0, reads = 0;
+  size_t next = 0;          // epoch the next burst has to match
+  clock_type::time_point start = clock_type::now();
+  clock_type::time_point end = start + std::chrono::seconds(opt.seconds);
+
+  struct pollfd pfd = { port, POLLIN, 0 };
+  while (true) {
+    int ready = poll(&pfd, 1, opt.idleMs);
+    bool idle = ready == 0;
+    if (ready > 0) {
+      uint8_t buf[1024];
+      size_t room = opt.burstLen - burst.size();
+      ssize_t n = read(port, buf, std::min(room, sizeof(buf)));
+      if (n <= 0) break;
+      reads++;
+      burst.insert(burst.end(), buf, buf + n);
+    }
+    if ((idle && !burst.empty()) || burst.size() == opt.burstLen) {
+      countBurst(&stats, burst.size(), idle);
+      if (master >= 0) {
+        if (idle && next < epochs.size() && burst == epochs[next]) whole++;
+        else mismatched++;
+        if (idle) next++;
+      }
+      burst.clear();
+    }
+    if (master >= 0 ? (idle && next >= epochs.size()) : clock_type::now() >= end) break;
+  }
+  if (writer.joinable()) writer.join();
+  double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+  printf("{\n  \"port\": \"%s\", \"baud\": %u, \"idle_ms\": %u, \"burst_len\": %u, \"seconds\": %.3f,\n",
+         opt.tty.empty() ? "pty" : opt.tty.c_str(), opt.baud, opt.idleMs, opt.burstLen, seconds);
+  printf("  \"epochs\": %u, \"whole\": %u, \"mismatched\": %u, \"reads\": %u,\n",
+         (unsigned)epochs.size(), whole, mismatched, reads);
+  printf("  \"bursts\": %u, \"bytes\": %u, \"max_burst\": %u, \"split_bursts\": %u, \"bytes_per_burst\": %.1f,\n",
+         stats.bursts, stats.bytes, stats.maxBurst, stats.splits, stats.bursts ? (double)stats.bytes / stats.bursts : 0.0);
+  printf("  \"burst_sizes\": [");
+  for (int i = 0; i < UART_BURST_BUCKETS; i++) printf("%s%u", i ? ", " : "", stats.sizes[i]);
+  printf("]\n}\n");
+  return (master >= 0 && whole != epochs.size()) ? 1 : 0;
+}